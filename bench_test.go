@@ -0,0 +1,422 @@
+package hashive_test
+
+import (
+	"bytes"
+	"flag"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"sync/atomic"
+	"testing"
+
+	"github.com/mkch/hashive"
+)
+
+// The 50M keys datasets take tens of GB of disk and a long time to build,
+// run them with:
+//
+//	go test -run ^$ -bench . -hashive.huge
+var benchHuge = flag.Bool("hashive.huge", false, "run the benchmarks of huge datasets")
+
+// benchDataset is a synthetic database of keys mapped to short strings.
+type benchDataset struct {
+	keys   int
+	keyLen int
+	huge   bool
+}
+
+func (ds benchDataset) String() string {
+	return fmt.Sprintf("keys=%v/len=%v", benchCount(ds.keys), ds.keyLen)
+}
+
+func benchCount(n int) string {
+	switch {
+	case n >= 1_000_000 && n%1_000_000 == 0:
+		return strconv.Itoa(n/1_000_000) + "M"
+	case n >= 1000 && n%1000 == 0:
+		return strconv.Itoa(n/1000) + "K"
+	default:
+		return strconv.Itoa(n)
+	}
+}
+
+var benchDatasets = []benchDataset{
+	{keys: 1000, keyLen: 16},
+	{keys: 1_000_000, keyLen: 8},
+	{keys: 1_000_000, keyLen: 16},
+	{keys: 1_000_000, keyLen: 100}, // URL-like keys.
+	{keys: 50_000_000, keyLen: 16, huge: true},
+}
+
+// benchKey returns the i-th key of length keyLen.
+// Keys of length 100 look like URLs, so they share a long prefix.
+func benchKey(i, keyLen int) string {
+	hex := fmt.Sprintf("%0*x", min(keyLen, 16), i)
+	if keyLen <= len(hex) {
+		return hex
+	}
+	const prefix = "https://example.com/"
+	return prefix + strings.Repeat("p", keyLen-len(prefix)-len(hex)) + hex
+}
+
+// benchIndex returns the i-th index of a pseudo-random walk of n keys,
+// so consecutive queries don't hit the same pages.
+func benchIndex(i, n int) int {
+	return int(uint64(i) * 2654435761 % uint64(n))
+}
+
+// benchQueries is the number of keys queried in turn by a benchmark.
+// The keys are generated beforehand, so the generation is not measured.
+const benchQueries = 1 << 14
+
+// queryKeys returns the keys to query, hit percent of which are in the dataset.
+func (ds benchDataset) queryKeys(hit int) []string {
+	keys := make([]string, benchQueries)
+	for i := range keys {
+		j := benchIndex(i, ds.keys)
+		if i%100 >= hit {
+			j += ds.keys // The keys beyond ds.keys are misses.
+		}
+		keys[i] = benchKey(j, ds.keyLen)
+	}
+	return keys
+}
+
+// build writes the dataset to a file in dir with opts and returns the file name.
+func (ds benchDataset) build(b *testing.B, dir string, opts ...hashive.WriteOption) string {
+	filename := filepath.Join(dir, "bench.hashive")
+	f, err := os.Create(filename)
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer f.Close()
+	builder, err := hashive.NewBuilder(f, dir, append(opts, hashive.WithWorkers(0))...)
+	if err != nil {
+		b.Fatal(err)
+	}
+	for i := range ds.keys {
+		if err := builder.Add(benchKey(i, ds.keyLen), "value "+strconv.Itoa(i)); err != nil {
+			b.Fatal(err)
+		}
+	}
+	if err := builder.Finish(); err != nil {
+		b.Fatal(err)
+	}
+	return filename
+}
+
+// benchSources opens filename with every read path.
+func benchSources(b *testing.B, filename string) map[string]*hashive.Hashive {
+	h, closeMmap, err := hashive.OpenMmap(filename)
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { closeMmap() })
+	f, err := os.Open(filename)
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.Cleanup(func() { f.Close() })
+	hf, err := hashive.NewReaderAt(f, -1)
+	if err != nil {
+		b.Fatal(err)
+	}
+	// Reads the file through a block cache of the whole file, as a remote storage warmed up.
+	hb, err := hashive.NewReaderAt(hashive.NewBlockCache(f, 0, 1<<30), -1)
+	if err != nil {
+		b.Fatal(err)
+	}
+	return map[string]*hashive.Hashive{"mmap": h, "file": hf, "blockcache": hb}
+}
+
+// BenchmarkQuery queries string values by key,
+// with all hits, all misses and 90% hits.
+func BenchmarkQuery(b *testing.B) {
+	for _, ds := range benchDatasets {
+		b.Run(ds.String(), func(b *testing.B) {
+			if ds.huge && !*benchHuge {
+				b.Skip("huge dataset, see -hashive.huge")
+			}
+			sources := benchSources(b, ds.build(b, b.TempDir()))
+			for _, source := range []string{"mmap", "file", "blockcache"} {
+				h := sources[source]
+				for _, hit := range []int{100, 0, 90} {
+					keys := ds.queryKeys(hit)
+					b.Run(fmt.Sprintf("%v/hit=%v%%", source, hit), func(b *testing.B) {
+						b.ReportAllocs()
+						for i := range b.N {
+							if _, err := h.QueryString(keys[i%len(keys)]); err != nil && err != hashive.ErrNotFound {
+								b.Fatal(err)
+							}
+						}
+					})
+				}
+				keys := ds.queryKeys(100)
+				b.Run(source+"/parallel", func(b *testing.B) {
+					b.ReportAllocs()
+					b.RunParallel(func(pb *testing.PB) {
+						for i := 0; pb.Next(); i++ {
+							if _, err := h.QueryString(keys[i%len(keys)]); err != nil {
+								// FailNow must not be called from the goroutines of RunParallel.
+								b.Error(err)
+								return
+							}
+						}
+					})
+				})
+			}
+		})
+	}
+}
+
+// BenchmarkQueryLayout queries string values by key in the object layouts.
+func BenchmarkQueryLayout(b *testing.B) {
+	ds := benchDataset{keys: 1_000_000, keyLen: 16}
+	keys := ds.queryKeys(90)
+	for _, layout := range []struct {
+		name string
+		opts []hashive.WriteOption
+	}{
+		{"chained", nil},
+		{"mph", []hashive.WriteOption{hashive.WithMinimalPerfectHash()}},
+		{"aligned", []hashive.WriteOption{hashive.WithAlignedLayout()}},
+		{"inline", []hashive.WriteOption{hashive.WithInlineKeys(ds.keyLen)}},
+		{"pow2", []hashive.WriteOption{hashive.WithPowerOfTwoBuckets()}},
+		{"filter", []hashive.WriteOption{hashive.WithFilter()}},
+	} {
+		b.Run(layout.name, func(b *testing.B) {
+			h := benchSources(b, ds.build(b, b.TempDir(), layout.opts...))["mmap"]
+			b.ResetTimer()
+			b.ReportAllocs()
+			for i := range b.N {
+				if _, err := h.QueryString(keys[i%len(keys)]); err != nil && err != hashive.ErrNotFound {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+type benchGob struct {
+	Name  string
+	Score float64
+}
+
+// BenchmarkQueryPath queries nested values, array elements, gob values
+// and decodes entire objects.
+func BenchmarkQueryPath(b *testing.B) {
+	const users = 100_000
+	const arrayLen = 100_000
+	userMap := make(map[string]any, users)
+	for i := range users {
+		userMap[benchKey(i, 16)] = map[string]any{
+			"name": "user " + strconv.Itoa(i),
+			"tags": []any{"a", "b", int64(i)},
+			"gob":  benchGob{"user", float64(i)},
+		}
+	}
+	array := make([]any, arrayLen)
+	for i := range array {
+		array[i] = int64(i)
+	}
+	filename := filepath.Join(b.TempDir(), "bench.hashive")
+	if err := hashive.WriteFile(filename, map[string]any{"users": userMap, "array": array}, hashive.WithWorkers(0)); err != nil {
+		b.Fatal(err)
+	}
+	sources := benchSources(b, filename)
+	keys := benchDataset{keys: users, keyLen: 16}.queryKeys(100)
+	indexes := make([]string, benchQueries)
+	for i := range indexes {
+		indexes[i] = strconv.Itoa(benchIndex(i, arrayLen))
+	}
+
+	for _, source := range []string{"mmap", "file"} {
+		h := sources[source]
+		b.Run(source+"/nested", func(b *testing.B) {
+			b.ReportAllocs()
+			for i := range b.N {
+				if _, err := h.QueryInt("users", keys[i%len(keys)], "tags", "2"); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		b.Run(source+"/array", func(b *testing.B) {
+			b.ReportAllocs()
+			for i := range b.N {
+				if _, err := h.QueryInt("array", indexes[i%len(indexes)]); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		b.Run(source+"/gob", func(b *testing.B) {
+			b.ReportAllocs()
+			var v benchGob
+			for i := range b.N {
+				if err := h.QueryGob(&v, "users", keys[i%len(keys)], "gob"); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		b.Run(source+"/decode", func(b *testing.B) {
+			b.ReportAllocs()
+			for i := range b.N {
+				if _, err := h.Query("users", keys[i%len(keys)]); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+// BenchmarkQueryStruct queries struct values encoded by gob and the struct codec.
+func BenchmarkQueryStruct(b *testing.B) {
+	const users = 100_000
+	value := make(map[string]any, users)
+	for i := range users {
+		value[benchKey(i, 16)] = benchGob{"user " + strconv.Itoa(i), float64(i)}
+	}
+	codec, err := hashive.NewStructCodec(benchGob{})
+	if err != nil {
+		b.Fatal(err)
+	}
+	keys := benchDataset{keys: users, keyLen: 16}.queryKeys(100)
+	for name, opts := range map[string][]hashive.WriteOption{
+		"gob":    nil,
+		"struct": {hashive.WithCodec(codec)},
+	} {
+		var buf bytes.Buffer
+		if err := hashive.Write(&buf, value, opts...); err != nil {
+			b.Fatal(err)
+		}
+		h, err := hashive.NewFromBytes(buf.Bytes())
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.Run(name, func(b *testing.B) {
+			b.ReportAllocs()
+			var v benchGob
+			for i := range b.N {
+				if err := h.QueryGob(&v, keys[i%len(keys)]); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+// BenchmarkExport exports all the entries of the root object with [hashive.Hashive.Export],
+// compared with decoding the root object by Query.
+func BenchmarkExport(b *testing.B) {
+	ds := benchDataset{keys: 1_000_000, keyLen: 16}
+	h := benchSources(b, ds.build(b, b.TempDir()))["mmap"]
+	b.Run("query", func(b *testing.B) {
+		b.ReportAllocs()
+		for range b.N {
+			if _, err := h.Query(); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	for _, workers := range []int{1, 0} {
+		b.Run(fmt.Sprintf("export/workers=%v", workers), func(b *testing.B) {
+			b.ReportAllocs()
+			for range b.N {
+				var rows atomic.Int64
+				if err := h.Export(0, workers, func(batch *hashive.RecordBatch) error {
+					rows.Add(int64(batch.Len()))
+					return nil
+				}); err != nil {
+					b.Fatal(err)
+				}
+				if rows.Load() != int64(ds.keys) {
+					b.Fatal(rows.Load())
+				}
+			}
+		})
+	}
+}
+
+// BenchmarkOpenQuery opens the database and queries one key every iteration,
+// which is the cost of a query on a cold handle.
+// For a cold page cache, drop the caches of the OS before running, e.g.
+//
+//	sync; echo 3 > /proc/sys/vm/drop_caches
+//
+// and run the benchmark with -benchtime=1x.
+func BenchmarkOpenQuery(b *testing.B) {
+	ds := benchDataset{keys: 1_000_000, keyLen: 16}
+	filename := ds.build(b, b.TempDir())
+	keys := ds.queryKeys(100)
+	open := map[string]func() (*hashive.Hashive, func() error, error){
+		"mmap": func() (*hashive.Hashive, func() error, error) { return hashive.OpenMmap(filename) },
+		"file": func() (*hashive.Hashive, func() error, error) { return hashive.Open(filename, -1) },
+	}
+	for _, source := range []string{"mmap", "file"} {
+		b.Run(source, func(b *testing.B) {
+			b.ReportAllocs()
+			for i := range b.N {
+				h, closeDB, err := open[source]()
+				if err != nil {
+					b.Fatal(err)
+				}
+				if _, err := h.QueryString(keys[i%len(keys)]); err != nil {
+					b.Fatal(err)
+				}
+				closeDB()
+			}
+		})
+	}
+}
+
+// BenchmarkWrite writes databases of string values.
+func BenchmarkWrite(b *testing.B) {
+	for _, keys := range []int{1000, 100_000, 1_000_000} {
+		keyList := make([]string, keys)
+		value := make(map[string]any, keys)
+		for i := range keys {
+			keyList[i] = benchKey(i, 16)
+			value[keyList[i]] = "value " + strconv.Itoa(i)
+		}
+		b.Run("keys="+benchCount(keys), func(b *testing.B) {
+			for name, opts := range map[string][]hashive.WriteOption{
+				"serial":   nil,
+				"parallel": {hashive.WithWorkers(0)},
+				"mph":      {hashive.WithMinimalPerfectHash()},
+				"pow2":     {hashive.WithPowerOfTwoBuckets()},
+			} {
+				b.Run(name, func(b *testing.B) {
+					b.ReportAllocs()
+					var buf bytes.Buffer
+					for range b.N {
+						buf.Reset()
+						if err := hashive.Write(&buf, value, opts...); err != nil {
+							b.Fatal(err)
+						}
+					}
+					b.SetBytes(int64(buf.Len()))
+				})
+			}
+			b.Run("builder", func(b *testing.B) {
+				b.ReportAllocs()
+				dir := b.TempDir()
+				for range b.N {
+					builder, err := hashive.NewBuilder(io.Discard, dir)
+					if err != nil {
+						b.Fatal(err)
+					}
+					for _, k := range keyList {
+						if err := builder.Add(k, value[k]); err != nil {
+							b.Fatal(err)
+						}
+					}
+					if err := builder.Finish(); err != nil {
+						b.Fatal(err)
+					}
+				}
+			})
+		})
+	}
+}
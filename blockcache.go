@@ -0,0 +1,221 @@
+package hashive
+
+import (
+	"container/list"
+	"errors"
+	"io"
+	"sync"
+	"sync/atomic"
+)
+
+// defaultBlockSize is the block size of a [BlockCache] if not specified.
+const defaultBlockSize = 64 << 10
+
+// BlockCache is an [io.ReaderAt] that caches the content of another one
+// in aligned blocks, for storage where a read is expensive, such as
+// range requests of object storage or HTTP.
+// A read of the blocks not cached fetches every run of adjacent missing blocks
+// with one read of the underlying storage, and the least recently used blocks
+// are evicted when the cache is full.
+//
+// A database is queried in place through a BlockCache by
+//
+//	h, err := hashive.NewReaderAt(hashive.NewBlockCache(r, 0, maxBytes), -1)
+//
+// where every buffered read of the database is copied from the cached blocks,
+// or fetched with one read of the storage if they are not cached,
+// so a lookup in an object fetches at most the blocks of the offset table
+// and the blocks of the bucket, and nothing once they are cached.
+//
+// A BlockCache is safe for concurrent use if the underlying storage is.
+// Concurrent misses of the same block may fetch it more than once.
+type BlockCache struct {
+	r         io.ReaderAt
+	blockSize int
+	maxBytes  int
+
+	mu     sync.Mutex
+	blocks map[int64]*list.Element // of *cachedBlock, by block index
+	lru    list.List               // the most recently used at the front
+	bytes  int
+
+	hits, misses, fetches, bytesFetched atomic.Uint64
+}
+
+// cachedBlock is a block of a [BlockCache].
+type cachedBlock struct {
+	index int64
+	// data is the content of the block, which is shorter than the block size
+	// at the end of the storage.
+	data []byte
+}
+
+// BlockCacheStats is the statistics of a [BlockCache].
+// The hits, misses and entries of [CacheStats] are counted in blocks.
+type BlockCacheStats struct {
+	CacheStats
+	Fetches      uint64 // number of reads of the underlying storage
+	BytesFetched uint64 // number of bytes read from the underlying storage
+}
+
+// NewBlockCache returns a BlockCache of r, which caches blocks of blockSize
+// bytes in at most maxBytes of memory. If blockSize <= 0, 64 KiB is used.
+func NewBlockCache(r io.ReaderAt, blockSize, maxBytes int) *BlockCache {
+	if blockSize <= 0 {
+		blockSize = defaultBlockSize
+	}
+	return &BlockCache{
+		r:         r,
+		blockSize: blockSize,
+		maxBytes:  maxBytes,
+		blocks:    make(map[int64]*list.Element),
+	}
+}
+
+// ReadAt implements [io.ReaderAt].
+func (c *BlockCache) ReadAt(p []byte, off int64) (n int, err error) {
+	if off < 0 {
+		return 0, errors.New("negative offset")
+	}
+	blockSize := int64(c.blockSize)
+	for n < len(p) {
+		pos := off + int64(n)
+		index := pos / blockSize
+		start := int(pos - index*blockSize)
+		var m int
+		var eof bool
+		if block, ok := c.get(index); ok {
+			m, eof = c.copyBlocks(p[n:], start, block)
+		} else {
+			var blocks [][]byte
+			if blocks, err = c.fetch(index, c.missingEnd(index, (off+int64(len(p))-1)/blockSize)); err != nil {
+				return
+			}
+			m, eof = c.copyBlocks(p[n:], start, blocks...)
+		}
+		if n += m; eof {
+			return n, io.EOF
+		}
+	}
+	return
+}
+
+// copyBlocks copies the content of adjacent blocks from start of the first into p,
+// and reports whether the end of the storage is reached before p is full.
+func (c *BlockCache) copyBlocks(p []byte, start int, blocks ...[]byte) (n int, eof bool) {
+	for _, block := range blocks {
+		if start >= len(block) {
+			return n, true
+		}
+		n += copy(p[n:], block[start:])
+		if n == len(p) {
+			return
+		}
+		if len(block) < c.blockSize {
+			// The end of the storage.
+			return n, true
+		}
+		start = 0
+	}
+	return
+}
+
+// get returns the cached block of index.
+func (c *BlockCache) get(index int64) (data []byte, ok bool) {
+	c.mu.Lock()
+	elem, ok := c.blocks[index]
+	if ok {
+		c.lru.MoveToFront(elem)
+		data = elem.Value.(*cachedBlock).data
+	}
+	c.mu.Unlock()
+	if ok {
+		c.hits.Add(1)
+	}
+	return
+}
+
+// missingEnd returns the end of the run of blocks not cached from index,
+// which is at most last+1.
+func (c *BlockCache) missingEnd(index, last int64) (end int64) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for end = index + 1; end <= last; end++ {
+		if _, ok := c.blocks[end]; ok {
+			break
+		}
+	}
+	return
+}
+
+// fetch reads the blocks in [first, end) with one read of the underlying storage,
+// caches and returns them.
+// The blocks of a run are copied out of the buffer of the read, so an evicted block
+// is freed even if the other blocks of its run are still cached.
+func (c *BlockCache) fetch(first, end int64) (blocks [][]byte, err error) {
+	c.misses.Add(uint64(end - first))
+	c.fetches.Add(1)
+	buf := make([]byte, (end-first)*int64(c.blockSize))
+	n, err := c.r.ReadAt(buf, first*int64(c.blockSize))
+	c.bytesFetched.Add(uint64(n))
+	if n == 0 {
+		if err == nil {
+			err = io.EOF
+		}
+		return
+	}
+	if err != nil && err != io.EOF {
+		return nil, err
+	}
+	buf = buf[:n]
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	single := len(buf) <= c.blockSize
+	for index := first; len(buf) > 0; index++ {
+		size := min(c.blockSize, len(buf))
+		block := buf[:size:size]
+		if !single {
+			block = append([]byte(nil), block...)
+		}
+		buf = buf[size:]
+		blocks = append(blocks, block)
+		c.put(index, block)
+	}
+	return blocks, nil
+}
+
+// put caches data as the block of index. c.mu must be held.
+func (c *BlockCache) put(index int64, data []byte) {
+	if len(data) > c.maxBytes {
+		return
+	}
+	if elem, ok := c.blocks[index]; ok {
+		c.lru.MoveToFront(elem)
+		return
+	}
+	for c.bytes+len(data) > c.maxBytes {
+		elem := c.lru.Back()
+		block := elem.Value.(*cachedBlock)
+		c.lru.Remove(elem)
+		delete(c.blocks, block.index)
+		c.bytes -= len(block.data)
+	}
+	c.blocks[index] = c.lru.PushFront(&cachedBlock{index: index, data: data})
+	c.bytes += len(data)
+}
+
+// Stats returns the statistics of c.
+func (c *BlockCache) Stats() BlockCacheStats {
+	c.mu.Lock()
+	entries := len(c.blocks)
+	c.mu.Unlock()
+	return BlockCacheStats{
+		CacheStats: CacheStats{
+			Hits:    c.hits.Load(),
+			Misses:  c.misses.Load(),
+			Entries: entries,
+		},
+		Fetches:      c.fetches.Load(),
+		BytesFetched: c.bytesFetched.Load(),
+	}
+}
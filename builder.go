@@ -0,0 +1,110 @@
+package hashive
+
+import (
+	"bufio"
+	"errors"
+	"io"
+	"os"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// ErrBuilderFinished is returned when a [Builder] is used after Finish or Close.
+var ErrBuilderFinished = errors.New("builder is finished")
+
+// errBuilderStringPool is returned by [NewBuilder] with [WithStringPool].
+var errBuilderStringPool = errors.New("string pool is not supported by builder")
+
+// Builder builds a database whose root value is an object,
+// adding one key-value pair at a time.
+// Values are encoded into a temporary file as they are added,
+// so the memory used is proportional to the number and length of keys
+// instead of the size of the database.
+//
+// A Builder is not safe for concurrent use.
+type Builder struct {
+	w     io.Writer
+	opts  *impl.WriteOptions
+	spill *os.File
+	obj   *impl.ObjectBuilder
+}
+
+// NewBuilder creates a Builder that writes the database to w.
+// The temporary file is created in directory tempDir,
+// or the default directory for temporary files if tempDir is empty.
+// The encoding can be configured with opts, see [Write].
+// The returned Builder must be finished with [Builder.Finish],
+// or discarded with [Builder.Close].
+func NewBuilder(w io.Writer, tempDir string, opts ...WriteOption) (b *Builder, err error) {
+	options := newWriteOptions(opts)
+	if options.PoolStrings {
+		err = errBuilderStringPool
+		return
+	}
+	spill, err := os.CreateTemp(tempDir, "hashive-*")
+	if err != nil {
+		return
+	}
+	return &Builder{
+		w:     w,
+		opts:  options,
+		spill: spill,
+		obj:   impl.NewObjectBuilder(spill, options),
+	}, nil
+}
+
+// Len returns the number of keys added.
+func (b *Builder) Len() int {
+	if b.obj == nil {
+		return 0
+	}
+	return b.obj.Len()
+}
+
+// Add adds key and its value to the database.
+// Value is encoded as in [Write]. Keys must be unique,
+// and Finish fails if a key is added more than once.
+func (b *Builder) Add(key string, value any) (err error) {
+	if b.obj == nil {
+		return ErrBuilderFinished
+	}
+	return b.obj.Add(key, value)
+}
+
+// Finish writes the database, and removes the temporary file.
+func (b *Builder) Finish() (err error) {
+	if b.obj == nil {
+		return ErrBuilderFinished
+	}
+	defer func() {
+		if errClose := b.Close(); err == nil {
+			err = errClose
+		}
+	}()
+
+	buffered := bufio.NewWriter(b.w)
+	if _, err = buffered.WriteString(fileSignature); err != nil {
+		return
+	}
+	if err = impl.WriteHeader(buffered, int64(len(fileSignature)), b.opts.Header()); err != nil {
+		return
+	}
+	if err = b.obj.Finish(buffered); err != nil {
+		return
+	}
+	return buffered.Flush()
+}
+
+// Close discards the database being built, and removes the temporary file.
+// It does nothing if b is already finished.
+func (b *Builder) Close() (err error) {
+	if b.obj == nil {
+		return nil
+	}
+	b.obj = nil
+	err = b.spill.Close()
+	if errRemove := os.Remove(b.spill.Name()); err == nil {
+		err = errRemove
+	}
+	return
+}
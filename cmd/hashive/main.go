@@ -0,0 +1,229 @@
+// Command hashive inspects Hashive databases.
+//
+// Usage:
+//
+//	hashive stat [-largest n] file
+//	hashive bench [-mmap] [-buffer size] [-rounds n] [-sep separator] file keys
+//
+// The stat command reads the whole database and reports the layout of
+// every nesting level: the numbers of objects, keys and buckets, the load factor,
+// the histogram of the bucket list lengths, the offset sizes, and the bytes
+// spent on offset tables, keys and values. The largest values are listed after that.
+//
+// The bench command queries the database with the paths in file keys,
+// one path per line whose keys are separated by separator, a tab by default,
+// and reports the latency percentiles of the queries.
+// File keys is read from the standard input if it is "-".
+package main
+
+import (
+	"bufio"
+	"errors"
+	"flag"
+	"fmt"
+	"io"
+	"os"
+	"slices"
+	"strings"
+	"text/tabwriter"
+	"time"
+
+	"github.com/mkch/hashive"
+)
+
+func main() {
+	if err := run(os.Args[1:], os.Stdin, os.Stdout); err != nil {
+		fmt.Fprintln(os.Stderr, "hashive:", err)
+		os.Exit(1)
+	}
+}
+
+const usage = `usage:
+	hashive stat [-largest n] file
+	hashive bench [-mmap] [-buffer size] [-rounds n] [-sep separator] file keys`
+
+// run runs the command of args.
+func run(args []string, stdin io.Reader, stdout io.Writer) error {
+	if len(args) == 0 {
+		return errors.New(usage)
+	}
+	switch args[0] {
+	case "stat":
+		return stat(args[1:], stdout)
+	case "bench":
+		return bench(args[1:], stdin, stdout)
+	default:
+		return fmt.Errorf("unknown command %q\n%v", args[0], usage)
+	}
+}
+
+// newFlagSet returns a flag set of command name, which reports errors to stdout.
+func newFlagSet(name string, stdout io.Writer) *flag.FlagSet {
+	flags := flag.NewFlagSet(name, flag.ContinueOnError)
+	flags.SetOutput(stdout)
+	return flags
+}
+
+// stat runs the stat command.
+func stat(args []string, stdout io.Writer) (err error) {
+	flags := newFlagSet("stat", stdout)
+	largest := flags.Int("largest", 10, "number of the largest values to list")
+	if err = flags.Parse(args); err != nil {
+		return
+	}
+	if flags.NArg() != 1 {
+		return errors.New(usage)
+	}
+	h, closeFile, err := hashive.OpenMmap(flags.Arg(0))
+	if err != nil {
+		return
+	}
+	defer closeFile()
+	layout, err := h.Layout(*largest)
+	if err != nil {
+		return
+	}
+	printLayout(stdout, layout)
+	return
+}
+
+// printLayout prints layout to w.
+func printLayout(w io.Writer, layout *hashive.Layout) {
+	fmt.Fprintf(w, "size: %v bytes\n\n", layout.Size)
+	tw := tabwriter.NewWriter(w, 0, 8, 2, ' ', tabwriter.AlignRight)
+	fmt.Fprintln(tw, "level\tobjects\tkeys\tbuckets\tload\tmax chain\tarrays\telems\ttable bytes\tkey bytes\tvalue bytes\tother bytes\t")
+	for i := range layout.Levels {
+		l := &layout.Levels[i]
+		fmt.Fprintf(tw, "%v\t%v\t%v\t%v\t%.2f\t%v\t%v\t%v\t%v\t%v\t%v\t%v\t\n",
+			i, l.Objects, l.Keys, l.Buckets, l.LoadFactor(), l.MaxChain(), l.Arrays, l.Elems,
+			l.TableBytes, l.KeyBytes, l.ValueBytes, l.OtherBytes)
+	}
+	tw.Flush()
+
+	for i := range layout.Levels {
+		l := &layout.Levels[i]
+		fmt.Fprintf(w, "\nlevel %v:\n", i)
+		if l.MPHObjects > 0 || l.SlotObjects > 0 || l.TypedArrays > 0 || l.Filters > 0 || l.Sorted > 0 {
+			fmt.Fprintf(w, "  layouts: %v minimal perfect hash, %v slot table, %v typed array, %v filtered, %v sorted\n",
+				l.MPHObjects, l.SlotObjects, l.TypedArrays, l.Filters, l.Sorted)
+		}
+		if len(l.Chains) > 0 {
+			fmt.Fprint(w, "  chain lengths:")
+			for n, count := range l.Chains {
+				if count > 0 {
+					fmt.Fprintf(w, " %v:%v", n, count)
+				}
+			}
+			fmt.Fprintln(w)
+		}
+		fmt.Fprint(w, "  offset sizes:")
+		for size, count := range l.OffsetSizes {
+			if count > 0 {
+				fmt.Fprintf(w, " %v:%v", size, count)
+			}
+		}
+		fmt.Fprintln(w)
+	}
+
+	if len(layout.Largest) > 0 {
+		fmt.Fprintln(w, "\nlargest values:")
+		for _, v := range layout.Largest {
+			fmt.Fprintf(w, "  %v\t%q\n", v.Size, v.Path)
+		}
+	}
+}
+
+// bench runs the bench command.
+func bench(args []string, stdin io.Reader, stdout io.Writer) (err error) {
+	flags := newFlagSet("bench", stdout)
+	mmap := flags.Bool("mmap", false, "map the file into memory")
+	bufferSize := flags.Int("buffer", -1, "read buffer size of the file, a default if < 0")
+	rounds := flags.Int("rounds", 1, "number of times to query the keys")
+	sep := flags.String("sep", "\t", "separator of the keys of a path")
+	if err = flags.Parse(args); err != nil {
+		return
+	}
+	if flags.NArg() != 2 {
+		return errors.New(usage)
+	}
+	paths, err := readPaths(flags.Arg(1), stdin, *sep)
+	if err != nil {
+		return
+	}
+	var h *hashive.Hashive
+	var closeFile func() error
+	if *mmap {
+		h, closeFile, err = hashive.OpenMmap(flags.Arg(0), hashive.WithStats())
+	} else {
+		h, closeFile, err = hashive.Open(flags.Arg(0), *bufferSize, hashive.WithStats())
+	}
+	if err != nil {
+		return
+	}
+	defer closeFile()
+
+	latencies := make([]time.Duration, 0, len(paths)*max(*rounds, 0))
+	var errs int
+	start := time.Now()
+	for range *rounds {
+		for _, path := range paths {
+			queryStart := time.Now()
+			_, err := h.Query(path...)
+			latencies = append(latencies, time.Since(queryStart))
+			if err != nil && err != hashive.ErrNotFound {
+				errs++
+			}
+		}
+	}
+	elapsed := time.Since(start)
+	if len(latencies) == 0 {
+		return errors.New("no key to query")
+	}
+	stats := h.Stats()
+	printBench(stdout, latencies, elapsed, errs, &stats)
+	return
+}
+
+// readPaths reads the paths of file, or stdin if file is "-".
+func readPaths(file string, stdin io.Reader, sep string) (paths [][]string, err error) {
+	r := stdin
+	if file != "-" {
+		var f *os.File
+		if f, err = os.Open(file); err != nil {
+			return
+		}
+		defer f.Close()
+		r = f
+	}
+	scanner := bufio.NewScanner(r)
+	scanner.Buffer(nil, 1<<20)
+	for scanner.Scan() {
+		if line := scanner.Text(); line != "" {
+			paths = append(paths, strings.Split(line, sep))
+		}
+	}
+	err = scanner.Err()
+	return
+}
+
+// percentiles are the percentiles reported by bench.
+var percentiles = []float64{50, 90, 99, 99.9}
+
+// printBench prints the latencies of bench to w.
+func printBench(w io.Writer, latencies []time.Duration, elapsed time.Duration, errs int, stats *hashive.QueryStats) {
+	slices.Sort(latencies)
+	n := len(latencies)
+	fmt.Fprintf(w, "queries: %v, not found: %v, errors: %v\n", n, stats.NotFound, errs)
+	fmt.Fprintf(w, "elapsed: %v, %.0f queries/s\n", elapsed, float64(n)/elapsed.Seconds())
+	fmt.Fprint(w, "latency:")
+	for _, p := range percentiles {
+		fmt.Fprintf(w, " p%v=%v", p, latencies[min(int(p/100*float64(n)), n-1)])
+	}
+	fmt.Fprintf(w, " max=%v\n", latencies[n-1])
+	if stats.Lookups > 0 {
+		lookups := float64(stats.Lookups)
+		fmt.Fprintf(w, "per lookup: %.2f probes, %.2f reads, %.0f bytes read, %.2f filtered\n",
+			float64(stats.Probes)/lookups, float64(stats.Reads)/lookups, float64(stats.BytesRead)/lookups,
+			float64(stats.Filtered)/lookups)
+	}
+}
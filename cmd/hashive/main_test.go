@@ -0,0 +1,48 @@
+package main
+
+import (
+	"bytes"
+	"path/filepath"
+	"strings"
+	"testing"
+
+	"github.com/mkch/hashive"
+)
+
+func TestRun(t *testing.T) {
+	filename := filepath.Join(t.TempDir(), "test.hashive")
+	value := map[string]any{
+		"a":    map[string]any{"b": []any{int64(1), "c"}},
+		"long": strings.Repeat("x", 100),
+	}
+	if err := hashive.WriteFile(filename, value); err != nil {
+		t.Fatal(err)
+	}
+
+	var out bytes.Buffer
+	if err := run([]string{"stat", "-largest", "1", filename}, nil, &out); err != nil {
+		t.Fatal(err)
+	}
+	for _, want := range []string{"level 2:", "chain lengths: 1:", "offset sizes: 1:", `["long"]`} {
+		if !strings.Contains(out.String(), want) {
+			t.Fatal(want, out.String())
+		}
+	}
+
+	out.Reset()
+	keys := strings.NewReader("a\tb\t1\nlong\nmissing\n")
+	if err := run([]string{"bench", "-rounds", "2", filename, "-"}, keys, &out); err != nil {
+		t.Fatal(err)
+	}
+	for _, want := range []string{"queries: 6, not found: 2, errors: 0", "p99=", "per lookup:"} {
+		if !strings.Contains(out.String(), want) {
+			t.Fatal(want, out.String())
+		}
+	}
+
+	for _, args := range [][]string{nil, {"unknown"}, {"stat"}, {"bench", filename}} {
+		if err := run(args, nil, &out); err == nil {
+			t.Fatal(args)
+		}
+	}
+}
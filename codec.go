@@ -0,0 +1,81 @@
+package hashive
+
+import (
+	"fmt"
+	"sync"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// Codec encodes and decodes the values of the types not built in Hashive,
+// which are gob encoded by default. See [WithCodec].
+type Codec interface {
+	// Name is the name of the codec stored in the file header,
+	// which is used to find the function registered by [RegisterCodec] when reading.
+	Name() string
+	// Schema returns the data of the codec stored in the file header,
+	// which is passed to the function registered by [RegisterCodec].
+	Schema() []byte
+	// Encode returns the encoding of v.
+	Encode(v any) ([]byte, error)
+	// Decode decodes data returned by Encode into v.
+	Decode(data []byte, v any) error
+}
+
+var (
+	codecsMu sync.RWMutex
+	codecs   = make(map[string]func(schema []byte) (Codec, error))
+)
+
+func init() {
+	RegisterCodec(impl.StructCodecName, func(schema []byte) (Codec, error) {
+		return impl.OpenStructCodec(schema)
+	})
+}
+
+// RegisterCodec registers the function that creates the [Codec] of name
+// from its schema, so the databases written with the codec can be opened.
+// The codecs returned by [NewStructCodec] are registered.
+func RegisterCodec(name string, open func(schema []byte) (Codec, error)) {
+	codecsMu.Lock()
+	defer codecsMu.Unlock()
+	codecs[name] = open
+}
+
+// openCodec creates the registered [Codec] of name with schema.
+func openCodec(name string, schema []byte) (c Codec, err error) {
+	codecsMu.RLock()
+	open := codecs[name]
+	codecsMu.RUnlock()
+	if open == nil {
+		return nil, fmt.Errorf("unknown codec %q", name)
+	}
+	return open(schema)
+}
+
+// NewStructCodec returns a [Codec] of the struct types of values,
+// and the struct types of their fields.
+// Exported fields of bools, numbers, strings, []byte, structs and slices of them
+// are encoded in order, and the names and types of the fields are stored once
+// in the file header instead of in every value.
+// Values are decoded into the fields of the same names with a decoding plan
+// created the first time a Go type is decoded, so they can be decoded
+// into the struct types of other programs.
+func NewStructCodec(values ...any) (Codec, error) {
+	c, err := impl.NewStructCodec(values...)
+	if err != nil {
+		return nil, err
+	}
+	return c, nil
+}
+
+// WithCodec returns a [WriteOption] that encodes the values of the types
+// not built in Hashive with c instead of gob.
+// The name and schema of c are stored in the file header,
+// and the codec is created again with the function registered by [RegisterCodec]
+// when the database is opened.
+func WithCodec(c Codec) WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.Codec = c
+	}
+}
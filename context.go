@@ -0,0 +1,127 @@
+package hashive
+
+import (
+	"context"
+	"sync"
+)
+
+// defaultBatchWorkers is the number of queries of [Hashive.QueryBatch]
+// in flight if not specified, which keeps the queue of an NVMe drive
+// or a remote storage busy.
+const defaultBatchWorkers = 32
+
+// contextResult is the result of a query run for [Hashive.QueryContext].
+type contextResult struct {
+	v   any
+	err error
+}
+
+// QueryContext is like [Hashive.Query], but returns the error of ctx
+// if ctx is done before the query finishes.
+// Reads of the storage can't be interrupted, so the query of a database
+// not in memory is run in another goroutine, which finishes in the background
+// after QueryContext returns. The query of a database created by [NewFromBytes]
+// is run in place, and ctx is only checked before it.
+func (h *Hashive) QueryContext(ctx context.Context, path ...string) (v any, err error) {
+	if err = ctx.Err(); err != nil {
+		return
+	}
+	if ctx.Done() == nil || h.src.Resident() {
+		return h.Query(path...)
+	}
+	done := make(chan contextResult, 1)
+	go func() {
+		v, err := h.Query(path...)
+		done <- contextResult{v, err}
+	}()
+	select {
+	case result := <-done:
+		return result.v, result.err
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// QueryBatch queries the values of paths with Query, keeping at most workers
+// queries in flight, or 32 if workers <= 0. The value and error of paths[i]
+// are values[i] and errs[i], see [Hashive.Query] for the meaning of a path.
+//
+// If ctx is done before all the queries finish, QueryBatch returns at once,
+// and the error of every query not finished is the error of ctx.
+// The queries in flight then finish in the background, see [Hashive.QueryContext].
+// A database created by [NewFromBytes] is queried one path after another in place.
+//
+// Unlike [Hashive.QueryMany], whose keys are in one object and read in order,
+// the reads of the paths are issued in parallel, so the storage can serve
+// them concurrently.
+func (h *Hashive) QueryBatch(ctx context.Context, paths [][]string, workers int) (values []any, errs []error) {
+	values, errs = make([]any, len(paths)), make([]error, len(paths))
+	if h.src.Resident() {
+		for i, path := range paths {
+			if err := ctx.Err(); err != nil {
+				for j := range errs[i:] {
+					errs[i+j] = err
+				}
+				return
+			}
+			values[i], errs[i] = h.Query(path...)
+		}
+		return
+	}
+	if workers <= 0 {
+		workers = defaultBatchWorkers
+	}
+	workers = min(workers, len(paths))
+
+	var mu sync.Mutex
+	next := 0          // index of the next path to query
+	finished := 0      // number of the queries finished
+	abandoned := false // whether QueryBatch has returned
+	finishedAll := make(chan struct{})
+	done := make([]bool, len(paths))
+	// take returns the index of the next path to query, or -1 if there is none.
+	take := func() int {
+		mu.Lock()
+		defer mu.Unlock()
+		if next == len(paths) || abandoned || ctx.Err() != nil {
+			return -1
+		}
+		next++
+		return next - 1
+	}
+	for range workers {
+		go func() {
+			for i := take(); i >= 0; i = take() {
+				v, err := h.Query(paths[i]...)
+				mu.Lock()
+				if !abandoned {
+					values[i], errs[i], done[i] = v, err, true
+					if finished++; finished == len(paths) {
+						close(finishedAll)
+					}
+				}
+				mu.Unlock()
+			}
+		}()
+	}
+	if len(paths) == 0 {
+		return
+	}
+	select {
+	case <-finishedAll:
+		return
+	case <-ctx.Done():
+	}
+	mu.Lock()
+	defer mu.Unlock()
+	if finished == len(paths) {
+		return
+	}
+	abandoned = true
+	for i := range errs {
+		if !done[i] {
+			errs[i] = ctx.Err()
+		}
+	}
+	return
+}
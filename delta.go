@@ -0,0 +1,273 @@
+package hashive
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"strconv"
+)
+
+// A delta database is a database of the changes to a base database,
+// see [Delta] and [Layered]. Its root object is:
+//
+//	{"delta": 1, "set": {path: value, ...}, "del": [path, ...]}
+//
+// where "delta" is the version of the format, "set" maps the paths of
+// upserted values to the values, and "del" is the paths of deleted values.
+// A path is encoded as a string of the length and the bytes of every key,
+// see [encodePath]. No path in a delta is a prefix of another path in it.
+
+// deltaVersion is the version of the delta format.
+const deltaVersion = 1
+
+// Keys of the root object of a delta database.
+const (
+	deltaKeyVersion = "delta"
+	deltaKeySet     = "set"
+	deltaKeyDel     = "del"
+)
+
+// errNotDelta is returned when a database is not a delta database.
+var errNotDelta = errors.New("not a delta database")
+
+// encodePath appends the encoding of path to dst, which is the uvarint length
+// and the bytes of every key, so the encoding of a path prefix is a prefix of it,
+// and appends the end of the encoding of every key to ends.
+func encodePath(dst []byte, ends []int, path []string) ([]byte, []int) {
+	for _, key := range path {
+		dst = binary.AppendUvarint(dst, uint64(len(key)))
+		dst = append(dst, key...)
+		ends = append(ends, len(dst))
+	}
+	return dst, ends
+}
+
+// decodePath decodes the path encoded by [encodePath].
+func decodePath(p string) (path []string, err error) {
+	for len(p) > 0 {
+		n, size := binary.Uvarint([]byte(p[:min(len(p), binary.MaxVarintLen64)]))
+		if size <= 0 || n > uint64(len(p)-size) {
+			return nil, fmt.Errorf("invalid delta path %q", p)
+		}
+		path = append(path, p[size:size+int(n)])
+		p = p[size+int(n):]
+	}
+	return
+}
+
+// Delta is a set of changes to a database: values upserted and deleted at paths.
+// It is written to a delta database by [WriteDelta], and applied to a base
+// database by [Layered] or [Compact].
+//
+// An upsert replaces the value at its path, and creates the objects
+// on the path if they do not exist. When a delta is applied to a database,
+// the values on the path other than objects and arrays are replaced by objects.
+// A deletion removes the value at its path.
+// The changes are applied in the order they are made.
+//
+// A Delta is not safe for concurrent use.
+type Delta struct {
+	entries map[string]*deltaEntry // by encoded path
+	// prefixes counts the entries under every encoded path prefix,
+	// so the entries under a path are only searched if there is one.
+	prefixes map[string]int
+}
+
+// deltaEntry is a change of a [Delta].
+type deltaEntry struct {
+	path    []string
+	value   any
+	deleted bool
+}
+
+// NewDelta returns an empty Delta.
+func NewDelta() *Delta {
+	return &Delta{entries: make(map[string]*deltaEntry), prefixes: make(map[string]int)}
+}
+
+// Len returns the number of paths changed by d.
+func (d *Delta) Len() int {
+	return len(d.entries)
+}
+
+// Set upserts value at path. Value is written as in [Write].
+// If the value at a prefix of path is set by d, value is set in it,
+// which must be an object or an array then.
+// The objects and arrays of value are kept by d, and modified by the changes under path.
+func (d *Delta) Set(value any, path ...string) error {
+	return d.change(path, value, false)
+}
+
+// Delete deletes the value at path.
+// If the value at a prefix of path is set by d, the value is deleted from it,
+// which must be an object then.
+func (d *Delta) Delete(path ...string) error {
+	return d.change(path, nil, true)
+}
+
+// change sets or deletes the value at path.
+func (d *Delta) change(path []string, value any, deleted bool) (err error) {
+	enc, ends := encodePath(nil, nil, path)
+	// The entries under path are replaced.
+	if d.prefixes[string(enc)] > 0 {
+		for key, entry := range d.entries {
+			if len(key) > len(enc) && key[:len(enc)] == string(enc) {
+				d.remove(key, entry)
+			}
+		}
+	}
+	// A change under an entry changes the entry.
+	for i := range path {
+		prefix := enc[:0]
+		if i > 0 {
+			prefix = enc[:ends[i-1]]
+		}
+		ancestor, ok := d.entries[string(prefix)]
+		if !ok {
+			continue
+		}
+		rel := path[i:]
+		if ancestor.deleted {
+			if deleted {
+				return
+			}
+			ancestor.value, ancestor.deleted = make(map[string]any), false
+		}
+		if deleted {
+			return deleteIn(ancestor.value, rel)
+		}
+		var v any
+		if v, err = setIn(ancestor.value, rel, value, false); err == nil {
+			ancestor.value = v
+		}
+		return
+	}
+	if entry := d.entries[string(enc)]; entry != nil {
+		entry.value, entry.deleted = value, deleted
+		return
+	}
+	d.entries[string(enc)] = &deltaEntry{path: path, value: value, deleted: deleted}
+	for _, end := range ends[:max(len(ends)-1, 0)] {
+		d.prefixes[string(enc[:end])]++
+	}
+	if len(path) > 0 {
+		d.prefixes[""]++
+	}
+	return
+}
+
+// remove removes the entry of encoded path key.
+func (d *Delta) remove(key string, entry *deltaEntry) {
+	delete(d.entries, key)
+	if len(entry.path) > 0 {
+		d.prefixes[""]--
+	}
+	_, ends := encodePath(nil, nil, entry.path)
+	for _, end := range ends[:max(len(ends)-1, 0)] {
+		d.prefixes[key[:end]]--
+	}
+}
+
+// setIn sets value at path in v, and returns v or the object replacing it.
+// The objects on path are created if they don't exist, and array elements
+// on path are set in the arrays.
+// Other values on path are replaced by objects if replace is true,
+// otherwise an error is returned.
+func setIn(v any, path []string, value any, replace bool) (_ any, err error) {
+	if len(path) == 0 {
+		return value, nil
+	}
+	switch container := v.(type) {
+	case map[string]any:
+		var elem any
+		if elem, err = setIn(container[path[0]], path[1:], value, replace); err == nil {
+			container[path[0]] = elem
+		}
+		return container, err
+	case []any:
+		i, errIndex := arrayIndex(container, path[0])
+		if errIndex == nil {
+			var elem any
+			if elem, err = setIn(container[i], path[1:], value, replace); err == nil {
+				container[i] = elem
+			}
+			return container, err
+		} else if !replace {
+			return nil, errIndex
+		}
+	case nil:
+	default:
+		if !replace {
+			return nil, fmt.Errorf("can't set %q in %T", path[0], v)
+		}
+	}
+	obj := make(map[string]any)
+	obj[path[0]], err = setIn(nil, path[1:], value, replace)
+	return obj, err
+}
+
+// deleteIn deletes the value at path from v.
+func deleteIn(v any, path []string) (err error) {
+	for i, key := range path {
+		switch container := v.(type) {
+		case map[string]any:
+			if i == len(path)-1 {
+				delete(container, key)
+				return
+			}
+			v = container[key]
+		case []any:
+			if i == len(path)-1 {
+				return fmt.Errorf("can't delete element %q of array", key)
+			}
+			var index int
+			if index, err = arrayIndex(container, key); err != nil {
+				return
+			}
+			v = container[index]
+		default:
+			return
+		}
+	}
+	return
+}
+
+// arrayIndex parses key as an index of array.
+func arrayIndex(array []any, key string) (i int, err error) {
+	index, err := strconv.ParseUint(key, 0, 64)
+	if err != nil {
+		return
+	}
+	if index >= uint64(len(array)) {
+		return 0, fmt.Errorf("array index out of range, %v of %v", index, len(array))
+	}
+	return int(index), nil
+}
+
+// WriteDelta writes the changes of d to w as a delta database.
+// The values are encoded as configured with opts, see [Write].
+func WriteDelta(w io.Writer, d *Delta, opts ...WriteOption) error {
+	set := make(map[string]any)
+	del := make([]any, 0)
+	for key, entry := range d.entries {
+		if entry.deleted {
+			del = append(del, key)
+		} else {
+			set[key] = entry.value
+		}
+	}
+	return Write(w, map[string]any{
+		deltaKeyVersion: uint64(deltaVersion),
+		deltaKeySet:     set,
+		deltaKeyDel:     del,
+	}, opts...)
+}
+
+// WriteDeltaFile writes the changes of d to file filename, see [WriteDelta].
+func WriteDeltaFile(filename string, d *Delta, opts ...WriteOption) (err error) {
+	return writeFile(filename, func(f *os.File) error {
+		return WriteDelta(f, d, opts...)
+	})
+}
@@ -0,0 +1,234 @@
+package hashive
+
+import (
+	"math"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// defaultExportBatchSize is the number of rows of a [RecordBatch] of [Hashive.Export]
+// if not specified.
+const defaultExportBatchSize = 4096
+
+// exportChunksPerWorker is the number of bucket ranges of an object per worker
+// of [Hashive.Export], so the workers finish at about the same time
+// if the entries of some ranges are larger than the others.
+const exportChunksPerWorker = 8
+
+// ColumnType is the type of a column of a [RecordBatch].
+type ColumnType byte
+
+const (
+	ColumnNull   ColumnType = iota // null, which has no column
+	ColumnInt                      // RecordBatch.Ints
+	ColumnUint                     // RecordBatch.Uints
+	ColumnFloat                    // RecordBatch.Floats
+	ColumnBool                     // RecordBatch.Bools
+	ColumnString                   // RecordBatch.Strings
+	ColumnBytes                    // RecordBatch.Bytes
+	ColumnOther                    // RecordBatch.Others
+)
+
+// RecordBatch is a batch of entries of an object in columnar form, see [Hashive.Export].
+// The values are stored like a dense union column of Apache Arrow:
+// the value of row i is the element Offsets[i] of the column of Types[i],
+// so the values of the same type are contiguous in a column,
+// and every value of an object of values of one type is in one column.
+type RecordBatch struct {
+	Keys    []string     // key of every row
+	Types   []ColumnType // column of the value of every row
+	Offsets []int        // index of the value of every row in its column
+	Ints    []int64
+	Uints   []uint64
+	Floats  []float64
+	Bools   []bool
+	Strings []string
+	Bytes   [][]byte
+	// Others are the gob values, arrays and objects, decoded as by [Hashive.Query].
+	Others []any
+}
+
+// Len returns the number of rows of b.
+func (b *RecordBatch) Len() int {
+	return len(b.Keys)
+}
+
+// Value returns the value of row i of b, as returned by [Hashive.Query].
+func (b *RecordBatch) Value(i int) any {
+	offset := b.Offsets[i]
+	switch b.Types[i] {
+	case ColumnInt:
+		return b.Ints[offset]
+	case ColumnUint:
+		return b.Uints[offset]
+	case ColumnFloat:
+		return b.Floats[offset]
+	case ColumnBool:
+		return b.Bools[offset]
+	case ColumnString:
+		return b.Strings[offset]
+	case ColumnBytes:
+		return b.Bytes[offset]
+	case ColumnOther:
+		return b.Others[offset]
+	default:
+		return nil
+	}
+}
+
+// reset empties b, keeping the buffers of the columns.
+func (b *RecordBatch) reset() {
+	clear(b.Strings)
+	clear(b.Bytes)
+	clear(b.Others)
+	*b = RecordBatch{
+		Keys:    b.Keys[:0],
+		Types:   b.Types[:0],
+		Offsets: b.Offsets[:0],
+		Ints:    b.Ints[:0],
+		Uints:   b.Uints[:0],
+		Floats:  b.Floats[:0],
+		Bools:   b.Bools[:0],
+		Strings: b.Strings[:0],
+		Bytes:   b.Bytes[:0],
+		Others:  b.Others[:0],
+	}
+}
+
+// append decodes value and appends the row of key to b.
+func (b *RecordBatch) append(key string, value impl.Value) (err error) {
+	kind, bits, err := value.Scalar()
+	if err != nil {
+		return
+	}
+	var t ColumnType
+	var offset int
+	switch kind {
+	case impl.KindNull:
+		t = ColumnNull
+	case impl.KindInt:
+		t, offset = ColumnInt, len(b.Ints)
+		b.Ints = append(b.Ints, int64(bits))
+	case impl.KindUint:
+		t, offset = ColumnUint, len(b.Uints)
+		b.Uints = append(b.Uints, bits)
+	case impl.KindFloat:
+		t, offset = ColumnFloat, len(b.Floats)
+		b.Floats = append(b.Floats, math.Float64frombits(bits))
+	case impl.KindBool:
+		t, offset = ColumnBool, len(b.Bools)
+		b.Bools = append(b.Bools, bits != 0)
+	case impl.KindString:
+		var s string
+		if s, err = value.Str(); err != nil {
+			return
+		}
+		t, offset = ColumnString, len(b.Strings)
+		b.Strings = append(b.Strings, s)
+	default:
+		var v any
+		if v, err = value.Decode(true); err != nil {
+			return
+		}
+		// Compressed and pooled strings and []byte are decoded here.
+		switch v := v.(type) {
+		case string:
+			t, offset = ColumnString, len(b.Strings)
+			b.Strings = append(b.Strings, v)
+		case []byte:
+			t, offset = ColumnBytes, len(b.Bytes)
+			b.Bytes = append(b.Bytes, v)
+		default:
+			t, offset = ColumnOther, len(b.Others)
+			b.Others = append(b.Others, v)
+		}
+	}
+	b.Keys = append(b.Keys, key)
+	b.Types = append(b.Types, t)
+	b.Offsets = append(b.Offsets, offset)
+	return
+}
+
+// Export calls fn with the entries of the object mapped by path in record batches
+// of at most batchSize rows, or 4096 if batchSize <= 0, see [RecordBatch].
+// Every entry is in one batch, in no particular order.
+// For the meaning of argument path, see [Hashive.Query].
+//
+// The buckets of the object are split into ranges, which are decoded in parallel
+// by workers goroutines, or GOMAXPROCS if workers <= 0, without building the
+// map of [Hashive.Query]. Every worker fills a batch of its own, and calls fn with it
+// when it is full, so fn is called concurrently by the workers.
+// A batch is reused after fn returns, so fn must copy the content it keeps.
+//
+// Export stops at the first error returned by fn or met decoding the entries,
+// and returns it after the workers stop.
+func (h *Hashive) Export(batchSize, workers int, fn func(batch *RecordBatch) error, path ...string) (err error) {
+	if batchSize <= 0 {
+		batchSize = defaultExportBatchSize
+	}
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	v, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	obj, err := v.Object()
+	if err != nil {
+		return notFound(err)
+	}
+	buckets := obj.Buckets()
+	chunks := max(min(uint64(workers)*exportChunksPerWorker, buckets), 1)
+	// chunkStart returns the first bucket of chunk, the chunks differ in size by 1 at most.
+	chunkStart := func(chunk uint64) uint64 {
+		return buckets/chunks*chunk + min(chunk, buckets%chunks)
+	}
+
+	var next atomic.Uint64 // the next chunk to export
+	var failed atomic.Bool
+	var errOnce sync.Once
+	fail := func(e error) {
+		errOnce.Do(func() { err = e })
+		failed.Store(true)
+	}
+	var wg sync.WaitGroup
+	for range min(uint64(workers), chunks) {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			batch := &RecordBatch{}
+			for !failed.Load() {
+				chunk := next.Add(1) - 1
+				if chunk >= chunks {
+					break
+				}
+				var errRow error
+				if errRange := obj.RangeBuckets(chunkStart(chunk), chunkStart(chunk+1), func(key string, value impl.Value) bool {
+					if errRow = batch.append(key, value); errRow != nil {
+						return false
+					}
+					if batch.Len() < batchSize {
+						return true
+					}
+					errRow = fn(batch)
+					batch.reset()
+					return errRow == nil && !failed.Load()
+				}); errRange != nil {
+					fail(errRange)
+				} else if errRow != nil {
+					fail(errRow)
+				}
+			}
+			if batch.Len() > 0 && !failed.Load() {
+				if errFn := fn(batch); errFn != nil {
+					fail(errFn)
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	return
+}
@@ -6,15 +6,21 @@ import (
 	"errors"
 	"fmt"
 	"io"
-	"math"
 	"os"
-	"strconv"
+	"runtime"
+	"slices"
 	"strings"
+	"sync"
 
 	"github.com/mkch/hashive/internal/impl"
 )
 
-const fileSignature = "hashive\x00"
+// fileSignature is the signature of the databases with an [impl.Header].
+const fileSignature = "hashive\x01"
+
+// legacyFileSignature is the signature of the databases without header.
+// The keys of these databases are hashed with FNV-1a.
+const legacyFileSignature = "hashive\x00"
 
 // Write encodes value into Hashive format recursively and writes it to w.
 //   - All singed integers are stored as int64.
@@ -24,7 +30,10 @@ const fileSignature = "hashive\x00"
 //   - []any is stored as array.
 //   - map[string]any is stored as associated object.
 //   - All the others types are stored as gob encoded binary data.
-func Write(w io.Writer, value any) (err error) {
+//     The gob encoded values returned by [Hashive.Query] are stored as is.
+//
+// The encoding can be configured with opts.
+func Write(w io.Writer, value any, opts ...WriteOption) (err error) {
 	buffered := bufio.NewWriter(w)
 	defer func() {
 		errFlush := buffered.Flush()
@@ -37,9 +46,166 @@ func Write(w io.Writer, value any) (err error) {
 	if _, err = buffered.WriteString(fileSignature); err != nil {
 		return
 	}
+	options := newWriteOptions(opts)
+	if options.PoolStrings {
+		options.Pool = impl.NewStringPool(value, options)
+	}
+	if err = impl.WriteHeader(buffered, int64(len(fileSignature)), options.Header()); err != nil {
+		return
+	}
+	return impl.EncodeValue(buffered, value, options)
+}
+
+// WriteOption is an option of [Write] and its variants.
+type WriteOption func(opts *impl.WriteOptions)
+
+func newWriteOptions(opts []WriteOption) *impl.WriteOptions {
+	options := &impl.WriteOptions{Gob: impl.NewGobEncoder(), Hash: impl.HashWyhash}
+	for _, opt := range opts {
+		opt(options)
+	}
+	return options
+}
+
+// WithMinimalPerfectHash returns a [WriteOption] that indexes objects
+// with a minimal perfect hash instead of a chained hash table.
+// Every lookup is then exactly one slot probe and one key comparison,
+// and the offset table has one entry per key.
+// Writing is slower, and an object falls back to the chained hash table
+// in the unlikely case that the perfect hash can't be built for its keys.
+func WithMinimalPerfectHash() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.MinimalPerfectHash = true
+	}
+}
 
-	gobEncoder := impl.NewGobEncoder()
-	return impl.WriteValue(buffered, value, gobEncoder)
+// WithWorkers returns a [WriteOption] that encodes values with n goroutines in parallel.
+// The elements of arrays and the values of objects are split into chunks,
+// which are encoded concurrently and then stitched together,
+// so the written database is the same as a sequential one.
+// If n <= 0, [runtime.GOMAXPROCS] is used.
+func WithWorkers(n int) WriteOption {
+	if n <= 0 {
+		n = runtime.GOMAXPROCS(0)
+	}
+	return func(opts *impl.WriteOptions) {
+		opts.Workers = impl.NewWorkers(n)
+	}
+}
+
+// WithCompression returns a [WriteOption] that compresses strings, []byte and gob values
+// of at least threshold bytes with DEFLATE, using dict as the preset dictionary.
+// If threshold <= 0, a default of 128 bytes is used.
+// A value is stored uncompressed if compression doesn't make it smaller.
+//
+// The dictionary is stored once in the file header, and should be content
+// common to many values, such as a few typical values concatenated,
+// with the most common content at the end. Only the last 32KB of dict is used.
+// Compressed values are decompressed transparently by queries.
+func WithCompression(dict []byte, threshold int) WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.Compressor = impl.NewCompressor(dict, threshold)
+	}
+}
+
+// WithStringPool returns a [WriteOption] that stores every string and []byte value
+// occurring more than once only once, in a string pool in the file header.
+// The occurrences are stored as references to the pool, which are resolved
+// transparently by queries. Object keys are stored in place.
+//
+// The value is scanned for the repeated values before writing,
+// so WithStringPool is not supported by [Builder].
+func WithStringPool() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.PoolStrings = true
+	}
+}
+
+// WithTypedArrays returns a [WriteOption] that stores arrays of elements of
+// the same type compactly: []any of only signed integers, only unsigned integers,
+// only float point numbers, only bools or only strings, and slices of these types
+// such as []int64, []float64 and []string.
+// Numbers are stored with a fixed width without type marks, bools are bit-packed
+// and strings are stored as an offset column followed by their contents,
+// so an element is read directly by its index, and [Hashive.QueryFloats] and
+// the like scan the entire array sequentially.
+//
+// Typed arrays are read back as []any like other arrays.
+// Without this option, slices other than []any and []byte are gob encoded.
+func WithTypedArrays() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.TypedArrays = true
+	}
+}
+
+// WithInlineKeys returns a [WriteOption] that stores objects whose keys are
+// at most maxKeySize bytes in a flat hash table of fixed size slots,
+// with the keys and the small values such as numbers and short strings inline,
+// so a lookup usually reads a single slot.
+// Objects with longer keys are stored as usual. Keys are at most 64 bytes inline.
+func WithInlineKeys(maxKeySize int) WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.InlineKeySize = maxKeySize
+	}
+}
+
+// WithPowerOfTwoBuckets returns a [WriteOption] that sizes the hash tables of objects
+// and the slot tables of [WithInlineKeys] to powers of 2, and selects the bucket of a key
+// by the high bits of its hash multiplied by a constant.
+// Writing is faster without searching prime bucket counts, and a lookup doesn't divide.
+// The tables are at most twice as large as the keys need.
+func WithPowerOfTwoBuckets() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.PowerOfTwo = true
+	}
+}
+
+// WithAlignedLayout returns a [WriteOption] that aligns the indexes of objects
+// and arrays in the file: offset tables have 4 or 8 byte offsets, the tables of objects
+// start at multiples of the offset size, objects and arrays start at 64-byte cache lines,
+// and the key count and fingerprints of a bucket list don't cross a cache line,
+// so a lookup in a mapped file
+// loads one cache line of the index and one of the bucket list.
+// The file is larger by the padding.
+//
+// Objects written with [WithMinimalPerfectHash] keep their own layout,
+// and start at cache lines as well.
+func WithAlignedLayout() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.Aligned = true
+	}
+}
+
+// WithFilter returns a [WriteOption] that writes an xor filter of the keys of
+// every object of 64 keys or more, which rejects most of the keys not in the object,
+// about 255 of 256, without reading the offset table or a bucket list.
+// A filter takes about 1.23 bytes per key and 40 bytes more.
+// Smaller objects have no filter, as a miss of them reads a short bucket list anyway.
+//
+// The filters of [OpenMmap] and [NewFromBytes] are read in place.
+// The filters of [Open], [New] and [NewReaderAt] are read once and kept in memory,
+// up to 64 MiB, after which the filters of the other objects are not used.
+//
+// Objects written with [WithMinimalPerfectHash] or [WithInlineKeys]
+// have no filter.
+func WithFilter() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.Filter = true
+	}
+}
+
+// WithSortedKeys returns a [WriteOption] that writes a sorted index of the keys of
+// every object after its bucket lists, in blocks of prefix compressed keys,
+// so the ranges and the prefixes of keys are scanned in the order of keys
+// by [Hashive.Range] and [Hashive.Prefix] without reading the other entries.
+// The keys are stored twice, the index is smaller by the shared prefixes.
+//
+// Objects written with [WithMinimalPerfectHash] or [WithInlineKeys]
+// have no sorted index.
+func WithSortedKeys() WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.SortedKeys = true
+	}
 }
 
 func writeFile(filename string, callback func(f *os.File) error) (err error) {
@@ -58,41 +224,41 @@ func writeFile(filename string, callback func(f *os.File) error) (err error) {
 
 // WriteFile is like [Write] but writes value to a file.
 // The file will be overwritten if exists.
-func WriteFile(filename string, value any) (err error) {
+func WriteFile(filename string, value any, opts ...WriteOption) (err error) {
 	return writeFile(filename, func(f *os.File) error {
-		return Write(f, value)
+		return Write(f, value, opts...)
 	})
 }
 
 // WriteJSON decodes the next JSON-encoded value from jsonInput,
 // and then writes the decoded value with [Write].
-func WriteJSON(w io.Writer, jsonInput io.Reader) (err error) {
+func WriteJSON(w io.Writer, jsonInput io.Reader, opts ...WriteOption) (err error) {
 	var v any
 	if err = json.NewDecoder(jsonInput).Decode(&v); err != nil {
 		return
 	}
-	return Write(w, v)
+	return Write(w, v, opts...)
 }
 
 // WriteFileJSON is like [WriteJSON] but writes the decoded value to a file.
 // The file will be overwritten if exists.
-func WriteFileJSON(filename string, jsonInput io.Reader) (err error) {
+func WriteFileJSON(filename string, jsonInput io.Reader, opts ...WriteOption) (err error) {
 	return writeFile(filename, func(f *os.File) error {
-		return WriteJSON(f, jsonInput)
+		return WriteJSON(f, jsonInput, opts...)
 	})
 }
 
 // WriteJSONString the next JSON-encoded value from jsonString,
 // and then writes the decoded value with [Write].
-func WriteJSONString(w io.Writer, jsonString string) (err error) {
-	return WriteJSON(w, strings.NewReader(jsonString))
+func WriteJSONString(w io.Writer, jsonString string, opts ...WriteOption) (err error) {
+	return WriteJSON(w, strings.NewReader(jsonString), opts...)
 }
 
 // WriteFileJSONString is like [WriteJSONString] but writes the decoded value to a file.
 // The file will be overwritten if exists.
-func WriteFileJSONString(filename string, jsonString string) (err error) {
+func WriteFileJSONString(filename string, jsonString string, opts ...WriteOption) (err error) {
 	return writeFile(filename, func(f *os.File) error {
-		return WriteJSONString(f, jsonString)
+		return WriteJSONString(f, jsonString, opts...)
 	})
 }
 
@@ -101,87 +267,272 @@ func WriteFileJSONString(filename string, jsonString string) (err error) {
 var ErrNotFound = impl.ErrNotFound
 
 // Hashive is the Hashive instance.
+// A Hashive is safe for concurrent use by multiple goroutines,
+// if the storage it reads from is. See [New] and [NewReaderAt].
 type Hashive struct {
-	r          impl.ByteReadSeeker
-	ary        *impl.Array
-	obj        *impl.Object
+	src        *impl.Source
+	root       impl.Value
 	gobDecoder func(gob impl.GobValue, v any) error
+	codec      Codec // codec of the gob values, nil if gob encoded
+	// gobTypes returns the definitions of the gob types of a database
+	// signed "hashive\x00", see [impl.LegacyGobTypes]. It is nil for other databases.
+	gobTypes   func() ([]byte, error)
+	pathCache  *pathCache  // nil if disabled
+	valueCache *valueCache // nil if disabled
+	stats      *queryStats // nil if disabled
 }
 
 const defaultBufferSize = 1024
 
+// Option is an option of [Open], [New] and the other functions creating a [Hashive].
+type Option func(opts *options)
+
+type options struct {
+	pathCacheSize      int
+	valueCacheMaxBytes int
+	stats              bool
+}
+
+// WithPathCache returns an [Option] that caches the resolved values of
+// at most size parent paths, so the common levels of query paths are
+// not looked up again. For example, after
+//
+//	h.Query("tenant", id, "settings", key)
+//
+// the object of "tenant", id, "settings" is cached, and queries of
+// other keys in it take only one lookup.
+// The statistics of the cache are returned by [Hashive.PathCacheStats].
+func WithPathCache(size int) Option {
+	return func(opts *options) {
+		opts.pathCacheSize = size
+	}
+}
+
+// WithValueCache returns an [Option] that caches the decoded values of
+// query paths in about maxBytes of memory, so hot values are returned
+// without reading the database. Arrays and objects are not cached.
+// The cache is sharded and the entries are evicted with the CLOCK algorithm,
+// so concurrent hits don't wait for each other.
+// The statistics of the cache are returned by [Hashive.ValueCacheStats].
+func WithValueCache(maxBytes int) Option {
+	return func(opts *options) {
+		opts.valueCacheMaxBytes = maxBytes
+	}
+}
+
 // Open opens the Hashive database denoted by filename.
 // The returned close function can be used to close the database file after use.
 // See [New] for more details.
-func Open(filename string, readBufferSize int) (h *Hashive, close func() error, err error) {
+func Open(filename string, readBufferSize int, opts ...Option) (h *Hashive, close func() error, err error) {
 	f, err := os.Open(filename)
 	if err != nil {
 		return
 	}
 	close = f.Close
 
-	h, err = New(f, readBufferSize)
+	if h, err = New(f, readBufferSize, opts...); err != nil {
+		f.Close()
+		close = nil
+	}
+	return
+}
+
+// OpenMmap opens the Hashive database denoted by filename,
+// and maps the entire file into memory.
+// Queries read the mapped memory directly, without any system call.
+// The returned close function must be called to unmap the file after use,
+// and h must not be used after that.
+func OpenMmap(filename string, opts ...Option) (h *Hashive, close func() error, err error) {
+	f, err := os.Open(filename)
+	if err != nil {
+		return
+	}
+	// The mapping remains valid after f is closed.
+	defer f.Close()
+	data, munmap, err := impl.Mmap(f)
+	if err != nil {
+		return
+	}
+	if h, err = newHashive(impl.NewMmapSource(data), opts); err != nil {
+		munmap()
+		return
+	}
+	close = munmap
 	return
 }
 
 // New creates a Hashive instance from r.
+// If r implements [io.ReaderAt] (e.g. [*os.File] and [*bytes.Reader]),
+// r is read with positional reads, see [NewReaderAt].
+// Otherwise the seek and read of r are serialized by a lock.
 //
 // If readBufferSize < 0, a reasonable default will be used.
-func New(r io.ReadSeeker, readBufferSize int) (h *Hashive, err error) {
+// The Hashive can be configured with opts.
+func New(r io.ReadSeeker, readBufferSize int, opts ...Option) (h *Hashive, err error) {
 	if readBufferSize < 0 {
 		readBufferSize = defaultBufferSize
 	}
-	reader, err := impl.NewBufByteReadSeeker(r, readBufferSize)
-	if err != nil {
-		return
+	return newHashive(impl.NewReadSeekerSource(r, readBufferSize), opts)
+}
+
+// NewReaderAt creates a Hashive instance from r.
+// Every query reads r with its own buffer of readBufferSize bytes,
+// so the returned Hashive can be queried from multiple goroutines
+// in parallel if r is safe for concurrent use.
+//
+// If readBufferSize < 0, a reasonable default will be used.
+func NewReaderAt(r io.ReaderAt, readBufferSize int, opts ...Option) (h *Hashive, err error) {
+	if readBufferSize < 0 {
+		readBufferSize = defaultBufferSize
+	}
+	return newHashive(impl.NewReaderAtSource(r, readBufferSize), opts)
+}
+
+// NewFromBytes creates a Hashive instance from the content of a database.
+// The content of data must not be modified while the returned Hashive is in use.
+func NewFromBytes(data []byte, opts ...Option) (h *Hashive, err error) {
+	return newHashive(impl.NewBytesSource(data), opts)
+}
+
+func newHashive(src *impl.Source, opts []Option) (h *Hashive, err error) {
+	var options options
+	for _, opt := range opts {
+		opt(&options)
 	}
+
 	signature := make([]byte, len(fileSignature))
-	if _, err = io.ReadFull(reader, signature); err != nil {
+	if n, errRead := src.ReadAt(signature, 0); n < len(signature) {
+		if err = errRead; err == nil || err == io.EOF {
+			err = io.ErrUnexpectedEOF
+		}
 		return
 	}
-	if sig := string(signature); sig != fileSignature {
+	rootPos := int64(len(signature))
+	gobDecoder := impl.NewGobDecoder()
+	var codec Codec
+	var gobTypes func() ([]byte, error)
+	switch sig := string(signature); sig {
+	case fileSignature:
+		var header impl.Header
+		if header, rootPos, err = src.ReadHeader(rootPos); err != nil {
+			return
+		}
+		if header.Codec != "" {
+			if codec, err = openCodec(header.Codec, header.Schema); err != nil {
+				return
+			}
+			gobDecoder = func(gob impl.GobValue, v any) error {
+				return codec.Decode(gob, v)
+			}
+		}
+	case legacyFileSignature:
+		// The definitions of the gob types are collected on the first decode.
+		gobTypes = sync.OnceValues(func() ([]byte, error) {
+			return impl.LegacyGobTypes(src.Value(rootPos))
+		})
+		gobDecoder = impl.NewLegacyGobDecoder(gobTypes)
+	default:
 		err = fmt.Errorf("invalid signature %v", sig)
 		return
 	}
 
-	var ary *impl.Array
-	var obj *impl.Object
-	obj, err = impl.ReadObject(reader)
-	var typeErr *impl.TypeError
-	if errors.As(err, &typeErr) {
-		if _, err = reader.Seek(int64(len(fileSignature)), io.SeekStart); err != nil {
-			return
-		}
-		ary, err = impl.ReadArray(reader)
-		if !errors.As(err, &typeErr) {
-			return
-		}
+	root := src.Value(rootPos)
+	// Validate the root value.
+	if _, err = root.Decode(false); err != nil {
+		return
+	}
+	h = &Hashive{
+		src:        src,
+		root:       root,
+		gobDecoder: gobDecoder,
+		codec:      codec,
+		gobTypes:   gobTypes,
+	}
+	if options.pathCacheSize > 0 {
+		h.pathCache = newPathCache(options.pathCacheSize)
+	}
+	if options.valueCacheMaxBytes > 0 {
+		h.valueCache = newValueCache(options.valueCacheMaxBytes)
+	}
+	if options.stats {
+		h.countStats()
+	}
+	return
+
+}
+
+// WarmLevel is the level of [Hashive.Warm].
+type WarmLevel int
+
+const (
+	// WarmRoot prefetches the offset table of the root object,
+	// which is at the front of the file.
+	WarmRoot WarmLevel = iota
+	// WarmTables prefetches the offset tables of all the objects and arrays.
+	// It reads the entire tree of offsets to find the tables.
+	WarmTables
+	// WarmAll prefetches the whole file.
+	WarmAll
+)
+
+// Warm prefetches the content of the database at level,
+// so the first queries don't wait for the storage.
+// The memory of [OpenMmap] is advised to be paged in,
+// and the other files are read through to fill the page cache of the OS.
+// Warm does nothing if h is created by [NewFromBytes], whose content is in memory.
+func (h *Hashive) Warm(level WarmLevel) error {
+	switch level {
+	case WarmRoot:
+		return h.root.PrefetchTables(false)
+	case WarmTables:
+		return h.root.PrefetchTables(true)
+	case WarmAll:
+		return h.src.Prefetch(0, -1)
+	default:
+		return fmt.Errorf("invalid warm level %v", level)
 	}
+}
+
+// Layout is the layout of the objects and arrays of a database, see [Hashive.Layout].
+type Layout = impl.Layout
+
+// LevelLayout is the layout of the objects and arrays at a nesting level of a database.
+type LevelLayout = impl.LevelLayout
+
+// LargeValue is a large value of a database reported in [Layout].
+type LargeValue = impl.LargeValue
 
-	return &Hashive{
-		r:          reader,
-		ary:        ary,
-		obj:        obj,
-		gobDecoder: impl.NewGobDecoder(),
-	}, nil
+// Layout reads the whole database and returns the layout of every nesting level:
+// the numbers of keys and buckets, the lengths of bucket lists, the sizes of offsets,
+// and the bytes of the tables, keys and values.
+// At most largest of the largest values are reported.
+func (h *Hashive) Layout(largest int) (*Layout, error) {
+	return h.root.Layout(largest)
 }
 
 // QueryGob queries a gob encoded value mapped by the path.
 // [ErrNotFound] will be returned if the path does not map to any value
 // or the type of the value is not a gob encoded value.
+// If the database is written with [WithCodec], the value is decoded by the codec.
 //
 // For the meaning of argument path, see [Hashive.Query].
 func (h *Hashive) QueryGob(v any, path ...string) (err error) {
-	value, err := h.Query(path...)
+	if h.valueCache != nil {
+		var gob impl.GobValue
+		if gob, err = cachedAs[impl.GobValue](h, path); err != nil {
+			return
+		}
+		return h.gobDecoder(gob, v)
+	}
+	value, err := h.lookup(path)
 	if err != nil {
 		return
 	}
-	if gob, ok := value.(impl.GobValue); ok {
-		err = h.gobDecoder(gob, v)
-	} else {
-		err = ErrNotFound
+	gob, err := value.Gob()
+	if err != nil {
+		return notFound(err)
 	}
-	return
+	return h.gobDecoder(gob, v)
 }
 
 // Query queries a value mapped by the path.
@@ -197,55 +548,312 @@ func (h *Hashive) QueryGob(v any, path ...string) (err error) {
 //
 // Empty path maps to the entire value(a map[string]any or []any).
 func (h *Hashive) Query(path ...string) (v any, err error) {
-	if len(path) == 0 {
-		if _, err = h.r.Seek(int64(len(fileSignature)), io.SeekStart); err != nil {
+	if h.valueCache != nil {
+		if v, err = h.cachedValue(path); err != nil {
 			return
 		}
-		return impl.ReadValue(h.r, true)
+		switch value := v.(type) {
+		case impl.Value:
+			return value.Decode(true)
+		case []byte:
+			return slices.Clone(value), nil
+		case impl.GobValue:
+			return slices.Clone(value), nil
+		}
+		return
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	return value.Decode(true)
+}
+
+// QueryString queries a string mapped by the path.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is not string.
+// Map keys on the path are compared in place, only the returned string is allocated.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryString(path ...string) (s string, err error) {
+	if h.valueCache != nil {
+		return cachedAs[string](h, path)
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	if s, err = value.Str(); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryBytesInto queries a string or []byte mapped by the path,
+// appends its content to dst and returns the extended buffer.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is neither string nor []byte.
+// Nothing is allocated if dst has enough capacity.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryBytesInto(dst []byte, path ...string) (p []byte, err error) {
+	if h.valueCache != nil {
+		var v any
+		if v, err = h.cachedValue(path); err != nil {
+			return dst, err
+		}
+		switch value := v.(type) {
+		case string:
+			return append(dst, value...), nil
+		case []byte:
+			return append(dst, value...), nil
+		}
+		return dst, ErrNotFound
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return dst, err
+	}
+	if p, err = value.AppendBytes(dst); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryInt queries a signed integer mapped by the path.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is not signed integer.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryInt(path ...string) (n int64, err error) {
+	if h.valueCache != nil {
+		return cachedAs[int64](h, path)
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	if n, err = value.Int(); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryUint queries an unsigned integer mapped by the path.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is not unsigned integer.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryUint(path ...string) (n uint64, err error) {
+	if h.valueCache != nil {
+		return cachedAs[uint64](h, path)
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	if n, err = value.Uint(); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryFloat queries a float point number mapped by the path.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is not float point number.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryFloat(path ...string) (f float64, err error) {
+	if h.valueCache != nil {
+		return cachedAs[float64](h, path)
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	if f, err = value.Float(); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryBool queries a bool mapped by the path.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the type of the value is not bool.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryBool(path ...string) (b bool, err error) {
+	if h.valueCache != nil {
+		return cachedAs[bool](h, path)
+	}
+	value, err := h.lookup(path)
+	if err != nil {
+		return
+	}
+	if b, err = value.Bool(); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryInts queries an array of signed integers mapped by the path,
+// appends its elements to dst and returns the extended buffer.
+// [ErrNotFound] will be returned if the path does not map to any value
+// or the value is not an array of signed integers.
+// Arrays written with [WithTypedArrays] are read without decoding the elements one by one.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryInts(dst []int64, path ...string) (p []int64, err error) {
+	value, err := h.lookup(path)
+	if err != nil {
+		return dst, err
 	}
-	if h.obj != nil {
-		return queryObject(path, h.obj)
-	} else if h.ary != nil {
-		return queryArray(path, h.ary)
+	if p, err = value.AppendInts(dst); err != nil {
+		err = notFound(err)
 	}
-	return nil, ErrNotFound
+	return
 }
 
-func queryObject(path []string, obj *impl.Object) (v any, err error) {
-	value, err := obj.Index(path[0], len(path) == 1)
+// QueryUints is like [Hashive.QueryInts] but for arrays of unsigned integers.
+func (h *Hashive) QueryUints(dst []uint64, path ...string) (p []uint64, err error) {
+	value, err := h.lookup(path)
 	if err != nil {
+		return dst, err
+	}
+	if p, err = value.AppendUints(dst); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryFloats is like [Hashive.QueryInts] but for arrays of float point numbers.
+func (h *Hashive) QueryFloats(dst []float64, path ...string) (p []float64, err error) {
+	value, err := h.lookup(path)
+	if err != nil {
+		return dst, err
+	}
+	if p, err = value.AppendFloats(dst); err != nil {
+		err = notFound(err)
+	}
+	return
+}
+
+// QueryMany queries the values of keys in the object mapped by path.
+// The value and error of keys[i] are values[i] and errs[i],
+// where the error is [ErrNotFound] if the key does not map to any value.
+//
+// All the keys are hashed first, and the database is read in the order
+// of positions, which is much faster than querying the keys one by one
+// for large batches on disks and network file systems.
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) QueryMany(keys []string, path ...string) (values []any, errs []error) {
+	value, err := h.lookup(path)
+	if err != nil {
+		values, errs = make([]any, len(keys)), make([]error, len(keys))
+		for i := range errs {
+			errs[i] = err
+		}
 		return
 	}
-	if len(path) == 1 {
-		return value, err
-	} else if obj, ok := value.(*impl.Object); ok {
-		return queryObject(path[1:], obj)
-	} else if ary, ok := value.(*impl.Array); ok {
-		return queryArray(path[1:], ary)
+	found, errs := value.LookupMany(keys)
+	return impl.DecodeMany(found, errs, true), errs
+}
+
+// lookup returns the value mapped by path without decoding it.
+func (h *Hashive) lookup(path []string) (v impl.Value, err error) {
+	if h.stats != nil {
+		return h.countLookup(path)
+	}
+	return h.resolve(path)
+}
+
+// resolve is [Hashive.lookup] without the stats.
+func (h *Hashive) resolve(path []string) (v impl.Value, err error) {
+	if h.pathCache == nil || len(path) < 2 {
+		return walk(h.root, path)
 	}
-	return nil, ErrNotFound
+	parent, key := path[:len(path)-1], path[len(path)-1]
+	v, hash, ok := h.pathCache.get(parent)
+	if !ok {
+		if v, err = walk(h.root, parent); err != nil {
+			return
+		}
+		h.pathCache.put(parent, hash, v)
+	}
+	return v.Lookup(key)
 }
 
-func queryArray(path []string, ary *impl.Array) (v any, err error) {
-	index, err := strconv.ParseUint(path[0], 0, 64)
+// walk returns the value mapped by path from v.
+func walk(v impl.Value, path []string) (_ impl.Value, err error) {
+	for _, key := range path {
+		if v, err = v.Lookup(key); err != nil {
+			return
+		}
+	}
+	return v, nil
+}
+
+// cachedValue returns the value mapped by path through the value cache.
+// Arrays and objects are returned as [impl.Value] and not cached,
+// other values are decoded and cached.
+func (h *Hashive) cachedValue(path []string) (v any, err error) {
+	v, hash, ok := h.valueCache.get(path)
+	if ok {
+		return
+	}
+	value, err := h.lookup(path)
 	if err != nil {
 		return
 	}
-	if index > math.MaxInt {
-		err = fmt.Errorf("invalid index %v", index)
+	if v, err = value.Decode(false); err != nil {
 		return
 	}
+	switch v.(type) {
+	case *impl.Object, *impl.Array:
+		return value, nil
+	}
+	h.valueCache.put(path, hash, v)
+	return
+}
 
-	value, err := ary.Index(int(index), len(path) == 1)
+// cachedAs returns the value of type T mapped by path through the value cache.
+// [ErrNotFound] is returned if the value is not of type T.
+func cachedAs[T any](h *Hashive, path []string) (t T, err error) {
+	v, err := h.cachedValue(path)
 	if err != nil {
 		return
 	}
-	if len(path) == 1 {
-		return value, err
-	} else if obj, ok := value.(*impl.Object); ok {
-		return queryObject(path[1:], obj)
-	} else if ary, ok := value.(*impl.Array); ok {
-		return queryArray(path[1:], ary)
+	t, ok := v.(T)
+	if !ok {
+		err = ErrNotFound
+	}
+	return
+}
+
+// ValueCacheStats returns the statistics of the value cache.
+// The zero CacheStats is returned if the cache is not enabled by [WithValueCache].
+func (h *Hashive) ValueCacheStats() CacheStats {
+	if h.valueCache == nil {
+		return CacheStats{}
+	}
+	return h.valueCache.stats()
+}
+
+// PathCacheStats returns the statistics of the path cache.
+// The zero CacheStats is returned if the cache is not enabled by [WithPathCache].
+func (h *Hashive) PathCacheStats() CacheStats {
+	if h.pathCache == nil {
+		return CacheStats{}
+	}
+	return h.pathCache.stats()
+}
+
+// notFound converts an [impl.TypeError] to [ErrNotFound].
+func notFound(err error) error {
+	var typeErr *impl.TypeError
+	if errors.As(err, &typeErr) {
+		return ErrNotFound
 	}
-	return nil, ErrNotFound
+	return err
 }
@@ -2,12 +2,25 @@ package hashive_test
 
 import (
 	"bytes"
+	"context"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
 	"os"
 	"path/filepath"
 	"reflect"
+	"runtime"
+	"slices"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
 	"testing"
+	"time"
 
 	"github.com/mkch/hashive"
+	"github.com/mkch/hashive/internal/impl"
 )
 
 func TestWriteRead(t *testing.T) {
@@ -101,3 +114,1950 @@ func TestWriteJSONString(t *testing.T) {
 		})
 	}
 }
+
+func TestOpenMmap(t *testing.T) {
+	const filename = "testdata/mmap.hashive"
+	os.MkdirAll(filepath.Dir(filepath.Clean(filename)), 0777)
+	defer os.Remove(filename)
+
+	err := hashive.WriteFile(filename, map[string]any{
+		"name":    "mkch",
+		"hobbies": []any{"programming", "ping-pong"},
+		"addr":    map[string]any{"line1": "abc street"},
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	h, close, err := hashive.OpenMmap(filename)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer close()
+
+	if v, err := h.Query("name"); err != nil {
+		t.Fatal(err)
+	} else if v != "mkch" {
+		t.Fatal(v)
+	}
+	if v, err := h.Query("hobbies", "1"); err != nil {
+		t.Fatal(err)
+	} else if v != "ping-pong" {
+		t.Fatal(v)
+	}
+	if v, err := h.Query("addr", "line1"); err != nil {
+		t.Fatal(err)
+	} else if v != "abc street" {
+		t.Fatal(v)
+	}
+	if v, err := h.Query("addr", "line2"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	} else if v != nil {
+		t.Fatal(v)
+	}
+}
+
+func TestLayout(t *testing.T) {
+	value := map[string]any{
+		"a":    map[string]any{"b": []any{int64(1), map[string]any{"c": "d"}}},
+		"long": strings.Repeat("x", 100),
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	layout, err := h.Layout(1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(layout.Levels) != 4 || layout.Levels[0].Keys != 2 || layout.Levels[3].Keys != 1 {
+		t.Fatalf("%+v", layout.Levels)
+	}
+	if layout.Size >= int64(buf.Len()) || len(layout.Largest) != 1 || layout.Largest[0].Path[0] != "long" {
+		t.Fatalf("%+v", layout)
+	}
+}
+
+func TestWarm(t *testing.T) {
+	const filename = "testdata/warm.hashive"
+	os.MkdirAll(filepath.Dir(filepath.Clean(filename)), 0777)
+	defer os.Remove(filename)
+
+	value := map[string]any{
+		"a": map[string]any{"b": []any{int64(1), map[string]any{"c": "d"}}},
+		"e": []any{"f", []any{true}},
+	}
+	for _, opts := range [][]hashive.WriteOption{nil, {hashive.WithMinimalPerfectHash()}} {
+		if err := hashive.WriteFile(filename, value, opts...); err != nil {
+			t.Fatal(err)
+		}
+		data, err := os.ReadFile(filename)
+		if err != nil {
+			t.Fatal(err)
+		}
+		mmap, closeMmap, err := hashive.OpenMmap(filename)
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer closeMmap()
+		file, closeFile, err := hashive.Open(filename, -1)
+		if err != nil {
+			t.Fatal(err)
+		}
+		defer closeFile()
+		bytesHashive, err := hashive.NewFromBytes(data)
+		if err != nil {
+			t.Fatal(err)
+		}
+		for _, h := range []*hashive.Hashive{mmap, file, bytesHashive} {
+			for _, level := range []hashive.WarmLevel{hashive.WarmRoot, hashive.WarmTables, hashive.WarmAll} {
+				if err := h.Warm(level); err != nil {
+					t.Fatal(level, err)
+				}
+			}
+			if s, err := h.QueryString("a", "b", "1", "c"); err != nil || s != "d" {
+				t.Fatal(s, err)
+			}
+		}
+		if err := mmap.Warm(hashive.WarmAll + 1); err == nil {
+			t.Fatal("invalid level")
+		}
+	}
+}
+
+func TestWarmReads(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = map[string]any{"k": strings.Repeat("v", 100)}
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	data := buf.Bytes()
+	r := &countingReaderAt{r: bytes.NewReader(data)}
+	h, err := hashive.NewReaderAt(r, 64)
+	if err != nil {
+		t.Fatal(err)
+	}
+	layout, err := h.Layout(0)
+	if err != nil {
+		t.Fatal(err)
+	}
+	rootTable := layout.Levels[0].TableBytes
+
+	// The header and the table of the root at the front of the file.
+	r.reset()
+	if err := h.Warm(hashive.WarmRoot); err != nil {
+		t.Fatal(err)
+	}
+	if end := r.end.Load(); end < rootTable || end > rootTable+64 {
+		t.Fatal(end, rootTable)
+	}
+	// The tables of the nested objects, found by reading the lists.
+	r.reset()
+	if err := h.Warm(hashive.WarmTables); err != nil {
+		t.Fatal(err)
+	}
+	if n := r.bytes.Load(); n < rootTable+layout.Levels[1].TableBytes || r.end.Load() < int64(len(data))*9/10 {
+		t.Fatal(n, r.end.Load(), len(data))
+	}
+	r.reset()
+	if err := h.Warm(hashive.WarmAll); err != nil {
+		t.Fatal(err)
+	}
+	if n := r.bytes.Load(); n != int64(len(data)) {
+		t.Fatal(n, len(data))
+	}
+
+	// Nothing is read in memory.
+	resident, err := hashive.NewFromBytes(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, level := range []hashive.WarmLevel{hashive.WarmRoot, hashive.WarmTables, hashive.WarmAll} {
+		if allocs := testing.AllocsPerRun(10, func() { resident.Warm(level) }); allocs != 0 {
+			t.Fatal(level, allocs)
+		}
+	}
+}
+
+func TestNewFromBytes(t *testing.T) {
+	var buf bytes.Buffer
+	value := []any{"abc", map[string]any{"k": []byte{1, 2, 3}}}
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if v, err := h.Query("1", "k"); err != nil {
+		t.Fatal(err)
+	} else if !bytes.Equal(v.([]byte), []byte{1, 2, 3}) {
+		t.Fatal(v)
+	}
+	if v, err := h.Query(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(v, value) {
+		t.Fatal(v)
+	}
+
+	if _, err := hashive.NewFromBytes(buf.Bytes()[:4]); err == nil {
+		t.Fatal("truncated data")
+	}
+}
+
+func TestConcurrentQuery(t *testing.T) {
+	const n = 1000
+	value := make(map[string]any, n)
+	for i := range n {
+		value[strconv.Itoa(i)] = []any{i, strconv.Itoa(i)}
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+
+	for name, opts := range map[string][]hashive.Option{
+		"default": nil,
+		"cached":  {hashive.WithPathCache(64), hashive.WithValueCache(64 << 10)},
+	} {
+		h, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), 16, opts...)
+		if err != nil {
+			t.Fatal(err)
+		}
+		var wg sync.WaitGroup
+		for g := range 8 {
+			wg.Add(1)
+			go func() {
+				defer wg.Done()
+				for i := g; i < n; i += 3 {
+					key := strconv.Itoa(i)
+					if v, err := h.Query(key, "1"); err != nil {
+						t.Error(name, err)
+						return
+					} else if v != key {
+						t.Errorf("%v: Query(%v) = %v", name, key, v)
+						return
+					}
+				}
+			}()
+		}
+		wg.Wait()
+	}
+}
+
+func TestTypedQuery(t *testing.T) {
+	var buf bytes.Buffer
+	err := hashive.Write(&buf, map[string]any{
+		"str":   "abc",
+		"bytes": []byte{1, 2, 3},
+		"int":   int8(-5),
+		"big":   int64(-1 << 40),
+		"uint":  uint8(5),
+		"float": 1.5,
+		"bool":  true,
+		"ary":   []any{map[string]any{"k": "v"}},
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	if s, err := h.QueryString("str"); err != nil || s != "abc" {
+		t.Fatal(s, err)
+	}
+	if s, err := h.QueryString("ary", "0", "k"); err != nil || s != "v" {
+		t.Fatal(s, err)
+	}
+	if p, err := h.QueryBytesInto([]byte{0}, "bytes"); err != nil || !bytes.Equal(p, []byte{0, 1, 2, 3}) {
+		t.Fatal(p, err)
+	}
+	if p, err := h.QueryBytesInto(nil, "str"); err != nil || string(p) != "abc" {
+		t.Fatal(p, err)
+	}
+	if n, err := h.QueryInt("int"); err != nil || n != -5 {
+		t.Fatal(n, err)
+	}
+	if n, err := h.QueryInt("big"); err != nil || n != -1<<40 {
+		t.Fatal(n, err)
+	}
+	if n, err := h.QueryUint("uint"); err != nil || n != 5 {
+		t.Fatal(n, err)
+	}
+	if f, err := h.QueryFloat("float"); err != nil || f != 1.5 {
+		t.Fatal(f, err)
+	}
+	if b, err := h.QueryBool("bool"); err != nil || !b {
+		t.Fatal(b, err)
+	}
+
+	// Type mismatch
+	if _, err := h.QueryInt("str"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if _, err := h.QueryBytesInto(nil, "int"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	// Missing
+	if _, err := h.QueryString("str", "k"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if _, err := h.QueryString("missing"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+}
+
+func TestQueryAllocs(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 100 {
+		value[strconv.Itoa(i)] = map[string]any{"n": i, "s": strconv.Itoa(i)}
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	fromBytes, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	fromReaderAt, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), -1)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	for name, h := range map[string]*hashive.Hashive{"bytes": fromBytes, "ReaderAt": fromReaderAt} {
+		p := make([]byte, 0, 16)
+		tests := map[string]func(){
+			"int hit":   func() { h.QueryInt("42", "n") },
+			"bytes hit": func() { h.QueryBytesInto(p[:0], "42", "s") },
+			"miss":      func() { h.QueryInt("42", "missing") },
+			"root miss": func() { h.QueryInt("missing", "n") },
+		}
+		for testName, f := range tests {
+			if allocs := testing.AllocsPerRun(100, f); allocs != 0 {
+				t.Errorf("%v %v: %v allocs", name, testName, allocs)
+			}
+		}
+	}
+}
+
+func TestWithMinimalPerfectHash(t *testing.T) {
+	var buf bytes.Buffer
+	err := hashive.WriteJSONString(&buf, `{"a":{"b":[1,{"c":"d"}]},"e":true}`, hashive.WithMinimalPerfectHash())
+	if err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if s, err := h.QueryString("a", "b", "1", "c"); err != nil || s != "d" {
+		t.Fatal(s, err)
+	}
+	if _, err := h.Query("a", "c"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if v, err := h.Query(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(v, map[string]any{"a": map[string]any{"b": []any{float64(1), map[string]any{"c": "d"}}}, "e": true}) {
+		t.Fatal(v)
+	}
+}
+
+// legacyPoint is a gob value of testdata/legacy.hashive.
+type legacyPoint struct{ X, Y int }
+
+func TestOpenLegacyFile(t *testing.T) {
+	value := map[string]any{"a": map[string]any{"b": "c"}, "d": []any{"e"}}
+	// Databases written before the file header are hashed with FNV-1a.
+	buf := bytes.NewBufferString("hashive\x00")
+	if err := impl.EncodeValue(buf, value, &impl.WriteOptions{Gob: impl.NewGobEncoder(), Hash: impl.HashFNV1a}); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if s, err := h.QueryString("a", "b"); err != nil || s != "c" {
+		t.Fatal(s, err)
+	}
+	if s, err := h.QueryString("d", "0"); err != nil || s != "e" {
+		t.Fatal(s, err)
+	}
+	if v, err := h.Query(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(v, value) {
+		t.Fatal(v)
+	}
+
+	// testdata/legacy.hashive is written by the first version of Write, whose gob
+	// values of the same type have the definition of it in the first one only:
+	//
+	//	{"p1": Point{1, 2}, "p2": Point{3, 4},
+	//	 "nested": {"p3": Point{5, 6}, "s": "str"},
+	//	 "array": [Point{7, 8}, Point{9, 10}, 11],
+	//	 "c": 1+2i, "c2": 3+4i}
+	data, err := os.ReadFile(filepath.Join("testdata", "legacy.hashive"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	fromBytes, err := hashive.NewFromBytes(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+	fromReaderAt, err := hashive.NewReaderAt(bytes.NewReader(data), -1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	points := map[string]legacyPoint{"p1": {1, 2}, "p2": {3, 4}, "nested/p3": {5, 6}, "array/0": {7, 8}, "array/1": {9, 10}}
+	for _, h := range []*hashive.Hashive{fromBytes, fromReaderAt} {
+		// In any order, concurrently.
+		var wg sync.WaitGroup
+		for path, want := range points {
+			wg.Add(1)
+			go func(path string, want legacyPoint) {
+				defer wg.Done()
+				var p legacyPoint
+				if err := h.QueryGob(&p, strings.Split(path, "/")...); err != nil || p != want {
+					t.Error(path, p, err)
+				}
+			}(path, want)
+		}
+		wg.Wait()
+		for path, want := range map[string]complex128{"c": 1 + 2i, "c2": 3 + 4i} {
+			var c complex128
+			if err := h.QueryGob(&c, path); err != nil || c != want {
+				t.Fatal(path, c, err)
+			}
+		}
+		if s, err := h.QueryString("nested", "s"); err != nil || s != "str" {
+			t.Fatal(s, err)
+		}
+	}
+}
+
+func TestBuilder(t *testing.T) {
+	for name, opts := range map[string][]hashive.WriteOption{
+		"chained": nil,
+		"mph":     {hashive.WithMinimalPerfectHash()},
+		"aligned": {hashive.WithAlignedLayout()},
+		"inline":  {hashive.WithInlineKeys(16)},
+		"pow2":    {hashive.WithPowerOfTwoBuckets(), hashive.WithInlineKeys(16)},
+		"filter":  {hashive.WithFilter()},
+		"sorted":  {hashive.WithSortedKeys(), hashive.WithAlignedLayout()},
+	} {
+		tempDir := t.TempDir()
+		var buf bytes.Buffer
+		b, err := hashive.NewBuilder(&buf, tempDir, opts...)
+		if err != nil {
+			t.Fatal(err)
+		}
+		const n = 1000
+		for i := range n {
+			if err := b.Add("key"+strconv.Itoa(i), map[string]any{"i": i, "s": []any{strconv.Itoa(i)}}); err != nil {
+				t.Fatal(name, err)
+			}
+		}
+		if l := b.Len(); l != n {
+			t.Fatal(name, l)
+		}
+		if err := b.Finish(); err != nil {
+			t.Fatal(name, err)
+		}
+		if err := b.Add("key", 1); err != hashive.ErrBuilderFinished {
+			t.Fatal(name, err)
+		}
+		if files, err := os.ReadDir(tempDir); err != nil || len(files) != 0 {
+			t.Fatal(name, files, err)
+		}
+
+		h, err := hashive.NewFromBytes(buf.Bytes())
+		if err != nil {
+			t.Fatal(name, err)
+		}
+		for i := range n {
+			if v, err := h.QueryInt("key"+strconv.Itoa(i), "i"); err != nil || v != int64(i) {
+				t.Fatal(name, i, v, err)
+			}
+			if s, err := h.QueryString("key"+strconv.Itoa(i), "s", "0"); err != nil || s != strconv.Itoa(i) {
+				t.Fatal(name, i, s, err)
+			}
+		}
+		if _, err := h.Query("key" + strconv.Itoa(n)); err != hashive.ErrNotFound {
+			t.Fatal(name, err)
+		}
+	}
+}
+
+func TestBuilderDuplicateKey(t *testing.T) {
+	tempDir := t.TempDir()
+	b, err := hashive.NewBuilder(io.Discard, tempDir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	b.Add("a", 1)
+	b.Add("b", 2)
+	b.Add("a", 3)
+	if err := b.Finish(); err == nil {
+		t.Fatal("duplicate key")
+	}
+	if files, err := os.ReadDir(tempDir); err != nil || len(files) != 0 {
+		t.Fatal(files, err)
+	}
+}
+
+func TestWithWorkers(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = []any{i, map[string]any{"s": strconv.Itoa(i)}}
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value, hashive.WithWorkers(4)); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := range 1000 {
+		if s, err := h.QueryString(strconv.Itoa(i), "1", "s"); err != nil || s != strconv.Itoa(i) {
+			t.Fatal(i, s, err)
+		}
+	}
+}
+
+func TestWithTypedArrays(t *testing.T) {
+	value := map[string]any{
+		"embedding": []float64{0.5, -0.25, 1},
+		"ticks":     []any{int64(3), int64(-1)},
+		"flags":     []bool{true, false, true},
+		"tags":      []string{"a", "bc"},
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value, hashive.WithTypedArrays()); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if v, err := h.Query("flags"); err != nil || !reflect.DeepEqual(v, []any{true, false, true}) {
+		t.Fatal(v, err)
+	}
+	if s, err := h.QueryString("tags", "1"); err != nil || s != "bc" {
+		t.Fatal(s, err)
+	}
+	if n, err := h.QueryInt("ticks", "1"); err != nil || n != -1 {
+		t.Fatal(n, err)
+	}
+	if _, err := h.QueryString("ticks", "1"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if floats, err := h.QueryFloats(nil, "embedding"); err != nil || !reflect.DeepEqual(floats, []float64{0.5, -0.25, 1}) {
+		t.Fatal(floats, err)
+	}
+	if ints, err := h.QueryInts(nil, "ticks"); err != nil || !reflect.DeepEqual(ints, []int64{3, -1}) {
+		t.Fatal(ints, err)
+	}
+	if _, err := h.QueryUints(nil, "ticks"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+}
+
+func TestWithCompression(t *testing.T) {
+	long := strings.Repeat("compressed value ", 100)
+	value := map[string]any{"long": long, "short": "short", "gob": struct{ S string }{long}}
+	var plain, compressed bytes.Buffer
+	if err := hashive.Write(&plain, value); err != nil {
+		t.Fatal(err)
+	}
+	if err := hashive.Write(&compressed, value, hashive.WithCompression([]byte("compressed value"), 0)); err != nil {
+		t.Fatal(err)
+	}
+	if compressed.Len() >= plain.Len()/5 {
+		t.Fatal(compressed.Len(), plain.Len())
+	}
+	for _, opts := range [][]hashive.Option{nil, {hashive.WithValueCache(1 << 20)}} {
+		h, err := hashive.NewFromBytes(compressed.Bytes(), opts...)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if s, err := h.QueryString("long"); err != nil || s != long {
+			t.Fatal(s, err)
+		}
+		if p, err := h.QueryBytesInto(nil, "long"); err != nil || string(p) != long {
+			t.Fatal(p, err)
+		}
+		if v, err := h.Query("short"); err != nil || v != "short" {
+			t.Fatal(v, err)
+		}
+		var gob struct{ S string }
+		if err := h.QueryGob(&gob, "gob"); err != nil || gob.S != long {
+			t.Fatal(gob, err)
+		}
+		if _, err := h.QueryInt("long"); err != hashive.ErrNotFound {
+			t.Fatal(err)
+		}
+	}
+}
+
+func TestWithStringPool(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = map[string]any{
+			"company": "Company " + strconv.Itoa(i%10) + " Corporation",
+			"id":      i,
+		}
+	}
+	var plain, pooled bytes.Buffer
+	if err := hashive.Write(&plain, value); err != nil {
+		t.Fatal(err)
+	}
+	if err := hashive.Write(&pooled, value, hashive.WithStringPool()); err != nil {
+		t.Fatal(err)
+	}
+	if pooled.Len() >= plain.Len()*3/4 {
+		t.Fatal(pooled.Len(), plain.Len())
+	}
+	h, err := hashive.NewFromBytes(pooled.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := range 1000 {
+		if s, err := h.QueryString(strconv.Itoa(i), "company"); err != nil || s != "Company "+strconv.Itoa(i%10)+" Corporation" {
+			t.Fatal(s, err)
+		}
+	}
+	if v, err := h.Query("7"); err != nil || !reflect.DeepEqual(v, map[string]any{"company": "Company 7 Corporation", "id": int64(7)}) {
+		t.Fatal(v, err)
+	}
+	if _, err := hashive.NewBuilder(io.Discard, t.TempDir(), hashive.WithStringPool()); err == nil {
+		t.Fatal("string pool of builder")
+	}
+}
+
+type codecUser struct {
+	Name  string
+	Score float64
+	Tags  []string
+}
+
+func TestWithCodec(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 100 {
+		value[strconv.Itoa(i)] = codecUser{Name: "user " + strconv.Itoa(i), Score: float64(i), Tags: []string{"a"}}
+	}
+	codec, err := hashive.NewStructCodec(codecUser{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	var gob, encoded bytes.Buffer
+	if err := hashive.Write(&gob, value); err != nil {
+		t.Fatal(err)
+	}
+	if err := hashive.Write(&encoded, value, hashive.WithCodec(codec)); err != nil {
+		t.Fatal(err)
+	}
+	if encoded.Len() >= gob.Len()/3 {
+		t.Fatal(encoded.Len(), gob.Len())
+	}
+	h, err := hashive.NewFromBytes(encoded.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := range 100 {
+		// Fields are decoded by name.
+		var user struct {
+			Tags []string
+			Name string
+		}
+		if err := h.QueryGob(&user, strconv.Itoa(i)); err != nil {
+			t.Fatal(err)
+		}
+		if user.Name != "user "+strconv.Itoa(i) || !reflect.DeepEqual(user.Tags, []string{"a"}) {
+			t.Fatal(user)
+		}
+	}
+	if err := hashive.Write(io.Discard, map[string]any{"a": struct{}{}}, hashive.WithCodec(codec)); err == nil {
+		t.Fatal("unregistered type")
+	}
+}
+
+func TestWithInlineKeys(t *testing.T) {
+	value := map[string]any{"a": map[string]any{"b": []any{int64(1), map[string]any{"c": "d"}}}, "e": true}
+	for i := range 100 {
+		value[fmt.Sprintf("%06x", i*0x10101)] = strconv.Itoa(i)
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value, hashive.WithInlineKeys(6)); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i := range 100 {
+		if s, err := h.QueryString(fmt.Sprintf("%06x", i*0x10101)); err != nil || s != strconv.Itoa(i) {
+			t.Fatal(i, s, err)
+		}
+	}
+	if s, err := h.QueryString("a", "b", "1", "c"); err != nil || s != "d" {
+		t.Fatal(s, err)
+	}
+	if _, err := h.Query("a", "c"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if v, err := h.Query(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(v, value) {
+		t.Fatal(v)
+	}
+}
+
+func TestWithPowerOfTwoBuckets(t *testing.T) {
+	value := map[string]any{"a": map[string]any{"b": []any{int64(1), map[string]any{"c": "d"}}}, "e": true}
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = strconv.Itoa(i)
+	}
+	for _, opts := range [][]hashive.WriteOption{
+		{hashive.WithPowerOfTwoBuckets()},
+		{hashive.WithPowerOfTwoBuckets(), hashive.WithAlignedLayout()},
+		{hashive.WithPowerOfTwoBuckets(), hashive.WithInlineKeys(8)},
+	} {
+		var buf bytes.Buffer
+		var report hashive.WriteReport
+		if err := hashive.Write(&buf, value, append(opts, hashive.WithWriteReport(&report))...); err != nil {
+			t.Fatal(err)
+		}
+		if report.SlotObjects == 0 && report.Buckets != 2048+2+2 {
+			t.Fatal(report.Buckets)
+		}
+		h, err := hashive.NewFromBytes(buf.Bytes())
+		if err != nil {
+			t.Fatal(err)
+		}
+		for i := range 1000 {
+			if s, err := h.QueryString(strconv.Itoa(i)); err != nil || s != strconv.Itoa(i) {
+				t.Fatal(i, s, err)
+			}
+		}
+		if _, err := h.Query("1000"); err != hashive.ErrNotFound {
+			t.Fatal(err)
+		}
+		if v, err := h.Query(); err != nil {
+			t.Fatal(err)
+		} else if !reflect.DeepEqual(v, value) {
+			t.Fatal(v)
+		}
+	}
+}
+
+func TestWithFilter(t *testing.T) {
+	a := make(map[string]any)
+	for i := range 100 {
+		a["x"+strconv.Itoa(i)] = int64(i)
+	}
+	// Small objects have no filter.
+	value := map[string]any{"a": a, "small": map[string]any{"b": "c"}}
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = strconv.Itoa(i)
+	}
+	var buf bytes.Buffer
+	var report hashive.WriteReport
+	if err := hashive.Write(&buf, value, hashive.WithFilter(), hashive.WithWriteReport(&report)); err != nil {
+		t.Fatal(err)
+	}
+	if report.Filters != 2 || report.FilterBytes > (1000+100)*123/100+2*42 {
+		t.Fatal(report.Filters, report.FilterBytes)
+	}
+	fromBytes, err := hashive.NewFromBytes(buf.Bytes(), hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	fromReaderAt, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), -1, hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, h := range []*hashive.Hashive{fromBytes, fromReaderAt} {
+		for i := range 1000 {
+			if s, err := h.QueryString(strconv.Itoa(i)); err != nil || s != strconv.Itoa(i) {
+				t.Fatal(i, s, err)
+			}
+			if _, err := h.Query("a", strconv.Itoa(i)); err != hashive.ErrNotFound {
+				t.Fatal(err)
+			}
+			if _, err := h.Query("small", strconv.Itoa(i)); err != hashive.ErrNotFound {
+				t.Fatal(err)
+			}
+		}
+		reads := h.Stats().Reads
+		for i := range 1000 {
+			if _, err := h.Query("miss" + strconv.Itoa(i)); err != hashive.ErrNotFound {
+				t.Fatal(err)
+			}
+		}
+		// Only the descriptor of the root is read for a rejected key.
+		stats := h.Stats()
+		if stats.Filtered < 1990 || stats.Reads-reads > 1000+20 {
+			t.Fatalf("%+v", stats)
+		}
+		if allocs := testing.AllocsPerRun(100, func() { h.QueryInt("miss") }); allocs != 0 {
+			t.Fatal(allocs)
+		}
+		if v, err := h.Query(); err != nil || !reflect.DeepEqual(v, value) {
+			t.Fatal(v, err)
+		}
+		layout, err := h.Layout(0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if layout.Levels[0].Filters != 1 || layout.Levels[1].Filters != 1 {
+			t.Fatalf("%+v", layout.Levels)
+		}
+	}
+}
+
+func TestWithSortedKeys(t *testing.T) {
+	value := map[string]any{"nested": map[string]any{"b": "B", "a": "A", "c": "C"}}
+	var keys []string
+	for i := range 1000 {
+		key := fmt.Sprintf("user:%04d", i)
+		value[key] = int64(i)
+		keys = append(keys, key)
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value, hashive.WithSortedKeys()); err != nil {
+		t.Fatal(err)
+	}
+	fromBytes, err := hashive.NewFromBytes(buf.Bytes(), hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	fromReaderAt, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), -1, hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, h := range []*hashive.Hashive{fromBytes, fromReaderAt} {
+		var got []string
+		for k, v := range h.Prefix("user:012") {
+			if i, err := v.Int(); err != nil || fmt.Sprintf("user:%04d", i) != k {
+				t.Fatal(k, i, err)
+			}
+			got = append(got, k)
+		}
+		if !slices.Equal(got, keys[120:130]) {
+			t.Fatal(got)
+		}
+		// A range reads the keys in it, not the whole object.
+		probes := h.Stats().Probes
+		got = got[:0]
+		for k := range h.Range("user:0500", "user:0503") {
+			got = append(got, k)
+		}
+		if !slices.Equal(got, keys[500:503]) {
+			t.Fatal(got)
+		}
+		if n := h.Stats().Probes - probes; n > 40 {
+			t.Fatal(n)
+		}
+		got = got[:0]
+		for k, v := range h.Range("", "", "nested") {
+			if s, err := v.Str(); err != nil || s != strings.ToUpper(k) {
+				t.Fatal(k, s, err)
+			}
+			got = append(got, k)
+		}
+		if !slices.Equal(got, []string{"a", "b", "c"}) {
+			t.Fatal(got)
+		}
+		for _, v := range h.Prefix("", "user:0001") {
+			if v.Err() != hashive.ErrNotFound {
+				t.Fatal(v.Err())
+			}
+		}
+		if v, err := h.Query(); err != nil || !reflect.DeepEqual(v, value) {
+			t.Fatal(v, err)
+		}
+		layout, err := h.Layout(0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if layout.Levels[0].Sorted != 1 || layout.Levels[1].Sorted != 1 {
+			t.Fatalf("%+v", layout.Levels)
+		}
+	}
+}
+
+func TestExport(t *testing.T) {
+	value := map[string]any{
+		"null":   nil,
+		"int":    int64(-1),
+		"uint":   uint64(1),
+		"float":  1.5,
+		"bool":   true,
+		"bytes":  []byte("bytes"),
+		"long":   strings.Repeat("long", 100),
+		"object": map[string]any{"a": "b"},
+		"array":  []any{int64(1), "2"},
+	}
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = strconv.Itoa(i)
+	}
+	for name, opts := range map[string][]hashive.WriteOption{
+		"chained":     nil,
+		"mph":         {hashive.WithMinimalPerfectHash()},
+		"aligned":     {hashive.WithAlignedLayout()},
+		"inline":      {hashive.WithInlineKeys(16)},
+		"compression": {hashive.WithCompression(nil, 64), hashive.WithStringPool()},
+	} {
+		var buf bytes.Buffer
+		if err := hashive.Write(&buf, value, opts...); err != nil {
+			t.Fatal(name, err)
+		}
+		fromBytes, err := hashive.NewFromBytes(buf.Bytes())
+		if err != nil {
+			t.Fatal(name, err)
+		}
+		fromReaderAt, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), -1)
+		if err != nil {
+			t.Fatal(name, err)
+		}
+		for _, h := range []*hashive.Hashive{fromBytes, fromReaderAt} {
+			for _, workers := range []int{1, 4, 0} {
+				var mu sync.Mutex
+				got := make(map[string]any)
+				if err := h.Export(100, workers, func(batch *hashive.RecordBatch) error {
+					if batch.Len() > 100 {
+						t.Error(batch.Len())
+					}
+					mu.Lock()
+					defer mu.Unlock()
+					for i, key := range batch.Keys {
+						if _, ok := got[key]; ok {
+							t.Error("duplicate key", key)
+						}
+						got[key] = batch.Value(i)
+					}
+					return nil
+				}); err != nil {
+					t.Fatal(name, err)
+				}
+				if !reflect.DeepEqual(got, value) {
+					t.Fatal(name, workers, got)
+				}
+			}
+			// The values of the same type are in one column.
+			var strs atomic.Int64
+			if err := h.Export(0, 0, func(batch *hashive.RecordBatch) error {
+				strs.Add(int64(len(batch.Strings)))
+				return nil
+			}); err != nil || strs.Load() != 1001 {
+				t.Fatal(name, strs.Load(), err)
+			}
+			if err := h.Export(0, 0, func(*hashive.RecordBatch) error { return nil }, "array"); err != hashive.ErrNotFound {
+				t.Fatal(name, err)
+			}
+			errStop := errors.New("stop")
+			if err := h.Export(10, 4, func(batch *hashive.RecordBatch) error {
+				return errStop
+			}); err != errStop {
+				t.Fatal(name, err)
+			}
+			if err := h.Export(0, 0, func(*hashive.RecordBatch) error { return nil }, "missing"); err != hashive.ErrNotFound {
+				t.Fatal(name, err)
+			}
+		}
+	}
+}
+
+func TestWithAlignedLayout(t *testing.T) {
+	value := map[string]any{"a": map[string]any{"b": []any{int64(1), map[string]any{"c": "d"}}}, "e": true}
+	for i := range 100 {
+		value[strconv.Itoa(i)] = []any{strconv.Itoa(i)}
+	}
+	var plain, aligned bytes.Buffer
+	if err := hashive.Write(&plain, value); err != nil {
+		t.Fatal(err)
+	}
+	if err := hashive.Write(&aligned, value, hashive.WithAlignedLayout()); err != nil {
+		t.Fatal(err)
+	}
+	if aligned.Len() <= plain.Len() {
+		t.Fatal(aligned.Len(), plain.Len())
+	}
+	h, err := hashive.NewFromBytes(aligned.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if s, err := h.QueryString("a", "b", "1", "c"); err != nil || s != "d" {
+		t.Fatal(s, err)
+	}
+	for i := range 100 {
+		if s, err := h.QueryString(strconv.Itoa(i), "0"); err != nil || s != strconv.Itoa(i) {
+			t.Fatal(i, s, err)
+		}
+	}
+	if _, err := h.Query("a", "c"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if v, err := h.Query(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(v, value) {
+		t.Fatal(v)
+	}
+}
+
+func TestQueryMany(t *testing.T) {
+	var buf bytes.Buffer
+	if err := hashive.WriteJSONString(&buf, `{"a":{"b":1,"c":"d"},"e":true}`); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	values, errs := h.QueryMany([]string{"c", "x", "b"}, "a")
+	if !reflect.DeepEqual(values, []any{"d", nil, float64(1)}) {
+		t.Fatal(values)
+	}
+	if errs[0] != nil || errs[1] != hashive.ErrNotFound || errs[2] != nil {
+		t.Fatal(errs)
+	}
+	if _, errs := h.QueryMany([]string{"a"}, "x"); errs[0] != hashive.ErrNotFound {
+		t.Fatal(errs)
+	}
+}
+
+func TestWithPathCache(t *testing.T) {
+	var buf bytes.Buffer
+	err := hashive.Write(&buf, map[string]any{
+		"tenant": map[string]any{
+			"1": map[string]any{"settings": map[string]any{"a": "1a", "b": "1b"}},
+			"2": map[string]any{"settings": map[string]any{"a": "2a"}},
+		},
+	})
+	if err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes(), hashive.WithPathCache(1))
+	if err != nil {
+		t.Fatal(err)
+	}
+	queries := []struct {
+		path []string
+		want string
+	}{
+		{[]string{"tenant", "1", "settings", "a"}, "1a"},
+		{[]string{"tenant", "1", "settings", "b"}, "1b"},
+		{[]string{"tenant", "2", "settings", "a"}, "2a"},
+		{[]string{"tenant", "1", "settings", "a"}, "1a"},
+	}
+	for _, q := range queries {
+		if s, err := h.QueryString(q.path...); err != nil || s != q.want {
+			t.Fatal(q.path, s, err)
+		}
+	}
+	if _, err := h.QueryString("tenant", "2", "settings", "b"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if _, err := h.QueryString("tenant", "3", "settings", "a"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if stats := h.PathCacheStats(); stats != (hashive.CacheStats{Hits: 1, Misses: 5, Entries: 1}) {
+		t.Fatalf("%+v", stats)
+	}
+	dst := make([]byte, 0, 16)
+	if allocs := testing.AllocsPerRun(100, func() { h.QueryBytesInto(dst, "tenant", "1", "settings", "a") }); allocs != 0 {
+		t.Fatal(allocs)
+	}
+}
+
+func TestWithStats(t *testing.T) {
+	const filename = "testdata/stats.hashive"
+	os.MkdirAll(filepath.Dir(filepath.Clean(filename)), 0777)
+	defer os.Remove(filename)
+
+	value := map[string]any{"gob": []string{"a"}}
+	for i := range 100 {
+		value[strconv.Itoa(i)] = strconv.Itoa(i)
+	}
+	if err := hashive.WriteFile(filename, value); err != nil {
+		t.Fatal(err)
+	}
+	file, closeFile, err := hashive.Open(filename, -1, hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer closeFile()
+	mmap, closeMmap, err := hashive.OpenMmap(filename, hashive.WithStats())
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer closeMmap()
+	for _, h := range []*hashive.Hashive{file, mmap} {
+		for i := range 10 {
+			if s, err := h.QueryString(strconv.Itoa(i)); err != nil || s != strconv.Itoa(i) {
+				t.Fatal(s, err)
+			}
+		}
+		if _, err := h.Query("missing"); err != hashive.ErrNotFound {
+			t.Fatal(err)
+		}
+		var gob []string
+		if err := h.QueryGob(&gob, "gob"); err != nil {
+			t.Fatal(err)
+		}
+		stats := h.Stats()
+		if stats.Lookups != 12 || stats.NotFound != 1 || stats.Probes < 11 || stats.GobDecodes != 1 {
+			t.Fatalf("%+v", stats)
+		}
+		if (h == file) != (stats.Reads > 0 && stats.BytesRead > 0) {
+			t.Fatalf("%+v", stats)
+		}
+		var sum uint64
+		for _, n := range stats.Latency {
+			sum += n
+		}
+		if sum != stats.Lookups || stats.Latency.Quantile(0.5) <= 0 {
+			t.Fatal(stats.Latency)
+		}
+		var exported hashive.QueryStats
+		if err := json.Unmarshal([]byte(h.Expvar().String()), &exported); err != nil {
+			t.Fatal(err)
+		} else if exported.Lookups != stats.Lookups {
+			t.Fatalf("%+v", exported)
+		}
+	}
+
+	h, err := hashive.NewFromBytes([]byte("hashive\x01\x00\x00\x00"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if stats := h.Stats(); stats != (hashive.QueryStats{}) {
+		t.Fatalf("%+v", stats)
+	}
+}
+
+func TestWithWriteReport(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 1000 {
+		value[strconv.Itoa(i)] = []any{int64(i), map[string]any{"s": strconv.Itoa(i)}}
+	}
+	value["typed"] = []int{1, 2}
+	var report hashive.WriteReport
+	if err := hashive.Write(io.Discard, value, hashive.WithWriteReport(&report), hashive.WithTypedArrays(), hashive.WithWorkers(4)); err != nil {
+		t.Fatal(err)
+	}
+	if report.Objects != 1001 || report.Keys != 2001 || report.Arrays != 1001 || report.TypedArrays != 1 {
+		t.Fatalf("%+v", &report)
+	}
+	if report.Buckets < report.Keys || report.Lists > report.Keys || report.MaxChain < 1 || report.AvgChain() < 1 {
+		t.Fatalf("%+v", &report)
+	}
+	var tables int
+	for _, n := range report.OffsetSizes {
+		tables += n
+	}
+	if tables != report.Objects+report.Arrays-report.TypedArrays {
+		t.Fatal(report.OffsetSizes)
+	}
+}
+
+func TestWithValueCache(t *testing.T) {
+	value := map[string]any{
+		"s":   "str",
+		"b":   []byte("bytes"),
+		"i":   -1,
+		"u":   uint(1),
+		"f":   0.5,
+		"t":   true,
+		"gob": cachedPoint{1, 2},
+		"obj": map[string]any{"a": "b"},
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes(), hashive.WithValueCache(1<<20))
+	if err != nil {
+		t.Fatal(err)
+	}
+	for range 2 {
+		if s, err := h.QueryString("s"); err != nil || s != "str" {
+			t.Fatal(s, err)
+		}
+		if p, err := h.QueryBytesInto(nil, "b"); err != nil || string(p) != "bytes" {
+			t.Fatal(p, err)
+		}
+		if n, err := h.QueryInt("i"); err != nil || n != -1 {
+			t.Fatal(n, err)
+		}
+		if n, err := h.QueryUint("u"); err != nil || n != 1 {
+			t.Fatal(n, err)
+		}
+		if f, err := h.QueryFloat("f"); err != nil || f != 0.5 {
+			t.Fatal(f, err)
+		}
+		if b, err := h.QueryBool("t"); err != nil || !b {
+			t.Fatal(b, err)
+		}
+		var p cachedPoint
+		if err := h.QueryGob(&p, "gob"); err != nil || p != (cachedPoint{1, 2}) {
+			t.Fatal(p, err)
+		}
+		if v, err := h.Query("obj"); err != nil || !reflect.DeepEqual(v, map[string]any{"a": "b"}) {
+			t.Fatal(v, err)
+		}
+		if s, err := h.QueryString("obj", "a"); err != nil || s != "b" {
+			t.Fatal(s, err)
+		}
+		if _, err := h.QueryInt("s"); err != hashive.ErrNotFound {
+			t.Fatal(err)
+		}
+		if _, err := h.QueryString("x"); err != hashive.ErrNotFound {
+			t.Fatal(err)
+		}
+	}
+	// Objects are not cached, and missing paths are not cached.
+	if stats := h.ValueCacheStats(); stats.Hits != 10 || stats.Misses != 12 || stats.Entries != 8 {
+		t.Fatalf("%+v", stats)
+	}
+	if allocs := testing.AllocsPerRun(100, func() { h.QueryInt("i") }); allocs != 0 {
+		t.Fatal(allocs)
+	}
+
+	// Eviction
+	h, err = hashive.NewFromBytes(buf.Bytes(), hashive.WithValueCache(16*256))
+	if err != nil {
+		t.Fatal(err)
+	}
+	for range 100 {
+		for _, key := range []string{"s", "b", "i", "u", "f", "t"} {
+			if _, err := h.Query(key); err != nil {
+				t.Fatal(err)
+			}
+		}
+	}
+	if stats := h.ValueCacheStats(); stats.Entries == 0 || stats.Entries > 16*2 {
+		t.Fatalf("%+v", stats)
+	}
+
+	// Gob values larger than a shard are not cached.
+	buf.Reset()
+	big := cachedBlob{bytes.Repeat([]byte{1}, 1024)}
+	if err := hashive.Write(&buf, map[string]any{"gob": big}); err != nil {
+		t.Fatal(err)
+	}
+	h, err = hashive.NewFromBytes(buf.Bytes(), hashive.WithValueCache(16*256))
+	if err != nil {
+		t.Fatal(err)
+	}
+	for range 2 {
+		var b cachedBlob
+		if err := h.QueryGob(&b, "gob"); err != nil || !bytes.Equal(b.Data, big.Data) {
+			t.Fatal(b, err)
+		}
+	}
+	if stats := h.ValueCacheStats(); stats.Hits != 0 || stats.Entries != 0 {
+		t.Fatalf("%+v", stats)
+	}
+}
+
+type cachedPoint struct {
+	X, Y int
+}
+
+type cachedBlob struct {
+	Data []byte
+}
+
+func TestIterate(t *testing.T) {
+	value := map[string]any{
+		"obj":   map[string]any{"a": "1", "b": int64(2), "c": []any{"x", "y"}},
+		"array": []any{"0", int64(1), map[string]any{"k": "v"}},
+		"str":   "s",
+	}
+	for name, opts := range map[string][]hashive.WriteOption{
+		"chained": nil,
+		"mph":     {hashive.WithMinimalPerfectHash()},
+	} {
+		var buf bytes.Buffer
+		if err := hashive.Write(&buf, value, opts...); err != nil {
+			t.Fatal(name, err)
+		}
+		h, err := hashive.NewReaderAt(bytes.NewReader(buf.Bytes()), 8)
+		if err != nil {
+			t.Fatal(name, err)
+		}
+
+		got := make(map[string]any)
+		for k, v := range h.Entries("obj") {
+			if got[k], err = v.Decode(); err != nil {
+				t.Fatal(name, k, err)
+			}
+		}
+		if !reflect.DeepEqual(got, value["obj"]) {
+			t.Fatal(name, got)
+		}
+
+		var elems []any
+		for i, v := range h.Elements("array") {
+			if i != len(elems) {
+				t.Fatal(name, i)
+			}
+			elem, err := v.Decode()
+			if err != nil {
+				t.Fatal(name, i, err)
+			}
+			elems = append(elems, elem)
+		}
+		if !reflect.DeepEqual(elems, value["array"]) {
+			t.Fatal(name, elems)
+		}
+
+		// Nested iteration and early break.
+		var keys []string
+		for k, v := range h.Entries() {
+			keys = append(keys, k)
+			if k == "array" {
+				for _, elem := range v.Elements() {
+					if s, err := elem.Str(); err != nil || s != "0" {
+						t.Fatal(name, s, err)
+					}
+					break
+				}
+			}
+		}
+		if len(keys) != len(value) {
+			t.Fatal(name, keys)
+		}
+		for k := range h.Entries() {
+			keys = keys[:0]
+			keys = append(keys, k)
+			break
+		}
+		if len(keys) != 1 {
+			t.Fatal(name, keys)
+		}
+
+		for _, path := range [][]string{{"str"}, {"missing"}} {
+			n := 0
+			for _, v := range h.Entries(path...) {
+				if v.Err() != hashive.ErrNotFound {
+					t.Fatal(name, path, v.Err())
+				}
+				n++
+			}
+			if n != 1 {
+				t.Fatal(name, path, n)
+			}
+		}
+	}
+}
+
+type layeredGob struct {
+	N int
+}
+
+// newLayered returns a Layered of base and the deltas written to memory.
+func newLayered(t *testing.T, base any, deltas ...*hashive.Delta) *hashive.Layered {
+	t.Helper()
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, base); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	var layers []*hashive.Hashive
+	for _, d := range deltas {
+		var buf bytes.Buffer
+		if err := hashive.WriteDelta(&buf, d); err != nil {
+			t.Fatal(err)
+		}
+		layer, err := hashive.NewFromBytes(buf.Bytes())
+		if err != nil {
+			t.Fatal(err)
+		}
+		layers = append(layers, layer)
+	}
+	l, err := hashive.NewLayered(h, layers...)
+	if err != nil {
+		t.Fatal(err)
+	}
+	return l
+}
+
+func TestLayered(t *testing.T) {
+	base := map[string]any{
+		"a":     map[string]any{"b": "base", "c": int64(1), "arr": []any{int64(0), map[string]any{"x": true}}},
+		"gob":   layeredGob{1},
+		"gone":  "base",
+		"other": "base",
+	}
+	d1 := hashive.NewDelta()
+	d1.Set("d1", "a", "b")
+	d1.Set(map[string]any{"y": int64(2)}, "new")
+	d1.Delete("gone")
+	d1.Set(layeredGob{2}, "gob")
+	d2 := hashive.NewDelta()
+	d2.Set(int64(3), "new", "z")
+	d2.Set(false, "a", "arr", "1", "x")
+	d2.Delete("a", "c")
+	d2.Set("d2", "gone", "again")
+	l := newLayered(t, base, d1, d2)
+
+	for path, want := range map[string]any{
+		"a/b":         "d1",
+		"other":       "base",
+		"new/y":       int64(2),
+		"new/z":       int64(3),
+		"a/arr/1/x":   false,
+		"gone/again":  "d2",
+		"a/arr/0":     int64(0),
+		"new":         map[string]any{"y": int64(2), "z": int64(3)},
+		"gone":        map[string]any{"again": "d2"},
+		"a/arr":       []any{int64(0), map[string]any{"x": false}},
+		"a":           map[string]any{"b": "d1", "arr": []any{int64(0), map[string]any{"x": false}}},
+		"missing/key": nil,
+		"a/c":         nil,
+	} {
+		v, err := l.Query(strings.Split(path, "/")...)
+		if want == nil {
+			if err != hashive.ErrNotFound {
+				t.Fatal(path, v, err)
+			}
+		} else if err != nil || !reflect.DeepEqual(v, want) {
+			t.Fatal(path, v, err)
+		}
+	}
+	if s, err := l.QueryString("a", "b"); err != nil || s != "d1" {
+		t.Fatal(s, err)
+	}
+	if n, err := l.QueryInt("new", "z"); err != nil || n != 3 {
+		t.Fatal(n, err)
+	}
+	if _, err := l.QueryString("gone"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if _, err := l.QueryInt("a", "c"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	var gob layeredGob
+	if err := l.QueryGob(&gob, "gob"); err != nil || gob.N != 2 {
+		t.Fatal(gob, err)
+	}
+
+	var compacted bytes.Buffer
+	if err := hashive.Compact(&compacted, l, t.TempDir()); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(compacted.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	want, err := l.Query()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if v, err := h.Query(); err != nil || !reflect.DeepEqual(v, want) {
+		t.Fatal(v, err)
+	}
+	if err := h.QueryGob(&gob, "gob"); err != nil || gob.N != 2 {
+		t.Fatal(gob, err)
+	}
+
+	// The root is replaced.
+	d3 := hashive.NewDelta()
+	d3.Set([]any{"root"})
+	l = newLayered(t, base, d1, d3)
+	if v, err := l.Query(); err != nil || !reflect.DeepEqual(v, []any{"root"}) {
+		t.Fatal(v, err)
+	}
+	compacted.Reset()
+	if err := hashive.Compact(&compacted, l, t.TempDir()); err != nil {
+		t.Fatal(err)
+	}
+	if h, err = hashive.NewFromBytes(compacted.Bytes()); err != nil {
+		t.Fatal(err)
+	}
+	if s, err := h.QueryString("0"); err != nil || s != "root" {
+		t.Fatal(s, err)
+	}
+
+	// A base is not a delta.
+	var buf bytes.Buffer
+	hashive.Write(&buf, base)
+	h, _ = hashive.NewFromBytes(buf.Bytes())
+	if _, err := hashive.NewLayered(h, h); err == nil {
+		t.Fatal("not a delta")
+	}
+}
+
+// writeLayer writes a base database of v, or a delta database if v is a [hashive.Delta].
+func writeLayer(t *testing.T, v any, opts ...hashive.WriteOption) *hashive.Hashive {
+	t.Helper()
+	var buf bytes.Buffer
+	var err error
+	if d, ok := v.(*hashive.Delta); ok {
+		err = hashive.WriteDelta(&buf, d, opts...)
+	} else {
+		err = hashive.Write(&buf, v, opts...)
+	}
+	if err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	return h
+}
+
+func TestCompactGob(t *testing.T) {
+	// The values encoded by a codec are copied with the codec of the base.
+	codec, err := hashive.NewStructCodec(codecUser{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	d := hashive.NewDelta()
+	d.Set(codecUser{Name: "b", Score: 2}, "b")
+	base := writeLayer(t, map[string]any{"a": codecUser{Name: "a", Score: 1}}, hashive.WithCodec(codec))
+	l, err := hashive.NewLayered(base, writeLayer(t, d, hashive.WithCodec(codec)))
+	if err != nil {
+		t.Fatal(err)
+	}
+	var compacted bytes.Buffer
+	if err := hashive.Compact(&compacted, l, t.TempDir()); err != nil {
+		t.Fatal(err)
+	}
+	h, err := hashive.NewFromBytes(compacted.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for key, want := range map[string]codecUser{"a": {Name: "a", Score: 1}, "b": {Name: "b", Score: 2}} {
+		var user codecUser
+		if err := h.QueryGob(&user, key); err != nil || !reflect.DeepEqual(user, want) {
+			t.Fatal(key, user, err)
+		}
+	}
+	other, err := hashive.NewStructCodec(layeredGob{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := hashive.Compact(io.Discard, l, t.TempDir(), hashive.WithCodec(other)); err == nil {
+		t.Fatal("codec changed")
+	}
+	otherDelta := hashive.NewDelta()
+	otherDelta.Set(layeredGob{1}, "b")
+	if _, err := hashive.NewLayered(base, writeLayer(t, otherDelta, hashive.WithCodec(other))); err == nil {
+		t.Fatal("delta of another codec")
+	}
+	if _, err := hashive.NewLayered(base, writeLayer(t, hashive.NewDelta())); err == nil {
+		t.Fatal("delta of gob")
+	}
+
+	// The gob values of testdata/legacy.hashive, see TestOpenLegacyFile,
+	// are copied with the definitions of their types.
+	data, err := os.ReadFile(filepath.Join("testdata", "legacy.hashive"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	legacy, err := hashive.NewFromBytes(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+	d = hashive.NewDelta()
+	d.Set(legacyPoint{30, 40}, "p2")
+	d.Set(legacyPoint{50, 60}, "nested", "p4")
+	if l, err = hashive.NewLayered(legacy, writeLayer(t, d)); err != nil {
+		t.Fatal(err)
+	}
+	compacted.Reset()
+	if err := hashive.Compact(&compacted, l, t.TempDir()); err != nil {
+		t.Fatal(err)
+	}
+	if h, err = hashive.NewFromBytes(compacted.Bytes()); err != nil {
+		t.Fatal(err)
+	}
+	for path, want := range map[string]legacyPoint{"p1": {1, 2}, "p2": {30, 40}, "nested/p3": {5, 6}, "nested/p4": {50, 60}, "array/1": {9, 10}} {
+		var p legacyPoint
+		if err := h.QueryGob(&p, strings.Split(path, "/")...); err != nil || p != want {
+			t.Fatal(path, p, err)
+		}
+	}
+	var c complex128
+	if err := h.QueryGob(&c, "c2"); err != nil || c != 3+4i {
+		t.Fatal(c, err)
+	}
+}
+
+func TestDelta(t *testing.T) {
+	d := hashive.NewDelta()
+	d.Set("x", "a", "b", "c")
+	d.Set("y", "a", "b", "d")
+	// Replaces the changes under it.
+	d.Set(map[string]any{"e": "z"}, "a", "b")
+	if d.Len() != 1 {
+		t.Fatal(d.Len())
+	}
+	// Changes the value set.
+	if err := d.Set("w", "a", "b", "f"); err != nil {
+		t.Fatal(err)
+	}
+	if err := d.Delete("a", "b", "e"); err != nil {
+		t.Fatal(err)
+	}
+	if err := d.Set("v", "a", "b", "f", "g"); err == nil {
+		t.Fatal("set in a string")
+	}
+	// Sets under a deletion.
+	d.Delete("h")
+	d.Set("u", "h", "i")
+	d.Delete("h", "j")
+	if d.Len() != 2 {
+		t.Fatal(d.Len())
+	}
+	l := newLayered(t, map[string]any{"a": "base", "h": map[string]any{"j": "base", "k": "base"}}, d)
+	if v, err := l.Query(); err != nil || !reflect.DeepEqual(v, map[string]any{
+		"a": map[string]any{"b": map[string]any{"f": "w"}},
+		"h": map[string]any{"i": "u"},
+	}) {
+		t.Fatal(v, err)
+	}
+}
+
+func TestSharded(t *testing.T) {
+	dir := t.TempDir()
+	value := make(map[string]any)
+	for i := range 100 {
+		value[fmt.Sprintf("key%v", i)] = map[string]any{"i": int64(i), "s": fmt.Sprint(i)}
+	}
+	manifest := filepath.Join(dir, "db")
+	if err := hashive.WriteSharded(manifest, value, 4, 42, hashive.WithPowerOfTwoBuckets()); err != nil {
+		t.Fatal(err)
+	}
+	s, err := hashive.OpenSharded(manifest)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s.Close()
+	if s.Shards() != 4 {
+		t.Fatal(s.Shards())
+	}
+	for i := range 100 {
+		key := fmt.Sprintf("key%v", i)
+		if n, err := s.QueryInt(key, "i"); err != nil || n != int64(i) {
+			t.Fatal(key, n, err)
+		}
+		if str, err := s.QueryString(key, "s"); err != nil || str != fmt.Sprint(i) {
+			t.Fatal(key, str, err)
+		}
+	}
+	if _, err := s.Query("missing"); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if _, err := s.QueryInt(); err != hashive.ErrNotFound {
+		t.Fatal(err)
+	}
+	if v, err := s.Query(); err != nil || !reflect.DeepEqual(v, value) {
+		t.Fatal(v, err)
+	}
+	// Every shard holds the keys routed to it only.
+	for i := range s.Shards() {
+		h, err := s.Shard(i)
+		if err != nil {
+			t.Fatal(err)
+		}
+		for key := range h.Entries() {
+			if hashive.NewShardManifest("", 4, 42).Shard(key) != i {
+				t.Fatal(key, i)
+			}
+		}
+	}
+
+	// Shards built independently.
+	m := hashive.NewShardManifest("independent", 3, 7)
+	shards := make([]map[string]any, len(m.Shards))
+	for i := range shards {
+		shards[i] = make(map[string]any)
+	}
+	for key, v := range value {
+		shards[m.Shard(key)][key] = v
+	}
+	for i, shard := range shards {
+		if err := hashive.WriteFile(filepath.Join(dir, m.Shards[i]), shard); err != nil {
+			t.Fatal(err)
+		}
+	}
+	manifest = filepath.Join(dir, "independent")
+	if err := hashive.WriteShardManifest(manifest, m); err != nil {
+		t.Fatal(err)
+	}
+	s2, err := hashive.OpenSharded(manifest)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer s2.Close()
+	if v, err := s2.Query("key7"); err != nil || !reflect.DeepEqual(v, value["key7"]) {
+		t.Fatal(v, err)
+	}
+
+	// A shard is not a manifest.
+	if _, err := hashive.OpenSharded(filepath.Join(dir, m.Shards[0])); err == nil {
+		t.Fatal("not a manifest")
+	}
+}
+
+// countingReaderAt counts the reads of an io.ReaderAt.
+type countingReaderAt struct {
+	r     io.ReaderAt
+	reads atomic.Int64
+	bytes atomic.Int64 // bytes read
+	end   atomic.Int64 // the largest end of the reads
+}
+
+func (r *countingReaderAt) ReadAt(p []byte, off int64) (int, error) {
+	r.reads.Add(1)
+	n, err := r.r.ReadAt(p, off)
+	r.bytes.Add(int64(n))
+	for end := r.end.Load(); off+int64(n) > end && !r.end.CompareAndSwap(end, off+int64(n)); end = r.end.Load() {
+	}
+	return n, err
+}
+
+// reset resets the counts of r.
+func (r *countingReaderAt) reset() {
+	r.reads.Store(0)
+	r.bytes.Store(0)
+	r.end.Store(0)
+}
+
+// TestBlockCacheRetention keeps one block of every multi-block fetch cached,
+// and checks that the memory retained by the cache is bounded by maxBytes.
+func TestBlockCacheRetention(t *testing.T) {
+	const blockSize = 64 << 10
+	const run = 16       // blocks of a fetch
+	const survivors = 32 // fetches one block of which is kept
+	const maxBytes = (survivors + run) * blockSize
+	data := make([]byte, survivors*run*blockSize)
+	var before, after runtime.MemStats
+	runtime.GC()
+	runtime.ReadMemStats(&before)
+	cache := hashive.NewBlockCache(bytes.NewReader(data), blockSize, maxBytes)
+	p := make([]byte, run*blockSize)
+	var b [1]byte
+	for i := range survivors {
+		if _, err := cache.ReadAt(p, int64(i*run*blockSize)); err != nil {
+			t.Fatal(err)
+		}
+		// The first blocks of the fetches so far are the most recently used,
+		// so the fetch of the next run evicts the other blocks of this run.
+		for j := range i + 1 {
+			if _, err := cache.ReadAt(b[:], int64(j*run*blockSize)); err != nil {
+				t.Fatal(err)
+			}
+		}
+	}
+	if stats := cache.Stats(); stats.Fetches != survivors || stats.Entries < survivors {
+		t.Fatalf("%+v", stats)
+	}
+	p = nil
+	runtime.GC()
+	runtime.ReadMemStats(&after)
+	if retained := int64(after.HeapAlloc) - int64(before.HeapAlloc); retained > 2*maxBytes {
+		t.Fatal(retained, maxBytes)
+	}
+	runtime.KeepAlive(cache)
+	runtime.KeepAlive(data)
+}
+
+func TestBlockCache(t *testing.T) {
+	value := make(map[string]any)
+	for i := range 5000 {
+		value[strconv.Itoa(i)] = strings.Repeat("v", i%300)
+	}
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	data := buf.Bytes()
+
+	// Reads across blocks and the end.
+	r := &countingReaderAt{r: bytes.NewReader(data)}
+	cache := hashive.NewBlockCache(r, 100, 1000)
+	p := make([]byte, 450)
+	for _, off := range []int64{0, 30, 170, int64(len(data)) - 450} {
+		if n, err := cache.ReadAt(p, off); n != len(p) || err != nil || !bytes.Equal(p, data[off:off+450]) {
+			t.Fatal(off, n, err)
+		}
+	}
+	if n, err := cache.ReadAt(p, int64(len(data))-100); n != 100 || err != io.EOF || !bytes.Equal(p[:n], data[len(data)-100:]) {
+		t.Fatal(n, err)
+	}
+	if n, err := cache.ReadAt(p, int64(len(data))+100); n != 0 || err != io.EOF {
+		t.Fatal(n, err)
+	}
+	// Adjacent missing blocks are fetched at once.
+	if stats := cache.Stats(); stats.Entries > 10 || stats.Fetches != uint64(r.reads.Load()) || stats.Fetches > 7 {
+		t.Fatalf("%+v", stats)
+	}
+
+	r = &countingReaderAt{r: bytes.NewReader(data)}
+	cache = hashive.NewBlockCache(r, 0, len(data))
+	h, err := hashive.NewReaderAt(cache, -1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for round := range 2 {
+		for i := range 5000 {
+			before := r.reads.Load()
+			if s, err := h.QueryString(strconv.Itoa(i)); err != nil || s != value[strconv.Itoa(i)] {
+				t.Fatal(i, s, err)
+			}
+			if reads := r.reads.Load() - before; reads > 2 || round > 0 && reads > 0 {
+				t.Fatal(round, i, reads)
+			}
+		}
+	}
+	if stats := cache.Stats(); stats.BytesFetched != uint64(len(data)) || stats.HitRate() < 0.9 {
+		t.Fatalf("%+v", stats)
+	}
+
+	// Eviction
+	r = &countingReaderAt{r: bytes.NewReader(data)}
+	cache = hashive.NewBlockCache(r, 1024, 4096)
+	if h, err = hashive.NewReaderAt(cache, -1); err != nil {
+		t.Fatal(err)
+	}
+	for i := range 5000 {
+		if s, err := h.QueryString(strconv.Itoa(i)); err != nil || s != value[strconv.Itoa(i)] {
+			t.Fatal(i, s, err)
+		}
+	}
+	if stats := cache.Stats(); stats.Entries > 4 {
+		t.Fatalf("%+v", stats)
+	}
+}
+
+// slowReaderAt delays every read of an io.ReaderAt.
+type slowReaderAt struct {
+	r     io.ReaderAt
+	delay time.Duration
+}
+
+func (r *slowReaderAt) ReadAt(p []byte, off int64) (int, error) {
+	time.Sleep(r.delay)
+	return r.r.ReadAt(p, off)
+}
+
+func TestQueryContext(t *testing.T) {
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, map[string]any{"a": map[string]any{"b": "c"}}); err != nil {
+		t.Fatal(err)
+	}
+	slow := &slowReaderAt{r: bytes.NewReader(buf.Bytes())}
+	h, err := hashive.NewReaderAt(slow, -1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if v, err := h.QueryContext(context.Background(), "a", "b"); err != nil || v != "c" {
+		t.Fatal(v, err)
+	}
+	slow.delay = 100 * time.Millisecond
+	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Millisecond)
+	defer cancel()
+	start := time.Now()
+	if _, err := h.QueryContext(ctx, "a", "b"); err != context.DeadlineExceeded {
+		t.Fatal(err)
+	}
+	if elapsed := time.Since(start); elapsed > 50*time.Millisecond {
+		t.Fatal(elapsed)
+	}
+	// Done before the query.
+	if _, err := h.QueryContext(ctx, "a"); err != context.DeadlineExceeded {
+		t.Fatal(err)
+	}
+
+	h, _ = hashive.NewFromBytes(buf.Bytes())
+	if _, err := h.QueryContext(ctx, "a"); err != context.DeadlineExceeded {
+		t.Fatal(err)
+	}
+	if v, err := h.QueryContext(context.Background(), "a", "b"); err != nil || v != "c" {
+		t.Fatal(v, err)
+	}
+}
+
+func TestQueryBatch(t *testing.T) {
+	value := make(map[string]any)
+	var paths [][]string
+	for i := range 100 {
+		key := strconv.Itoa(i)
+		value[key] = map[string]any{"v": int64(i)}
+		paths = append(paths, []string{key, "v"})
+	}
+	paths = append(paths, []string{"missing"})
+	var buf bytes.Buffer
+	if err := hashive.Write(&buf, value); err != nil {
+		t.Fatal(err)
+	}
+	check := func(values []any, errs []error) {
+		t.Helper()
+		for i := range 100 {
+			if errs[i] != nil || values[i] != int64(i) {
+				t.Fatal(i, values[i], errs[i])
+			}
+		}
+		if errs[100] != hashive.ErrNotFound {
+			t.Fatal(errs[100])
+		}
+	}
+	hb, _ := hashive.NewFromBytes(buf.Bytes())
+	check(hb.QueryBatch(context.Background(), paths, 0))
+
+	slow := &slowReaderAt{r: bytes.NewReader(buf.Bytes())}
+	h, err := hashive.NewReaderAt(slow, -1)
+	if err != nil {
+		t.Fatal(err)
+	}
+	check(h.QueryBatch(context.Background(), paths, 4))
+	if values, errs := h.QueryBatch(context.Background(), nil, 0); len(values) != 0 || len(errs) != 0 {
+		t.Fatal(values, errs)
+	}
+
+	// The reads of the queries are in flight together.
+	slow.delay = time.Millisecond
+	start := time.Now()
+	check(h.QueryBatch(context.Background(), paths, 101))
+	if elapsed := time.Since(start); elapsed > 50*time.Millisecond {
+		t.Fatal(elapsed)
+	}
+
+	// The queries not finished before the deadline fail.
+	slow.delay = 20 * time.Millisecond
+	ctx, cancel := context.WithTimeout(context.Background(), 30*time.Millisecond)
+	defer cancel()
+	start = time.Now()
+	_, errs := h.QueryBatch(ctx, paths, 1)
+	if elapsed := time.Since(start); elapsed > 100*time.Millisecond {
+		t.Fatal(elapsed)
+	}
+	if errs[len(errs)-1] != context.DeadlineExceeded {
+		t.Fatal(errs[len(errs)-1])
+	}
+	_, errs = hb.QueryBatch(ctx, paths, 0)
+	if errs[0] != context.DeadlineExceeded {
+		t.Fatal(errs[0])
+	}
+}
@@ -0,0 +1,85 @@
+package impl
+
+import "io"
+
+// The aligned layout, see [WriteOptions.Aligned], places the structures read
+// by lookups at aligned positions of the file:
+//   - Offset tables of objects and arrays have 4 or 8 byte offsets.
+//   - The offset table of a [typeFingerprintObject] starts at a multiple of its offset size,
+//     and the object is marked with flag objectAligned.
+//   - The bucket lists of an aligned object are grouped into cache lines:
+//     a list whose length and fingerprints would cross a cache line
+//     starts at the next one.
+//   - Objects and arrays start at cache lines, so do the values after the header.
+//
+// Positions are aligned relative to the object or array that contains them,
+// and the header pads the file to a cache line (see [Header.Aligned]),
+// so they are aligned in the file as well.
+// Padding before bucket lists and entries of aligned objects is a sequence of padByte.
+
+// cacheLineSize is the alignment of the aligned layout.
+const cacheLineSize = 64
+
+// padByte pads the bucket lists of an aligned object.
+// It is never the first byte of a uvarint.
+const padByte = 0x80
+
+// Flags of [typeFingerprintObject].
+const objectAligned = 1 // the object is written in the aligned layout
+
+// alignUp rounds n up to a multiple of align.
+func alignUp(n, align int) int {
+	return (n + align - 1) / align * align
+}
+
+// alignedOffsetSize returns the size of offsets in the aligned layout
+// of a table whose max offset is maxOffset: 4 or 8.
+func alignedOffsetSize(maxOffset int) byte {
+	if fixedUintSize(uint64(maxOffset)) <= 4 {
+		return 4
+	}
+	return 8
+}
+
+// isContainer reports whether v is written as an object or an array,
+// which starts at a cache line in the aligned layout.
+func isContainer(v any) bool {
+	switch v.(type) {
+	case map[string]any, []any:
+		return true
+	default:
+		return false
+	}
+}
+
+// writePadding writes n bytes of b to w.
+func writePadding(w io.Writer, b byte, n int) (err error) {
+	if n <= 0 {
+		return
+	}
+	var buf [cacheLineSize]byte
+	for i := range buf[:min(n, len(buf))] {
+		buf[i] = b
+	}
+	for ; n > 0 && err == nil; n -= len(buf) {
+		_, err = w.Write(buf[:min(n, len(buf))])
+	}
+	return
+}
+
+// skipPadding skips the padding before a bucket list or an entry of aligned obj.
+func (obj *Object) skipPadding(r *reader) (err error) {
+	if !obj.aligned {
+		return
+	}
+	for {
+		var b byte
+		if b, err = r.ReadByte(); err != nil {
+			return
+		}
+		if b != padByte {
+			r.seek(r.pos() - 1)
+			return
+		}
+	}
+}
@@ -0,0 +1,113 @@
+package impl
+
+import (
+	"bytes"
+	"reflect"
+	"strconv"
+	"testing"
+)
+
+// checkAligned checks the aligned layout of v and the values in it.
+func checkAligned(t *testing.T, v Value) {
+	t.Helper()
+	if obj, err := v.Object(); err == nil {
+		if v.pos%cacheLineSize != 0 {
+			t.Fatal("object at", v.pos)
+		}
+		if obj.layout == typeMPHObject {
+			return
+		}
+		if !obj.aligned || (obj.offsetSize != 4 && obj.offsetSize != 8) || obj.pos%int64(obj.offsetSize) != 0 {
+			t.Fatal(obj.aligned, obj.offsetSize, obj.pos)
+		}
+		r := obj.src.reader(obj.pos)
+		defer r.close()
+		for i := range obj.bucketCount {
+			if found, err := obj.seekBucket(&r, i); err != nil {
+				t.Fatal(err)
+			} else if !found {
+				continue
+			}
+			pos := r.pos()
+			listLen, err := readUintValue(&r)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if end := r.pos() + int64(listLen)*fingerprintSize - 1; pos/cacheLineSize != end/cacheLineSize {
+				t.Fatal("bucket list crosses a cache line", pos, end)
+			}
+		}
+		if err := obj.Range(func(key string, value Value) bool {
+			checkAligned(t, value)
+			return true
+		}); err != nil {
+			t.Fatal(err)
+		}
+	} else if array, err := v.Array(); err == nil {
+		if v.pos%cacheLineSize != 0 {
+			t.Fatal("array at", v.pos)
+		}
+		if array.elem != typeNull {
+			return
+		}
+		if array.offsetSize != 4 && array.offsetSize != 8 {
+			t.Fatal(array.offsetSize)
+		}
+		if err := array.Range(func(i int, elem Value) bool {
+			checkAligned(t, elem)
+			return true
+		}); err != nil {
+			t.Fatal(err)
+		}
+	}
+}
+
+func TestAlignedLayout(t *testing.T) {
+	obj := map[string]any{"array": []any{"a", int64(1), map[string]any{"b": nil}, []any{true}}}
+	for i := range 100 {
+		key := strconv.Itoa(i)
+		obj[key] = map[string]any{key: []any{key}, "s": key}
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder(), Aligned: true},
+		{Gob: NewGobEncoder(), Aligned: true, MinimalPerfectHash: true},
+		{Gob: NewGobEncoder(), Aligned: true, TypedArrays: true},
+	} {
+		var buf bytes.Buffer
+		buf.WriteString("sig")
+		if err := WriteHeader(&buf, 3, opts.Header()); err != nil {
+			t.Fatal(err)
+		}
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		for _, src := range []*Source{NewBytesSource(buf.Bytes()), NewReaderAtSource(bytes.NewReader(buf.Bytes()), 16)} {
+			h, pos, err := src.ReadHeader(3)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if !h.Aligned || pos%cacheLineSize != 0 {
+				t.Fatal(h.Aligned, pos)
+			}
+			checkAligned(t, src.Value(pos))
+			if v, err := src.ReadValue(pos, true); err != nil {
+				t.Fatal(err)
+			} else if !reflect.DeepEqual(v, obj) {
+				t.Fatal(v)
+			}
+			for i := range 100 {
+				key := strconv.Itoa(i)
+				v, err := src.Value(pos).Lookup(key)
+				if err != nil {
+					t.Fatal(err)
+				}
+				if v, err = v.Lookup("s"); err != nil {
+					t.Fatal(err)
+				}
+				if s, err := v.Str(); err != nil || s != key {
+					t.Fatal(s, err)
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,135 @@
+package impl
+
+import (
+	"cmp"
+	"slices"
+)
+
+// batchLookup is a key being looked up by [Value.LookupMany].
+type batchLookup struct {
+	i    int // index of the key
+	hash uint64
+	slot uint64
+	pos  int64 // position of the next read
+}
+
+func sortLookups(lookups []batchLookup) {
+	slices.SortFunc(lookups, func(a, b batchLookup) int {
+		return cmp.Compare(a.pos, b.pos)
+	})
+}
+
+// LookupMany is like [Value.Lookup] with many keys.
+// The value and error of keys[i] are values[i] and errs[i].
+//
+// If v is an object, the keys are looked up in stages:
+// the slots of all the keys, then the offsets of their bucket lists,
+// and then the bucket lists. Every stage reads the source in the order
+// of positions, so a batch of lookups is a few forward sweeps
+// instead of random reads.
+func (v Value) LookupMany(keys []string) (values []Value, errs []error) {
+	values = make([]Value, len(keys))
+	errs = make([]error, len(keys))
+	fail := func(err error) {
+		for i := range errs {
+			errs[i] = err
+		}
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		fail(err)
+		return
+	}
+	tm := typeMarker(tb)
+	switch tm.Type() {
+	case typeObject, typeFingerprintObject, typeMPHObject:
+	default:
+		// The keys of a typeSlotObject are resolved in their slots, without stages.
+		for i, key := range keys {
+			values[i], errs[i] = v.Lookup(key)
+		}
+		return
+	}
+	var obj Object
+	if err = obj.read(&r, tm); err != nil {
+		fail(err)
+		return
+	}
+
+	lookups := make([]batchLookup, 0, len(keys))
+	for i, key := range keys {
+		l := batchLookup{i: i, hash: v.src.hash.sum(key)}
+		if obj.filter.rejects(l.hash) {
+			v.src.stats.filtered()
+			errs[i] = ErrNotFound
+			continue
+		}
+		lookups = append(lookups, l)
+	}
+	if obj.layout == typeMPHObject {
+		// The seeds are read in order.
+		for j := range lookups {
+			lookups[j].pos = obj.mph.seedsPos + int64(mphBucket(lookups[j].hash, obj.mph.buckets))*int64(obj.mph.seedSize)
+		}
+		sortLookups(lookups)
+	}
+	pending := lookups[:0]
+	for _, l := range lookups {
+		if l.slot, err = obj.slot(&r, l.hash); err != nil {
+			errs[l.i] = err
+			continue
+		}
+		l.pos = obj.pos + int64(l.slot)*int64(obj.offsetSize)
+		pending = append(pending, l)
+	}
+
+	// Read the offsets of bucket lists.
+	sortLookups(pending)
+	lists := pending[:0]
+	for _, l := range pending {
+		found, err := obj.seekBucket(&r, l.slot)
+		if err != nil {
+			errs[l.i] = err
+			continue
+		} else if !found {
+			errs[l.i] = ErrNotFound
+			continue
+		}
+		l.pos = r.pos()
+		lists = append(lists, l)
+	}
+
+	// Scan the bucket lists.
+	sortLookups(lists)
+	for _, l := range lists {
+		r.seek(l.pos)
+		if err := obj.scanList(&r, keys[l.i], l.hash); err != nil {
+			errs[l.i] = err
+			continue
+		}
+		values[l.i] = Value{src: v.src, pos: r.pos()}
+	}
+	return
+}
+
+// DecodeMany decodes values[i] if errs[i] is nil, in the order of positions.
+// The error of decoding values[i] is stored in errs[i].
+// See [ReadValue] for the meaning of recursive.
+func DecodeMany(values []Value, errs []error, recursive bool) (decoded []any) {
+	decoded = make([]any, len(values))
+	order := make([]int, 0, len(values))
+	for i := range values {
+		if errs[i] == nil {
+			order = append(order, i)
+		}
+	}
+	slices.SortFunc(order, func(a, b int) int {
+		return cmp.Compare(values[a].pos, values[b].pos)
+	})
+	for _, i := range order {
+		decoded[i], errs[i] = values[i].Decode(recursive)
+	}
+	return
+}
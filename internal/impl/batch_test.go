@@ -0,0 +1,53 @@
+package impl
+
+import (
+	"bytes"
+	"strconv"
+	"testing"
+)
+
+func TestLookupMany(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 1000 {
+		obj[strconv.Itoa(i)] = int64(i)
+	}
+	keys := []string{"999", "1000", "0", "500", "500", "abc", "1"}
+	for _, mph := range []bool{false, true} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, &WriteOptions{MinimalPerfectHash: mph}); err != nil {
+			t.Fatal(err)
+		}
+		for name, src := range map[string]*Source{
+			"bytes":    NewBytesSource(buf.Bytes()),
+			"readerAt": NewReaderAtSource(bytes.NewReader(buf.Bytes()), 64),
+		} {
+			values, errs := src.Value(0).LookupMany(keys)
+			decoded := DecodeMany(values, errs, false)
+			for i, key := range keys {
+				want, ok := obj[key]
+				if !ok {
+					if errs[i] != ErrNotFound {
+						t.Fatal(mph, name, key, errs[i])
+					}
+					continue
+				}
+				if errs[i] != nil || decoded[i] != want {
+					t.Fatal(mph, name, key, decoded[i], errs[i])
+				}
+			}
+		}
+	}
+
+	// Not an object.
+	var buf bytes.Buffer
+	if err := WriteValue(&buf, []any{"a", "b"}, nil); err != nil {
+		t.Fatal(err)
+	}
+	values, errs := NewBytesSource(buf.Bytes()).Value(0).LookupMany([]string{"1", "2"})
+	if errs[0] != nil || errs[1] == nil {
+		t.Fatal(errs)
+	}
+	if s, err := values[0].Str(); err != nil || s != "b" {
+		t.Fatal(s, err)
+	}
+}
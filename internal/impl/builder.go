@@ -0,0 +1,94 @@
+package impl
+
+import (
+	"bufio"
+	"io"
+)
+
+// SpillFile stores the encoded values of an [ObjectBuilder].
+// An [*os.File] opened for reading and writing is a SpillFile.
+type SpillFile interface {
+	io.Writer
+	io.ReaderAt
+}
+
+// ObjectBuilder writes an object that is added one entry at a time.
+// Values are encoded into a [SpillFile] as they are added,
+// and only the keys, hashes and value positions are kept in memory.
+type ObjectBuilder struct {
+	opts    *WriteOptions
+	spill   SpillFile
+	w       countingWriter
+	entries []objectEntry
+	buf     []byte // copy buffer of Finish
+}
+
+// NewObjectBuilder creates an ObjectBuilder that stores values in spill,
+// which must be empty.
+func NewObjectBuilder(spill SpillFile, opts *WriteOptions) *ObjectBuilder {
+	return &ObjectBuilder{
+		opts:  opts,
+		spill: spill,
+		w:     countingWriter{w: bufio.NewWriter(spill)},
+	}
+}
+
+// Len returns the number of entries added.
+func (b *ObjectBuilder) Len() int {
+	return len(b.entries)
+}
+
+// Add adds an entry of key and value.
+// Keys must be unique, which is checked by [ObjectBuilder.Finish].
+func (b *ObjectBuilder) Add(key string, value any) (err error) {
+	off := b.w.n
+	if err = EncodeValue(&b.w, value, b.opts); err != nil {
+		return
+	}
+	b.entries = append(b.entries, objectEntry{
+		key:       key,
+		hash:      b.opts.Hash.sum(key),
+		off:       off,
+		size:      b.w.n - off,
+		container: isContainer(value),
+	})
+	return
+}
+
+// Finish writes the object to w.
+// Values are copied from the spill file in the order of the hash table.
+func (b *ObjectBuilder) Finish(w io.Writer) (err error) {
+	if err = b.w.w.Flush(); err != nil {
+		return
+	}
+	b.buf = make([]byte, 32*1024)
+	return writeEntries(w, b.entries, b.opts, b.copy)
+}
+
+// copy writes the encoded value of e from the spill file to w.
+func (b *ObjectBuilder) copy(w io.Writer, e *objectEntry) (err error) {
+	n, err := io.CopyBuffer(w, io.NewSectionReader(b.spill, int64(e.off), int64(e.size)), b.buf)
+	if err == nil && uint64(n) != e.size {
+		err = io.ErrUnexpectedEOF
+	}
+	return
+}
+
+// countingWriter is a [ByteWriter] that counts the bytes written.
+type countingWriter struct {
+	w *bufio.Writer
+	n uint64
+}
+
+func (w *countingWriter) Write(p []byte) (n int, err error) {
+	n, err = w.w.Write(p)
+	w.n += uint64(n)
+	return
+}
+
+func (w *countingWriter) WriteByte(c byte) (err error) {
+	if err = w.w.WriteByte(c); err == nil {
+		w.n++
+	}
+	return
+}
@@ -0,0 +1,574 @@
+package impl
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"math"
+	"reflect"
+	"sync"
+)
+
+// Codec encodes the values of the types other than the built-in types,
+// which are stored as [typeGob]. See [WriteOptions.Codec].
+type Codec interface {
+	// Name is the name of the codec stored in the file header.
+	Name() string
+	// Schema returns the data of the codec stored in the file header.
+	Schema() []byte
+	// Encode returns the encoding of v.
+	Encode(v any) ([]byte, error)
+	// Decode decodes data into v.
+	Decode(data []byte, v any) error
+}
+
+// StructCodecName is the name of [StructCodec].
+const StructCodecName = "struct"
+
+// StructCodec is a [Codec] of registered struct types.
+// The schema of the types is stored once in the file header,
+// so a value is only a type id followed by its fields in order, without any field names:
+//   - bool is a byte.
+//   - Signed and unsigned integers are varints and uvarints.
+//   - float32 and float64 are the 8 bytes of their IEEE 754 representation.
+//   - string and []byte are a uvarint of length followed by the content.
+//   - A slice is a uvarint of length followed by the elements.
+//   - A struct is its fields in order.
+//
+// Values are decoded into the fields of the same names, with a decoding plan
+// created once for every pair of stored type and Go type.
+// A StructCodec is safe for concurrent use.
+type StructCodec struct {
+	types []structType
+	ids   map[reflect.Type]int // type ids of registered Go types
+	plans sync.Map             // planKey to *structPlan
+}
+
+type fieldKind byte
+
+const (
+	kindBool fieldKind = iota + 1
+	kindInt
+	kindUint
+	kindFloat
+	kindString
+	kindBytes
+	kindStruct
+	kindSlice
+)
+
+// fieldType is the type of a struct field in a schema.
+type fieldType struct {
+	kind fieldKind
+	id   int        // type id of kindStruct
+	elem *fieldType // element type of kindSlice
+}
+
+type structField struct {
+	name  string
+	typ   fieldType
+	index int // index of the Go field, only for registered types
+}
+
+type structType struct {
+	name   string
+	fields []structField
+}
+
+// NewStructCodec creates a StructCodec of the struct types of values.
+// The struct types of exported fields are registered too.
+// Fields can be bools, numbers, strings, []byte, structs and slices of them.
+func NewStructCodec(values ...any) (c *StructCodec, err error) {
+	c = &StructCodec{ids: make(map[reflect.Type]int)}
+	for _, v := range values {
+		t := reflect.TypeOf(v)
+		if t != nil && t.Kind() == reflect.Pointer {
+			t = t.Elem()
+		}
+		if t == nil || t.Kind() != reflect.Struct {
+			return nil, fmt.Errorf("invalid struct codec type %v", t)
+		}
+		if _, err = c.register(t); err != nil {
+			return nil, err
+		}
+	}
+	return
+}
+
+// register registers struct type t and returns its type id.
+func (c *StructCodec) register(t reflect.Type) (id int, err error) {
+	if id, ok := c.ids[t]; ok {
+		return id, nil
+	}
+	id = len(c.types)
+	c.ids[t] = id
+	c.types = append(c.types, structType{name: t.String()})
+	var fields []structField
+	for i := range t.NumField() {
+		f := t.Field(i)
+		if !f.IsExported() {
+			continue
+		}
+		var ft fieldType
+		if ft, err = c.fieldTypeOf(f.Type); err != nil {
+			return 0, fmt.Errorf("field %v of %v: %w", f.Name, t, err)
+		}
+		fields = append(fields, structField{name: f.Name, typ: ft, index: i})
+	}
+	c.types[id].fields = fields
+	return
+}
+
+// fieldTypeOf returns the fieldType of Go type t,
+// and registers t if it is a struct type.
+func (c *StructCodec) fieldTypeOf(t reflect.Type) (ft fieldType, err error) {
+	if ft.kind = kindOf(t); ft.kind == 0 {
+		err = fmt.Errorf("unsupported type %v", t)
+		return
+	}
+	switch ft.kind {
+	case kindStruct:
+		ft.id, err = c.register(t)
+	case kindSlice:
+		var elem fieldType
+		if elem, err = c.fieldTypeOf(t.Elem()); err == nil {
+			ft.elem = &elem
+		}
+	}
+	return
+}
+
+// kindOf returns the fieldKind of Go type t, or 0 if t is not supported.
+func kindOf(t reflect.Type) fieldKind {
+	switch t.Kind() {
+	case reflect.Bool:
+		return kindBool
+	case reflect.Int, reflect.Int8, reflect.Int16, reflect.Int32, reflect.Int64:
+		return kindInt
+	case reflect.Uint, reflect.Uint8, reflect.Uint16, reflect.Uint32, reflect.Uint64, reflect.Uintptr:
+		return kindUint
+	case reflect.Float32, reflect.Float64:
+		return kindFloat
+	case reflect.String:
+		return kindString
+	case reflect.Struct:
+		return kindStruct
+	case reflect.Slice:
+		if t.Elem().Kind() == reflect.Uint8 {
+			return kindBytes
+		}
+		return kindSlice
+	}
+	return 0
+}
+
+// Name implements [Codec].
+func (c *StructCodec) Name() string {
+	return StructCodecName
+}
+
+// Schema implements [Codec].
+// The schema is a uvarint of the number of types, followed by every type:
+// the name, a uvarint of the number of fields and every field.
+// A field is its name followed by its type: a byte of fieldKind, followed by
+// a uvarint of type id for structs, or the element type for slices.
+// Names are uvarints of length followed by the content.
+func (c *StructCodec) Schema() []byte {
+	p := binary.AppendUvarint(nil, uint64(len(c.types)))
+	for _, t := range c.types {
+		p = appendString(p, t.name)
+		p = binary.AppendUvarint(p, uint64(len(t.fields)))
+		for _, f := range t.fields {
+			p = appendString(p, f.name)
+			p = appendFieldType(p, &f.typ)
+		}
+	}
+	return p
+}
+
+func appendString(p []byte, s string) []byte {
+	p = binary.AppendUvarint(p, uint64(len(s)))
+	return append(p, s...)
+}
+
+func appendFieldType(p []byte, ft *fieldType) []byte {
+	p = append(p, byte(ft.kind))
+	switch ft.kind {
+	case kindStruct:
+		p = binary.AppendUvarint(p, uint64(ft.id))
+	case kindSlice:
+		p = appendFieldType(p, ft.elem)
+	}
+	return p
+}
+
+var errInvalidEncoding = errors.New("invalid struct codec encoding")
+
+// schemaReader reads a schema or a value of a StructCodec.
+type schemaReader struct {
+	p []byte
+}
+
+func (r *schemaReader) uvarint() (n uint64, err error) {
+	n, size := binary.Uvarint(r.p)
+	if size <= 0 {
+		return 0, errInvalidEncoding
+	}
+	r.p = r.p[size:]
+	return
+}
+
+// length reads a uvarint of length, which is at most max.
+func (r *schemaReader) length(max int) (n int, err error) {
+	u, err := r.uvarint()
+	if err == nil && (max < 0 || u > uint64(max)) {
+		err = errInvalidEncoding
+	}
+	return int(u), err
+}
+
+func (r *schemaReader) bytes() (p []byte, err error) {
+	n, err := r.length(len(r.p))
+	if err != nil {
+		return
+	}
+	p, r.p = r.p[:n:n], r.p[n:]
+	return
+}
+
+func (r *schemaReader) fieldType(types int, depth int) (ft fieldType, err error) {
+	if len(r.p) == 0 || depth > 100 {
+		err = errInvalidEncoding
+		return
+	}
+	ft.kind, r.p = fieldKind(r.p[0]), r.p[1:]
+	switch ft.kind {
+	case kindBool, kindInt, kindUint, kindFloat, kindString, kindBytes:
+	case kindStruct:
+		ft.id, err = r.length(types - 1)
+	case kindSlice:
+		var elem fieldType
+		if elem, err = r.fieldType(types, depth+1); err == nil {
+			ft.elem = &elem
+		}
+	default:
+		err = errInvalidEncoding
+	}
+	return
+}
+
+// OpenStructCodec creates a StructCodec from schema returned by [StructCodec.Schema].
+// The returned StructCodec decodes values only.
+func OpenStructCodec(schema []byte) (c *StructCodec, err error) {
+	r := schemaReader{schema}
+	n, err := r.length(len(schema))
+	if err != nil {
+		return
+	}
+	c = &StructCodec{types: make([]structType, n)}
+	for i := range c.types {
+		t := &c.types[i]
+		var name []byte
+		if name, err = r.bytes(); err != nil {
+			return nil, err
+		}
+		t.name = string(name)
+		var fields int
+		if fields, err = r.length(len(r.p)); err != nil {
+			return nil, err
+		}
+		t.fields = make([]structField, fields)
+		for j := range t.fields {
+			if name, err = r.bytes(); err != nil {
+				return nil, err
+			}
+			t.fields[j].name = string(name)
+			if t.fields[j].typ, err = r.fieldType(n, 0); err != nil {
+				return nil, err
+			}
+			t.fields[j].index = -1
+		}
+	}
+	return
+}
+
+// Encode implements [Codec].
+// v must be a value or a pointer of a registered struct type.
+func (c *StructCodec) Encode(v any) (p []byte, err error) {
+	rv := reflect.ValueOf(v)
+	if rv.Kind() == reflect.Pointer && !rv.IsNil() {
+		rv = rv.Elem()
+	}
+	id, ok := c.ids[rv.Type()]
+	if !ok {
+		return nil, fmt.Errorf("unregistered struct codec type %v", rv.Type())
+	}
+	p = binary.AppendUvarint(nil, uint64(id))
+	return c.appendStruct(p, id, rv), nil
+}
+
+func (c *StructCodec) appendStruct(p []byte, id int, v reflect.Value) []byte {
+	for _, f := range c.types[id].fields {
+		p = c.appendField(p, &f.typ, v.Field(f.index))
+	}
+	return p
+}
+
+func (c *StructCodec) appendField(p []byte, ft *fieldType, v reflect.Value) []byte {
+	switch ft.kind {
+	case kindBool:
+		if v.Bool() {
+			return append(p, 1)
+		}
+		return append(p, 0)
+	case kindInt:
+		return binary.AppendVarint(p, v.Int())
+	case kindUint:
+		return binary.AppendUvarint(p, v.Uint())
+	case kindFloat:
+		return littleEndian.AppendUint64(p, math.Float64bits(v.Float()))
+	case kindString:
+		return appendString(p, v.String())
+	case kindBytes:
+		p = binary.AppendUvarint(p, uint64(v.Len()))
+		return append(p, v.Bytes()...)
+	case kindStruct:
+		return c.appendStruct(p, ft.id, v)
+	default: // kindSlice
+		p = binary.AppendUvarint(p, uint64(v.Len()))
+		for i := range v.Len() {
+			p = c.appendField(p, ft.elem, v.Index(i))
+		}
+		return p
+	}
+}
+
+// planKey is the key of a decoding plan of a stored type and a Go type.
+type planKey struct {
+	id int
+	t  reflect.Type
+}
+
+// structPlan is the plan to decode a stored struct type into a Go struct type.
+type structPlan struct {
+	fields []fieldPlan // of every stored field
+}
+
+// fieldPlan is the plan to decode a stored value into a Go value.
+type fieldPlan struct {
+	typ   *fieldType
+	index int         // index of the Go field, or -1 to skip the field
+	elem  *fieldPlan  // plan of the elements of kindSlice
+	sub   *structPlan // plan of kindStruct
+}
+
+// plan returns the plan to decode struct type id into Go type t.
+func (c *StructCodec) plan(id int, t reflect.Type) (plan *structPlan, err error) {
+	key := planKey{id, t}
+	if plan, ok := c.plans.Load(key); ok {
+		return plan.(*structPlan), nil
+	}
+	plans := make(map[planKey]*structPlan)
+	if plan, err = c.newStructPlan(key, plans); err != nil {
+		return
+	}
+	for key, plan := range plans {
+		c.plans.LoadOrStore(key, plan)
+	}
+	return
+}
+
+// newStructPlan creates the plan of key. The plans being created are in plans,
+// so recursive types are planned once.
+// If key.t is nil, the plan skips all the fields.
+func (c *StructCodec) newStructPlan(key planKey, plans map[planKey]*structPlan) (plan *structPlan, err error) {
+	if plan = plans[key]; plan != nil {
+		return
+	}
+	if v, ok := c.plans.Load(key); ok {
+		return v.(*structPlan), nil
+	}
+	st := &c.types[key.id]
+	plan = &structPlan{fields: make([]fieldPlan, len(st.fields))}
+	plans[key] = plan
+	for i := range st.fields {
+		f := &st.fields[i]
+		fp := &plan.fields[i]
+		fp.typ, fp.index = &f.typ, -1
+		var goField reflect.StructField
+		if key.t != nil {
+			var ok bool
+			if goField, ok = key.t.FieldByName(f.name); !ok || len(goField.Index) != 1 || !goField.IsExported() {
+				goField.Type = nil
+			}
+		}
+		if err = c.newFieldPlan(fp, goField.Type, plans); err != nil {
+			return nil, fmt.Errorf("field %v of %v: %w", f.name, key.t, err)
+		}
+		if goField.Type != nil {
+			fp.index = goField.Index[0]
+		}
+	}
+	return
+}
+
+// newFieldPlan fills fp to decode into Go type t, or to skip the value if t is nil.
+func (c *StructCodec) newFieldPlan(fp *fieldPlan, t reflect.Type, plans map[planKey]*structPlan) (err error) {
+	if t != nil && kindOf(t) != fp.typ.kind {
+		return fmt.Errorf("can't decode %v into %v", c.typeName(fp.typ), t)
+	}
+	switch fp.typ.kind {
+	case kindStruct:
+		fp.sub, err = c.newStructPlan(planKey{fp.typ.id, t}, plans)
+	case kindSlice:
+		var elem reflect.Type
+		if t != nil {
+			elem = t.Elem()
+		}
+		fp.elem = &fieldPlan{typ: fp.typ.elem, index: -1}
+		err = c.newFieldPlan(fp.elem, elem, plans)
+	}
+	return
+}
+
+func (c *StructCodec) typeName(ft *fieldType) string {
+	switch ft.kind {
+	case kindBool:
+		return "bool"
+	case kindInt:
+		return "int"
+	case kindUint:
+		return "uint"
+	case kindFloat:
+		return "float"
+	case kindString:
+		return "string"
+	case kindBytes:
+		return "[]byte"
+	case kindStruct:
+		return c.types[ft.id].name
+	default:
+		return "[]" + c.typeName(ft.elem)
+	}
+}
+
+// Decode implements [Codec].
+// v must be a non-nil pointer to a struct. The stored fields are decoded into
+// the fields of v of the same names, and the other fields are not changed.
+// Empty slices are decoded as nil.
+func (c *StructCodec) Decode(data []byte, v any) (err error) {
+	rv := reflect.ValueOf(v)
+	if rv.Kind() != reflect.Pointer || rv.IsNil() || rv.Elem().Kind() != reflect.Struct {
+		return fmt.Errorf("invalid struct codec decoding destination %T", v)
+	}
+	r := schemaReader{data}
+	id, err := r.length(len(c.types) - 1)
+	if err != nil {
+		return
+	}
+	plan, err := c.plan(id, rv.Elem().Type())
+	if err != nil {
+		return
+	}
+	if err = r.decodeStruct(plan, rv.Elem()); err == nil && len(r.p) != 0 {
+		err = errInvalidEncoding
+	}
+	return
+}
+
+// decodeStruct decodes a struct planned by plan into v.
+// The struct is skipped if v is invalid.
+func (r *schemaReader) decodeStruct(plan *structPlan, v reflect.Value) (err error) {
+	for i := range plan.fields {
+		fp := &plan.fields[i]
+		var field reflect.Value
+		if fp.index >= 0 && v.IsValid() {
+			field = v.Field(fp.index)
+		}
+		if err = r.decodeField(fp, field); err != nil {
+			return
+		}
+	}
+	return
+}
+
+// decodeField decodes a value planned by fp into v.
+// The value is skipped if v is invalid.
+func (r *schemaReader) decodeField(fp *fieldPlan, v reflect.Value) (err error) {
+	skip := !v.IsValid()
+	switch fp.typ.kind {
+	case kindBool:
+		if len(r.p) == 0 {
+			return errInvalidEncoding
+		}
+		if !skip {
+			v.SetBool(r.p[0] != 0)
+		}
+		r.p = r.p[1:]
+	case kindInt:
+		n, size := binary.Varint(r.p)
+		if size <= 0 {
+			return errInvalidEncoding
+		}
+		if !skip {
+			if v.OverflowInt(n) {
+				return fmt.Errorf("%v overflows %v", n, v.Type())
+			}
+			v.SetInt(n)
+		}
+		r.p = r.p[size:]
+	case kindUint:
+		var n uint64
+		if n, err = r.uvarint(); err != nil {
+			return
+		}
+		if !skip {
+			if v.OverflowUint(n) {
+				return fmt.Errorf("%v overflows %v", n, v.Type())
+			}
+			v.SetUint(n)
+		}
+	case kindFloat:
+		if len(r.p) < 8 {
+			return errInvalidEncoding
+		}
+		if !skip {
+			v.SetFloat(math.Float64frombits(littleEndian.Uint64(r.p)))
+		}
+		r.p = r.p[8:]
+	case kindString, kindBytes:
+		var p []byte
+		if p, err = r.bytes(); err != nil || skip {
+			return
+		}
+		if fp.typ.kind == kindString {
+			v.SetString(string(p))
+		} else if len(p) == 0 {
+			v.SetZero()
+		} else {
+			v.SetBytes(append([]byte(nil), p...))
+		}
+	case kindStruct:
+		return r.decodeStruct(fp.sub, v)
+	case kindSlice:
+		var n int
+		if n, err = r.length(len(r.p)); err != nil {
+			return
+		}
+		if !skip && n == 0 {
+			v.SetZero()
+		} else if !skip {
+			v.Set(reflect.MakeSlice(v.Type(), n, n))
+		}
+		for i := range n {
+			var e reflect.Value
+			if !skip {
+				e = v.Index(i)
+			}
+			if err = r.decodeField(fp.elem, e); err != nil {
+				return
+			}
+		}
+	}
+	return
+}
@@ -0,0 +1,91 @@
+package impl
+
+import (
+	"reflect"
+	"testing"
+)
+
+type codecPoint struct {
+	X, Y int
+}
+
+type codecRecord struct {
+	Name    string
+	Score   float64
+	Count   uint16
+	OK      bool
+	Data    []byte
+	Tags    []string
+	Origin  codecPoint
+	Path    []codecPoint
+	Nested  []codecRecord
+	private int
+}
+
+// codecRecordV2 is another version of codecRecord.
+type codecRecordV2 struct {
+	Score  float32
+	Name   string
+	Extra  int
+	Origin struct{ Y int8 }
+}
+
+func TestStructCodec(t *testing.T) {
+	c, err := NewStructCodec(codecRecord{})
+	if err != nil {
+		t.Fatal(err)
+	}
+	record := codecRecord{
+		Name: "abc", Score: 1.5, Count: 3, OK: true, Data: []byte{1, 2}, Tags: []string{"a", "b"},
+		Origin: codecPoint{-1, 2},
+		Path:   []codecPoint{{1, 2}, {3, 4}},
+		Nested: []codecRecord{{Name: "nested", Tags: []string{}}},
+	}
+	data, err := c.Encode(&record)
+	if err != nil {
+		t.Fatal(err)
+	}
+	read, err := OpenStructCodec(c.Schema())
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, c := range []*StructCodec{c, read} {
+		var v codecRecord
+		if err := c.Decode(data, &v); err != nil {
+			t.Fatal(err)
+		}
+		want := record
+		want.Nested = []codecRecord{{Name: "nested"}} // Empty slices are decoded as nil.
+		if !reflect.DeepEqual(v, want) {
+			t.Fatalf("%+v", v)
+		}
+		var v2 codecRecordV2
+		v2.Extra = 100
+		if err := c.Decode(data, &v2); err != nil {
+			t.Fatal(err)
+		}
+		if v2.Name != "abc" || v2.Score != 1.5 || v2.Extra != 100 || v2.Origin.Y != 2 {
+			t.Fatalf("%+v", v2)
+		}
+	}
+
+	if _, err := c.Encode(codecPoint{}); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := c.Encode(struct{}{}); err == nil {
+		t.Fatal("unregistered type")
+	}
+	var mismatch struct{ Name int }
+	if err := c.Decode(data, &mismatch); err == nil {
+		t.Fatal("mismatched field")
+	}
+	if err := c.Decode(data[:len(data)-1], new(codecRecord)); err == nil {
+		t.Fatal("truncated")
+	}
+	if _, err := NewStructCodec(struct{ M map[string]int }{}); err == nil {
+		t.Fatal("unsupported field")
+	}
+	if _, err := OpenStructCodec([]byte{1, 1, 'a', 1, 1, 'b', byte(kindStruct), 1}); err == nil {
+		t.Fatal("invalid type id")
+	}
+}
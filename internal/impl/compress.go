@@ -0,0 +1,153 @@
+package impl
+
+import (
+	"bytes"
+	"compress/flate"
+	"fmt"
+	"io"
+	"math"
+	"sync"
+)
+
+// A compressed value is a string, []byte or gob value compressed with DEFLATE:
+//
+//	type mark | inflated size | compressed size | compressed data
+//
+// Both sizes are variable-length encoded unsigned integers.
+// The inflated data is the entire encoding of the value, type mark included,
+// and the preset dictionary of the compression is [Header.Dict].
+
+// DefaultCompressThreshold is the default min size of a value to be compressed.
+const DefaultCompressThreshold = 128
+
+// Compressor compresses values with a preset dictionary.
+// It is safe for concurrent use.
+type Compressor struct {
+	dict      []byte
+	threshold int
+	writers   sync.Pool // *deflater
+}
+
+type deflater struct {
+	buf bytes.Buffer
+	w   *flate.Writer
+}
+
+// NewCompressor creates a Compressor that compresses values of at least threshold bytes
+// with preset dictionary dict, which can be nil.
+// If threshold <= 0, [DefaultCompressThreshold] is used.
+func NewCompressor(dict []byte, threshold int) *Compressor {
+	if threshold <= 0 {
+		threshold = DefaultCompressThreshold
+	}
+	return &Compressor{dict: dict, threshold: threshold}
+}
+
+// Dict returns the preset dictionary of c.
+func (c *Compressor) Dict() []byte {
+	if c == nil {
+		return nil
+	}
+	return c.dict
+}
+
+// writeBinary writes p with type t as [writeBinary] does,
+// and compresses it if p is large enough and the compression saves space.
+func (c *Compressor) writeBinary(w ByteWriter, t typ, p []byte) (err error) {
+	if len(p) < c.threshold {
+		return writeBinary(w, t, p)
+	}
+	d, _ := c.writers.Get().(*deflater)
+	if d == nil {
+		d = &deflater{}
+		if d.w, err = flate.NewWriterDict(&d.buf, flate.DefaultCompression, c.dict); err != nil {
+			return
+		}
+	}
+	defer c.writers.Put(d)
+	d.buf.Reset()
+	d.w.Reset(&d.buf)
+
+	var header bytes.Buffer
+	header.WriteByte(byte(t))
+	writeUintValue(&header, uint64(len(p)))
+	size := header.Len() + len(p)
+	d.w.Write(header.Bytes())
+	d.w.Write(p)
+	if err = d.w.Close(); err != nil {
+		return
+	}
+	compressed := d.buf.Bytes()
+	if 1+uintValueSize(uint64(size))+uintValueSize(uint64(len(compressed)))+len(compressed) >= size {
+		return writeBinary(w, t, p)
+	}
+
+	if err = w.WriteByte(byte(typeCompressed)); err != nil {
+		return
+	}
+	if err = writeUintValue(w, uint64(size)); err != nil {
+		return
+	}
+	return writeBinaryValue(w, compressed)
+}
+
+// encodeBinary writes p with type t as [writeBinary] does,
+// or writes a reference to [WriteOptions.Pool] if p is in it,
+// or compresses p with [WriteOptions.Compressor].
+func encodeBinary(w ByteWriter, t typ, p []byte, opts *WriteOptions) (err error) {
+	if opts.Pool != nil {
+		var ok bool
+		if ok, err = opts.Pool.writeRef(w, t, p); ok || err != nil {
+			return
+		}
+	}
+	if opts.Compressor != nil {
+		return opts.Compressor.writeBinary(w, t, p)
+	}
+	return writeBinary(w, t, p)
+}
+
+type inflater struct {
+	src bytes.Reader
+	r   io.ReadCloser
+}
+
+// maxInflateRatio is the largest ratio of the size of data to the size of
+// the DEFLATE compressed data, which is about 1032:1.
+const maxInflateRatio = 1032
+
+// inflateValue reads a compressed value from r after the type mark,
+// and returns the inflated value.
+func inflateValue(r *reader) (v Value, err error) {
+	size, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	compressed, err := readBinaryView(r)
+	if err != nil {
+		return
+	}
+	// The size is checked before the allocation, so a corrupt size is an error,
+	// not an allocation of any size.
+	if size > math.MaxInt || size > uint64(len(compressed))*maxInflateRatio+64 {
+		err = fmt.Errorf("failed to read compressed value: invalid size %v of %v bytes", size, len(compressed))
+		return
+	}
+
+	f, _ := r.src.inflaters.Get().(*inflater)
+	if f == nil {
+		f = &inflater{}
+		f.src.Reset(compressed)
+		f.r = flate.NewReaderDict(&f.src, r.src.dict)
+	} else {
+		f.src.Reset(compressed)
+		f.r.(flate.Resetter).Reset(&f.src, r.src.dict)
+	}
+	defer r.src.inflaters.Put(f)
+	data := make([]byte, size)
+	if _, err = io.ReadFull(f.r, data); err != nil {
+		err = fmt.Errorf("failed to read compressed value: %w", err)
+		return
+	}
+	return NewBytesSource(data).Value(0), nil
+}
@@ -0,0 +1,113 @@
+package impl
+
+import (
+	"bytes"
+	"math/rand"
+	"reflect"
+	"strings"
+	"testing"
+)
+
+func TestCompressedValue(t *testing.T) {
+	dict := []byte(`{"name":"","email":"@example.com"}`)
+	long := strings.Repeat(`{"name":"abc","email":"abc@example.com"}`, 10)
+	obj := map[string]any{
+		"long":  long,
+		"short": "abc",
+		"bin":   []byte(long),
+		"gob":   []string{long},
+		"array": []any{long, int64(1)},
+	}
+	for _, dict := range [][]byte{nil, dict} {
+		opts := &WriteOptions{Gob: NewGobEncoder(), Compressor: NewCompressor(dict, 0)}
+		var buf bytes.Buffer
+		if err := WriteHeader(&buf, 0, opts.Header()); err != nil {
+			t.Fatal(err)
+		}
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		if buf.Len() > 2*len(long) {
+			t.Fatal(buf.Len())
+		}
+
+		src := NewReaderAtSource(bytes.NewReader(buf.Bytes()), 16)
+		h, pos, err := src.ReadHeader(0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if !bytes.Equal(h.Dict, dict) {
+			t.Fatal(h.Dict)
+		}
+		root := src.Value(pos)
+		lookup := func(key string) Value {
+			v, err := root.Lookup(key)
+			if err != nil {
+				t.Fatal(err)
+			}
+			return v
+		}
+		if b, err := src.ReadValue(lookup("long").pos, false); err != nil || b != long {
+			t.Fatal(b, err)
+		}
+		if _, err := lookup("long").Int(); !isIndirect(err) {
+			t.Fatal(err)
+		}
+		if s, err := lookup("long").Str(); err != nil || s != long {
+			t.Fatal(s, err)
+		}
+		if s, err := lookup("short").Str(); err != nil || s != "abc" {
+			t.Fatal(s, err)
+		}
+		if p, err := lookup("bin").AppendBytes([]byte("x")); err != nil || string(p) != "x"+long {
+			t.Fatal(string(p), err)
+		}
+		var strs []string
+		if gob, err := lookup("gob").Gob(); err != nil {
+			t.Fatal(err)
+		} else if err = NewGobDecoder()(gob, &strs); err != nil || !reflect.DeepEqual(strs, []string{long}) {
+			t.Fatal(strs, err)
+		}
+		read, err := root.Decode(true)
+		if err != nil {
+			t.Fatal(err)
+		}
+		m := read.(map[string]any)
+		if m["long"] != long || !bytes.Equal(m["bin"].([]byte), []byte(long)) || !reflect.DeepEqual(m["array"], obj["array"]) {
+			t.Fatal(m)
+		}
+	}
+}
+
+func TestCompressIncompressible(t *testing.T) {
+	p := make([]byte, 1000)
+	rand.New(rand.NewSource(1)).Read(p)
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, p, &WriteOptions{Compressor: NewCompressor(nil, 10)}); err != nil {
+		t.Fatal(err)
+	}
+	if typ := typeMarker(buf.Bytes()[0]).Type(); typ != typeBinary {
+		t.Fatal(typ)
+	}
+}
+
+func TestCompressedSize(t *testing.T) {
+	// The most compressible data is inflated.
+	zeros := string(make([]byte, 1<<20))
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, zeros, &WriteOptions{Compressor: NewCompressor(nil, 0)}); err != nil {
+		t.Fatal(err)
+	}
+	if s, err := NewBytesSource(buf.Bytes()).Value(0).Str(); err != nil || s != zeros {
+		t.Fatal(len(s), err)
+	}
+
+	// A corrupt size is not allocated.
+	buf.Reset()
+	buf.WriteByte(byte(typeCompressed))
+	writeUintValue(&buf, 1<<50)
+	writeBinaryValue(&buf, make([]byte, 10))
+	if _, err := NewBytesSource(buf.Bytes()).Value(0).Str(); err == nil || !strings.Contains(err.Error(), "invalid size") {
+		t.Fatal(err)
+	}
+}
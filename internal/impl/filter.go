@@ -0,0 +1,259 @@
+package impl
+
+import (
+	"errors"
+	"fmt"
+	"math"
+	"math/bits"
+	"slices"
+)
+
+// A [typeFingerprintObject] flagged with objectFilter has an xor filter of its keys
+// after the bucket count, see [WriteOptions.Filter]:
+//
+//	uvarint size | seed (8 bytes) | fingerprints (size-8 bytes)
+//
+// A lookup of a key rejected by the filter returns [ErrNotFound] without
+// reading the offset table or a bucket list. See "Xor Filters: Faster and
+// Smaller Than Bloom and Cuckoo Filters" by Graf and Lemire.
+// The 8-bit fingerprints give a false positive rate of about 1/256 with
+// about 9.8 bits per key.
+//
+// A filter takes about 1.23 bytes per key and 40 bytes more, so objects of
+// fewer than minFilterKeys keys have none: a miss of them reads a bucket list
+// of few fingerprints anyway.
+//
+// The filters of a [NewBytesSource] or a [NewMmapSource] are read in place,
+// and the filters of the other sources are read once and kept in memory,
+// up to maxCachedFilterBytes of a source. The filters read after that are skipped,
+// as the objects had none. The filters of the objects near the root are read
+// by most of the lookups, so they are the ones cached.
+
+// Flag of [typeFingerprintObject].
+const objectFilter = 4 // the object has an xor filter of its keys
+
+// minFilterKeys is the least number of keys of an object with a filter.
+const minFilterKeys = 64
+
+// maxCachedFilterBytes is the size of the filters cached by a source
+// not in memory, see [readXorFilter].
+var maxCachedFilterBytes = 64 << 20
+
+// cachedFilterOverhead is the estimated size of a cached filter besides
+// the fingerprints of it.
+const cachedFilterOverhead = 64
+
+// xorFilterSeedSize is the size of the seed of an xor filter.
+const xorFilterSeedSize = 8
+
+// xorFilterMaxAttempts is the number of seeds tried to build an xor filter.
+// The construction fails with a tiny probability for a seed.
+const xorFilterMaxAttempts = 100
+
+// xorFilter is an xor filter of key hashes.
+type xorFilter struct {
+	seed uint64
+	// fingerprints are 3 blocks of blockLength fingerprints.
+	fingerprints []byte
+	blockLength  uint32
+}
+
+// xorHash returns the hash of key hash in a filter of seed.
+func xorHash(hash, seed uint64) uint64 {
+	return mixHash(hash ^ seed)
+}
+
+// xorFingerprint returns the fingerprint of h returned by [xorHash].
+func xorFingerprint(h uint64) byte {
+	return byte(h ^ h>>32)
+}
+
+// reduce maps x to [0, n) uniformly without division.
+func reduce(x uint32, n uint32) uint32 {
+	return uint32(uint64(x) * uint64(n) >> 32)
+}
+
+// positions returns the indexes of the fingerprints of h, one in every block.
+func (f *xorFilter) positions(h uint64) (p0, p1, p2 uint32) {
+	n := f.blockLength
+	p0 = reduce(uint32(h), n)
+	p1 = reduce(uint32(bits.RotateLeft64(h, 21)), n) + n
+	p2 = reduce(uint32(bits.RotateLeft64(h, 42)), n) + 2*n
+	return
+}
+
+// contains returns whether key hash may be in f.
+// Every hash built into f is contained, and other hashes are too
+// with a probability of about 1/256.
+func (f *xorFilter) contains(hash uint64) bool {
+	h := xorHash(hash, f.seed)
+	p0, p1, p2 := f.positions(h)
+	return xorFingerprint(h) == f.fingerprints[p0]^f.fingerprints[p1]^f.fingerprints[p2]
+}
+
+// rejects returns whether key hash is not in f, which is false if f is the zero filter.
+func (f *xorFilter) rejects(hash uint64) bool {
+	return f.blockLength > 0 && !f.contains(hash)
+}
+
+// xorSet is the xor and the count of the hashes of a fingerprint during construction.
+type xorSet struct {
+	mask  uint64
+	count uint32
+}
+
+// xorPeeled is a hash peeled off a fingerprint during construction.
+type xorPeeled struct {
+	h     uint64
+	index uint32
+}
+
+// buildXorFilter builds an xor filter of hashes,
+// and reports whether it succeeds.
+func buildXorFilter(hashes []uint64) (f xorFilter, ok bool) {
+	// The same key hash can't be peeled off twice.
+	hashes = slices.Clone(hashes)
+	slices.Sort(hashes)
+	hashes = slices.Compact(hashes)
+	capacity := 32 + uint64(len(hashes))*123/100
+	if capacity/3 > math.MaxUint32 {
+		return
+	}
+	f.blockLength = uint32(capacity / 3)
+	f.fingerprints = make([]byte, 3*f.blockLength)
+	sets := make([]xorSet, len(f.fingerprints))
+	queue := make([]uint32, 0, len(sets))
+	stack := make([]xorPeeled, 0, len(hashes))
+	for attempt := range xorFilterMaxAttempts {
+		f.seed = mixHash(uint64(attempt) + 1)
+		clear(sets)
+		for _, hash := range hashes {
+			h := xorHash(hash, f.seed)
+			p0, p1, p2 := f.positions(h)
+			for _, p := range [3]uint32{p0, p1, p2} {
+				sets[p].mask ^= h
+				sets[p].count++
+			}
+		}
+		queue = queue[:0]
+		for i := range sets {
+			if sets[i].count == 1 {
+				queue = append(queue, uint32(i))
+			}
+		}
+		// Peel off the hashes alone in a fingerprint.
+		stack = stack[:0]
+		for len(queue) > 0 {
+			i := queue[len(queue)-1]
+			queue = queue[:len(queue)-1]
+			if sets[i].count != 1 {
+				continue
+			}
+			h := sets[i].mask
+			stack = append(stack, xorPeeled{h: h, index: i})
+			p0, p1, p2 := f.positions(h)
+			for _, p := range [3]uint32{p0, p1, p2} {
+				sets[p].mask ^= h
+				if sets[p].count--; sets[p].count == 1 {
+					queue = append(queue, p)
+				}
+			}
+		}
+		if len(stack) == len(hashes) {
+			break
+		}
+	}
+	if len(stack) != len(hashes) {
+		return xorFilter{}, false
+	}
+	// Assign the fingerprints in the reverse order of peeling,
+	// so the other fingerprints of a hash are final when it is assigned.
+	for i := len(stack) - 1; i >= 0; i-- {
+		peeled := stack[i]
+		p0, p1, p2 := f.positions(peeled.h)
+		f.fingerprints[peeled.index] = 0
+		f.fingerprints[peeled.index] = xorFingerprint(peeled.h) ^
+			f.fingerprints[p0] ^ f.fingerprints[p1] ^ f.fingerprints[p2]
+	}
+	return f, true
+}
+
+// encodedSize returns the size of f after the size of it.
+func (f *xorFilter) encodedSize() int {
+	return xorFilterSeedSize + len(f.fingerprints)
+}
+
+// write writes f to w.
+func (f *xorFilter) write(w ByteWriter) (err error) {
+	if err = writeUintValue(w, uint64(f.encodedSize())); err != nil {
+		return
+	}
+	if err = writeFixedUint(w, f.seed, xorFilterSeedSize); err != nil {
+		return
+	}
+	_, err = w.Write(f.fingerprints)
+	return
+}
+
+// parseXorFilter parses the encoded content of an xor filter,
+// and keeps a reference to data.
+func parseXorFilter(data []byte) (f xorFilter, err error) {
+	if len(data) < xorFilterSeedSize+3 || (len(data)-xorFilterSeedSize)%3 != 0 ||
+		(len(data)-xorFilterSeedSize)/3 > math.MaxUint32 {
+		err = fmt.Errorf("invalid xor filter size %v", len(data))
+		return
+	}
+	f.seed = littleEndian.Uint64(data)
+	f.fingerprints = data[xorFilterSeedSize:]
+	f.blockLength = uint32(len(f.fingerprints) / 3)
+	return
+}
+
+// readXorFilter reads the filter at the position of r, after the size of it.
+// The filter of a source not in memory is read once and cached by the source,
+// or skipped and the zero filter returned if the cache is full.
+func readXorFilter(r *reader, size uint64) (f xorFilter, err error) {
+	if size > math.MaxInt32 {
+		return f, errors.New("xor filter too large")
+	}
+	pos := r.pos()
+	if r.src.data != nil {
+		// The filter stays in place.
+		var data []byte
+		if data, err = r.next(int(size)); err != nil {
+			return
+		}
+		return parseXorFilter(data)
+	}
+	src := r.src
+	cost := int(size) + cachedFilterOverhead
+	src.filterMu.RLock()
+	cached, ok := src.filters[pos]
+	full := src.filterSize+cost > maxCachedFilterBytes
+	src.filterMu.RUnlock()
+	if ok {
+		return *cached, r.skip(size)
+	}
+	if full {
+		return xorFilter{}, r.skip(size)
+	}
+	data := make([]byte, size)
+	if err = r.read(data); err != nil {
+		return
+	}
+	if f, err = parseXorFilter(data); err != nil {
+		return
+	}
+	cached = new(xorFilter)
+	*cached = f
+	src.filterMu.Lock()
+	if src.filters == nil {
+		src.filters = make(map[int64]*xorFilter)
+	}
+	if _, ok := src.filters[pos]; !ok && src.filterSize+cost <= maxCachedFilterBytes {
+		src.filters[pos] = cached
+		src.filterSize += cost
+	}
+	src.filterMu.Unlock()
+	return
+}
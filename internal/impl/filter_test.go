@@ -0,0 +1,171 @@
+package impl
+
+import (
+	"bytes"
+	"strconv"
+	"testing"
+)
+
+func TestXorFilter(t *testing.T) {
+	for _, n := range []int{0, 1, 10, 10000} {
+		hashes := make([]uint64, n, n+1)
+		for i := range hashes {
+			hashes[i] = HashWyhash.sum(strconv.Itoa(i))
+		}
+		// Duplicate hashes are allowed.
+		if n > 0 {
+			hashes = append(hashes, hashes[0])
+		}
+		f, ok := buildXorFilter(hashes)
+		if !ok {
+			t.Fatal(n)
+		}
+		for _, hash := range hashes {
+			if !f.contains(hash) {
+				t.Fatal(n, hash)
+			}
+		}
+		var falsePositives int
+		const misses = 100000
+		for i := range misses {
+			if f.contains(HashWyhash.sum("miss" + strconv.Itoa(i))) {
+				falsePositives++
+			}
+		}
+		// About 1/256
+		if rate := float64(falsePositives) / misses; rate > 0.006 {
+			t.Fatal(n, rate)
+		}
+		if size := f.encodedSize(); size > xorFilterSeedSize+32+n*123/100 {
+			t.Fatal(n, size)
+		}
+	}
+	if (&xorFilter{}).rejects(1) {
+		t.Fatal("the zero filter rejects")
+	}
+}
+
+func TestFilterObject(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 300 {
+		obj[strconv.Itoa(i)] = int64(i)
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder(), Filter: true},
+		{Gob: NewGobEncoder(), Filter: true, Aligned: true},
+		{Gob: NewGobEncoder(), Filter: true, PowerOfTwo: true},
+	} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		for _, src := range []*Source{
+			NewBytesSource(buf.Bytes()),
+			NewReaderAtSource(bytes.NewReader(buf.Bytes()), 64),
+		} {
+			var stats Stats
+			src.CountStats(&stats)
+			o, err := src.Value(0).Object()
+			if err != nil {
+				t.Fatal(err)
+			}
+			if o.filter.blockLength == 0 {
+				t.Fatal("no filter")
+			}
+			for key, want := range obj {
+				if v, err := o.Index(key, false); err != nil || v != want {
+					t.Fatal(key, v, err)
+				}
+			}
+			for i := range 1000 {
+				if _, err := o.Index("miss"+strconv.Itoa(i), false); err != ErrNotFound {
+					t.Fatal(err)
+				}
+			}
+			if filtered := stats.Filtered.Load(); filtered < 990 {
+				t.Fatal(filtered)
+			}
+			values, errs := src.Value(0).LookupMany([]string{"1", "miss", "2"})
+			if errs[0] != nil || errs[1] != ErrNotFound || errs[2] != nil {
+				t.Fatal(errs)
+			}
+			if v, err := values[2].Decode(false); err != nil || v != int64(2) {
+				t.Fatal(v, err)
+			}
+			if v, err := o.Value(); err != nil || len(v) != len(obj) {
+				t.Fatal(len(v), err)
+			}
+		}
+	}
+
+	// An invalid filter size.
+	data := []byte{byte(newTypeMarker(typeFingerprintObject, 1)), objectFilter, 1, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+	if _, err := NewBytesSource(data).Value(0).Object(); err == nil {
+		t.Fatal("invalid filter")
+	}
+}
+
+func TestFilterThreshold(t *testing.T) {
+	for _, n := range []int{minFilterKeys - 1, minFilterKeys} {
+		obj := make(map[string]any)
+		for i := range n {
+			obj[strconv.Itoa(i)] = int64(i)
+		}
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, &WriteOptions{Gob: NewGobEncoder(), Filter: true}); err != nil {
+			t.Fatal(err)
+		}
+		o, err := NewBytesSource(buf.Bytes()).Value(0).Object()
+		if err != nil {
+			t.Fatal(err)
+		}
+		if hasFilter := o.filter.blockLength > 0; hasFilter != (n >= minFilterKeys) {
+			t.Fatal(n, hasFilter)
+		}
+	}
+}
+
+func TestFilterCache(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 3 {
+		nested := make(map[string]any)
+		for j := range 100 {
+			nested[strconv.Itoa(j)] = int64(j)
+		}
+		obj[strconv.Itoa(i)] = nested
+	}
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, obj, &WriteOptions{Gob: NewGobEncoder(), Filter: true}); err != nil {
+		t.Fatal(err)
+	}
+	// Room for the filter of one object.
+	defer func(max int) { maxCachedFilterBytes = max }(maxCachedFilterBytes)
+	maxCachedFilterBytes = 200 + cachedFilterOverhead
+	src := NewReaderAtSource(bytes.NewReader(buf.Bytes()), 64)
+	var filters int
+	for i := range 3 {
+		for range 2 {
+			v, err := src.Value(0).Lookup(strconv.Itoa(i))
+			if err != nil {
+				t.Fatal(err)
+			}
+			o, err := v.Object()
+			if err != nil {
+				t.Fatal(err)
+			}
+			if o.filter.blockLength > 0 {
+				filters++
+			}
+			if v, err := o.Index("99", false); err != nil || v != int64(99) {
+				t.Fatal(v, err)
+			}
+			if _, err := o.Index("miss", false); err != ErrNotFound {
+				t.Fatal(err)
+			}
+		}
+	}
+	// The filter cached is used twice, the others are skipped.
+	if filters != 2 || len(src.filters) != 1 || src.filterSize > maxCachedFilterBytes {
+		t.Fatal(filters, len(src.filters), src.filterSize)
+	}
+}
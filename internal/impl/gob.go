@@ -3,61 +3,171 @@ package impl
 import (
 	"bytes"
 	"encoding/gob"
+	"errors"
 	"io"
 )
 
-type writerWrapper struct {
-	io.Writer
+type GobEncoder func(v any) GobValue
+type GobDecoder func(gob GobValue, v any) error
+
+// NewGobEncoder returns a GobEncoder that encodes every value
+// with its own type information, so values can be decoded in any order.
+// The returned GobEncoder is safe for concurrent use.
+func NewGobEncoder() GobEncoder {
+	return func(v any) GobValue {
+		var buf bytes.Buffer
+		err := gob.NewEncoder(&buf).Encode(v)
+		if err != nil {
+			panic(err)
+		}
+		return GobValue(buf.Bytes())
+	}
 }
 
-func (w *writerWrapper) Write(p []byte) (n int, err error) {
-	return w.Writer.Write(p)
+// NewGobDecoder returns a GobDecoder that decodes values encoded by [NewGobEncoder].
+// The returned GobDecoder is safe for concurrent use.
+func NewGobDecoder() GobDecoder {
+	return func(value GobValue, v any) error {
+		return gob.NewDecoder(bytes.NewReader(value)).Decode(v)
+	}
 }
 
-type byteReaderWrapper struct {
-	io.Reader
+// A database signed "hashive\x00" was written by one gob.Encoder shared by all
+// the gob values, in the order of the file, so a gob value has the definitions
+// of the types of it only if it is the first value of them.
+// Such a value is decoded by a decoder primed with the definitions of all the
+// types of the database, see [LegacyGobTypes] and [NewLegacyGobDecoder].
+
+// NewLegacyGobDecoder returns a GobDecoder of the values of a database
+// signed "hashive\x00". Every value is decoded after the definitions
+// of the types of the database returned by types, see [LegacyGobTypes].
+// The returned GobDecoder is safe for concurrent use if types is.
+func NewLegacyGobDecoder(types func() ([]byte, error)) GobDecoder {
+	return func(value GobValue, v any) error {
+		defs, err := types()
+		if err != nil {
+			return err
+		}
+		stream, err := LegacyGobValue(defs, value)
+		if err != nil {
+			return err
+		}
+		return gob.NewDecoder(bytes.NewReader(stream)).Decode(v)
+	}
 }
 
-func (r *byteReaderWrapper) Read(p []byte) (n int, err error) {
-	return r.Reader.Read(p)
+// LegacyGobValue returns value of a database signed "hashive\x00"
+// after the definitions of the types of the database, see [LegacyGobTypes],
+// which is decoded by [NewGobDecoder] like the values of [NewGobEncoder].
+func LegacyGobValue(types []byte, value GobValue) (stream GobValue, err error) {
+	stream = append(make(GobValue, 0, len(types)+len(value)), types...)
+	// The definitions in value are in types already, and a gob.Decoder
+	// rejects a type defined twice.
+	err = gobMessages(value, func(msg []byte, id int64) {
+		if id >= 0 {
+			stream = append(stream, msg...)
+		}
+	})
+	return
 }
 
-func (r *byteReaderWrapper) ReadByte() (b byte, err error) {
-	if br, ok := r.Reader.(io.ByteReader); ok {
-		return br.ReadByte()
-	}
-	var buf [1]byte
-	_, err = r.Read(buf[:])
-	if err == nil {
-		b = buf[0]
+// LegacyGobTypes returns the definitions of the types of the gob values
+// in the tree of v, as a gob stream of the definition messages.
+// Every value of the tree is read, see [NewLegacyGobDecoder].
+func LegacyGobTypes(v Value) (types []byte, err error) {
+	defined := make(map[int64]bool)
+	var walk func(v Value) error
+	walk = func(v Value) (err error) {
+		r := v.src.reader(v.pos)
+		tb, err := r.ReadByte()
+		r.close()
+		if err != nil {
+			return
+		}
+		var errElem error
+		switch typeMarker(tb).Type() {
+		case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
+			var obj *Object
+			if obj, err = v.Object(); err != nil {
+				return
+			}
+			err = obj.Range(func(key string, value Value) bool {
+				errElem = walk(value)
+				return errElem == nil
+			})
+		case typeArray:
+			var array *Array
+			if array, err = v.Array(); err != nil {
+				return
+			}
+			err = array.Range(func(i int, elem Value) bool {
+				errElem = walk(elem)
+				return errElem == nil
+			})
+		case typeGob:
+			var value GobValue
+			if value, err = v.Gob(); err != nil {
+				return
+			}
+			err = gobMessages(value, func(msg []byte, id int64) {
+				if id < 0 && !defined[-id] {
+					defined[-id] = true
+					types = append(types, msg...)
+				}
+			})
+		}
+		if err == nil {
+			err = errElem
+		}
+		return
 	}
+	err = walk(v)
 	return
 }
 
-type GobEncoder func(v any) GobValue
-type GobDecoder func(gob GobValue, v any) error
-
-func NewGobEncoder() GobEncoder {
-	var gobWriterWrapper writerWrapper
-	var gobEncoder = gob.NewEncoder(&gobWriterWrapper)
-
-	return func(v any) GobValue {
-		var buf bytes.Buffer
-		gobWriterWrapper.Writer = &buf
-		err := gobEncoder.Encode(v)
+// gobMessages calls yield with every message of gob stream p and the type id of it,
+// which is negative if the message is the definition of type -id.
+func gobMessages(p []byte, yield func(msg []byte, id int64)) (err error) {
+	for len(p) > 0 {
+		count, n, err := gobUint(p)
 		if err != nil {
-			panic(err)
+			return err
 		}
-		return GobValue(buf.Bytes())
+		if count > uint64(len(p)-n) {
+			return errors.New("invalid gob message length")
+		}
+		end := n + int(count)
+		u, _, err := gobUint(p[n:end])
+		if err != nil {
+			return err
+		}
+		// Signed integers are encoded with the sign in the lowest bit.
+		id := int64(u >> 1)
+		if u&1 != 0 {
+			id = ^id
+		}
+		yield(p[:end], id)
+		p = p[end:]
 	}
+	return
 }
 
-func NewGobDecoder() GobDecoder {
-	var gobReaderWrapper byteReaderWrapper
-	var gobDecoder = gob.NewDecoder(&gobReaderWrapper)
-
-	return func(gob GobValue, v any) error {
-		gobReaderWrapper.Reader = bytes.NewBuffer(gob)
-		return gobDecoder.Decode(v)
+// gobUint decodes the unsigned integer of gob at the start of p,
+// and returns the number of bytes of it.
+func gobUint(p []byte) (u uint64, n int, err error) {
+	if len(p) == 0 {
+		return 0, 0, io.ErrUnexpectedEOF
+	}
+	if p[0] < 0x80 {
+		return uint64(p[0]), 1, nil
+	}
+	// The negated byte count of a big-endian integer.
+	n = -int(int8(p[0]))
+	if n > 8 || n >= len(p) {
+		return 0, 0, errors.New("invalid gob uint")
+	}
+	for _, b := range p[1 : 1+n] {
+		u = u<<8 | uint64(b)
 	}
+	return u, 1 + n, nil
 }
@@ -0,0 +1,57 @@
+package impl
+
+import (
+	"bytes"
+	"encoding/gob"
+	"testing"
+)
+
+func TestLegacyGobDecoder(t *testing.T) {
+	type point struct{ X, Y int }
+	// The values of one gob.Encoder, as written to databases signed "hashive\x00".
+	var values []GobValue
+	var buf bytes.Buffer
+	enc := gob.NewEncoder(&buf)
+	for i := range 3 {
+		buf.Reset()
+		if err := enc.Encode(point{i, -i}); err != nil {
+			t.Fatal(err)
+		}
+		values = append(values, GobValue(bytes.Clone(buf.Bytes())))
+	}
+	var types []byte
+	for _, value := range values {
+		if err := gobMessages(value, func(msg []byte, id int64) {
+			if id < 0 {
+				types = append(types, msg...)
+			}
+		}); err != nil {
+			t.Fatal(err)
+		}
+	}
+	if len(types) == 0 || !bytes.HasPrefix(values[0], types) {
+		t.Fatal(types)
+	}
+	decode := NewLegacyGobDecoder(func() ([]byte, error) { return types, nil })
+	for _, i := range []int{2, 0, 1} {
+		var p point
+		if err := decode(values[i], &p); err != nil || p != (point{i, -i}) {
+			t.Fatal(i, p, err)
+		}
+	}
+	if err := NewGobDecoder()(values[1], &point{}); err == nil {
+		t.Fatal("decoded without the type")
+	}
+
+	for _, test := range []struct {
+		p []byte
+		u uint64
+	}{{[]byte{0}, 0}, {[]byte{0x7f}, 0x7f}, {[]byte{0xff, 0x80}, 0x80}, {[]byte{0xfe, 1, 0}, 256}} {
+		if u, n, err := gobUint(test.p); err != nil || u != test.u || n != len(test.p) {
+			t.Fatal(test.p, u, n, err)
+		}
+	}
+	if err := gobMessages([]byte{5, 1}, func([]byte, int64) {}); err == nil {
+		t.Fatal("truncated message")
+	}
+}
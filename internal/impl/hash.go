@@ -0,0 +1,138 @@
+package impl
+
+import (
+	"fmt"
+	"math/bits"
+)
+
+// HashFunc is the hash function of object keys.
+type HashFunc byte
+
+const (
+	// HashFNV1a is the 64-bit FNV-1a hash.
+	// It is the hash function of the databases without a [Header].
+	HashFNV1a HashFunc = iota
+	// HashWyhash is the wyhash (final version 4) with seed 0.
+	// It reads 8 bytes at a time and is much faster for long keys.
+	HashWyhash
+)
+
+func (h HashFunc) String() string {
+	switch h {
+	case HashFNV1a:
+		return "fnv1a"
+	case HashWyhash:
+		return "wyhash"
+	default:
+		return fmt.Sprintf("HashFunc(%d)", byte(h))
+	}
+}
+
+// valid returns whether h is a known hash function.
+func (h HashFunc) valid() bool {
+	return h <= HashWyhash
+}
+
+// sum returns the hash of s.
+func (h HashFunc) sum(s string) uint64 {
+	if h == HashWyhash {
+		return wyhash(s)
+	}
+	return stringHash(s)
+}
+
+// stringHash is the 64-bit FNV-1a hash of s.
+// It is equivalent to [fnv.New64a] without allocating a hasher.
+func stringHash(s string) uint64 {
+	const (
+		offset64 = 14695981039346656037
+		prime64  = 1099511628211
+	)
+	h := uint64(offset64)
+	for i := 0; i < len(s); i++ {
+		h ^= uint64(s[i])
+		h *= prime64
+	}
+	return h
+}
+
+// ShardHash returns the hash of key s with seed, which selects the shard of s
+// in a sharded database. It is independent of the hash function of the shards.
+func ShardHash(s string, seed uint64) uint64 {
+	return mixHash(wyhash(s) ^ seed)
+}
+
+// mixHash is the splitmix64 finalizer.
+// It spreads every bit of hash to all the bits of the result, so a hash that
+// is reused for another purpose, or combined with a seed by xor, yields bits
+// independent of the bits that already selected its bucket: the key
+// fingerprints, the hashes of the xor filters and of the MPH buckets and slots,
+// and the shard of [ShardHash] are taken from the high bits of the result.
+func mixHash(hash uint64) uint64 {
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EB
+	return hash ^ (hash >> 31)
+}
+
+// The default secret of wyhash.
+const (
+	wyp0 = 0x2d358dccaa6c78a5
+	wyp1 = 0x8bb84b93962eacc9
+	wyp2 = 0x4b33a62ed433d4a3
+	wyp3 = 0x4d5a2da51de1aa47
+)
+
+// wySeed is the initial state of wyhash with seed 0.
+var wySeed = wymix(wyp0, wyp1)
+
+func wymix(a, b uint64) uint64 {
+	hi, lo := bits.Mul64(a, b)
+	return hi ^ lo
+}
+
+// wyr8 reads a little-endian uint64 from the head of s.
+func wyr8(s string) uint64 {
+	_ = s[7] // Bounds check hint.
+	return uint64(s[0]) | uint64(s[1])<<8 | uint64(s[2])<<16 | uint64(s[3])<<24 |
+		uint64(s[4])<<32 | uint64(s[5])<<40 | uint64(s[6])<<48 | uint64(s[7])<<56
+}
+
+// wyr4 reads a little-endian uint32 from the head of s.
+func wyr4(s string) uint64 {
+	_ = s[3] // Bounds check hint.
+	return uint64(s[0]) | uint64(s[1])<<8 | uint64(s[2])<<16 | uint64(s[3])<<24
+}
+
+// wyhash is the wyhash of s with seed 0.
+// Strings are read in place, so nothing is allocated.
+func wyhash(s string) uint64 {
+	n := len(s)
+	seed := wySeed
+	var a, b uint64
+	if n <= 16 {
+		if n >= 4 {
+			q := (n >> 3) << 2
+			a = wyr4(s)<<32 | wyr4(s[q:])
+			b = wyr4(s[n-4:])<<32 | wyr4(s[n-4-q:])
+		} else if n > 0 {
+			a = uint64(s[0])<<16 | uint64(s[n>>1])<<8 | uint64(s[n-1])
+		}
+	} else {
+		p := s
+		if len(p) > 48 {
+			see1, see2 := seed, seed
+			for ; len(p) > 48; p = p[48:] {
+				seed = wymix(wyr8(p)^wyp1, wyr8(p[8:])^seed)
+				see1 = wymix(wyr8(p[16:])^wyp2, wyr8(p[24:])^see1)
+				see2 = wymix(wyr8(p[32:])^wyp3, wyr8(p[40:])^see2)
+			}
+			seed ^= see1 ^ see2
+		}
+		for ; len(p) > 16; p = p[16:] {
+			seed = wymix(wyr8(p)^wyp1, wyr8(p[8:])^seed)
+		}
+		a, b = wyr8(s[n-16:]), wyr8(s[n-8:])
+	}
+	b, a = bits.Mul64(a^wyp1, b^seed)
+	return wymix(a^wyp0^uint64(n), b^wyp1)
+}
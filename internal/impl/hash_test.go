@@ -0,0 +1,107 @@
+package impl
+
+import (
+	"bytes"
+	"strings"
+	"testing"
+)
+
+func TestWyhash(t *testing.T) {
+	// Every length takes a different path of the algorithm.
+	s := strings.Repeat("0123456789abcdef", 8)
+	seen := make(map[uint64]int)
+	for n := 0; n <= len(s); n++ {
+		hash := wyhash(s[:n])
+		if prev, ok := seen[hash]; ok {
+			t.Fatalf("same hash of length %v and %v", prev, n)
+		}
+		seen[hash] = n
+		if HashWyhash.sum(s[:n]) != hash {
+			t.Fatal(n)
+		}
+	}
+	// Only the last byte differs.
+	if wyhash("key-0") == wyhash("key-1") || wyhash(s[:100]+"0") == wyhash(s[:100]+"1") {
+		t.Fatal("same hash")
+	}
+	if allocs := testing.AllocsPerRun(100, func() { wyhash(s) }); allocs != 0 {
+		t.Fatal(allocs)
+	}
+}
+
+func TestWyhashVectors(t *testing.T) {
+	// The wyhash final version 4 reference with the default secret and seed 0.
+	// The hash of "" is the first of the test vectors of the reference.
+	s := strings.Repeat("0123456789abcdef", 8)
+	for _, test := range []struct {
+		n    int
+		hash uint64
+	}{
+		{0, 0x93228a4de0eec5a2},
+		{1, 0x670cb892bc405352},
+		{2, 0x7f8c23fd4e4ffe28},
+		{3, 0xe4e8c2883f22092d},
+		{4, 0x85d746649d40bdc8},
+		{7, 0x634902b64ca1a435},
+		{8, 0xeb99787ced7aee4b},
+		{15, 0xa942be5944f58153},
+		{16, 0x88de385a856cfb95},
+		{17, 0x6d35345a7d959e03},
+		{32, 0x90d607c9b02557fb},
+		{33, 0xe9828c658f696858},
+		{47, 0x73865268ae296913},
+		{48, 0x0b32d2627b7e7b1f},
+		{49, 0x65d95414ff45db45},
+		{64, 0x117c207ef102abb3},
+		{96, 0x84daf2d5d3de4572},
+		{97, 0x4ab7032fb2d6e9b4},
+		{100, 0x5c04a7abe63f6d74},
+		{128, 0xe81ee619480a4996},
+	} {
+		if hash := wyhash(s[:test.n]); hash != test.hash {
+			t.Fatalf("%v: %#x, want %#x", test.n, hash, test.hash)
+		}
+	}
+}
+
+func TestHashFNV1a(t *testing.T) {
+	// Empty string hashes to the offset basis.
+	if hash := HashFNV1a.sum(""); hash != 14695981039346656037 {
+		t.Fatal(hash)
+	}
+	if hash := HashFNV1a.sum("a"); hash != 0xaf63dc4c8601ec8c {
+		t.Fatalf("%#x", hash)
+	}
+}
+
+func TestReadWriteHeader(t *testing.T) {
+	var buf bytes.Buffer
+	buf.WriteString("sig")
+	if err := WriteHeader(&buf, 3, &Header{Hash: HashWyhash}); err != nil {
+		t.Fatal(err)
+	}
+	end := buf.Len()
+	if err := EncodeValue(&buf, map[string]any{"a": "b"}, &WriteOptions{Hash: HashWyhash}); err != nil {
+		t.Fatal(err)
+	}
+
+	src := NewBytesSource(buf.Bytes())
+	h, pos, err := src.ReadHeader(3)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if h.Hash != HashWyhash || pos != int64(end) {
+		t.Fatal(h, pos)
+	}
+	v, err := src.Value(pos).Lookup("a")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if s, err := v.Str(); err != nil || s != "b" {
+		t.Fatal(s, err)
+	}
+
+	if _, _, err := NewBytesSource([]byte{byte(HashWyhash), 0x40}).ReadHeader(0); err == nil {
+		t.Fatal("unknown flags")
+	}
+}
@@ -0,0 +1,133 @@
+package impl
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+)
+
+// Header is the file header of a database, which follows the file signature.
+//
+// The header is a byte of [HashFunc] followed by a uvarint of flags,
+// and then the fields of the flags in order. A database with unknown flags can't be read.
+type Header struct {
+	Hash HashFunc
+	// Dict is the preset dictionary of compressed values.
+	// It is stored as a byte sequence after the flags if not empty.
+	Dict []byte
+	// Pool is the string pool of the database, see [StringPool].
+	// Its length is stored after Dict if not empty,
+	// and its content is stored at the end of the header.
+	// [Source.ReadHeader] doesn't read Pool, it is read in place.
+	Pool []byte
+	// Codec is the name of the [Codec] of gob values, and Schema is its schema.
+	// They are stored as byte sequences after the length of Pool if Codec is not empty.
+	Codec  string
+	Schema []byte
+	// Aligned pads the end of the header with zeros to a cache line of the file,
+	// so the value after it can be written in the aligned layout, see [WriteOptions.Aligned].
+	Aligned bool
+}
+
+// Header flags.
+const (
+	headerDict    = 1 << iota // Header.Dict is stored
+	headerPool                // Header.Pool is stored
+	headerCodec               // Header.Codec and Header.Schema are stored
+	headerAligned             // the header is padded to a cache line
+)
+
+// WriteHeader writes h to w, where pos is the position of h in the file.
+func WriteHeader(w io.Writer, pos int64, h *Header) (err error) {
+	var buf bytes.Buffer
+	buf.WriteByte(byte(h.Hash))
+	var flags uint64
+	if len(h.Dict) > 0 {
+		flags |= headerDict
+	}
+	if len(h.Pool) > 0 {
+		flags |= headerPool
+	}
+	if h.Codec != "" {
+		flags |= headerCodec
+	}
+	if h.Aligned {
+		flags |= headerAligned
+	}
+	writeUintValue(&buf, flags)
+	if flags&headerDict != 0 {
+		writeBinaryValue(&buf, h.Dict)
+	}
+	if flags&headerPool != 0 {
+		writeUintValue(&buf, uint64(len(h.Pool)))
+	}
+	if flags&headerCodec != 0 {
+		writeBinaryValue(&buf, []byte(h.Codec))
+		writeBinaryValue(&buf, h.Schema)
+	}
+	buf.Write(h.Pool)
+	if flags&headerAligned != 0 {
+		end := int(pos) + buf.Len()
+		writePadding(&buf, 0, alignUp(end, cacheLineSize)-end)
+	}
+	_, err = w.Write(buf.Bytes())
+	return
+}
+
+// ReadHeader reads the [Header] at pos, and returns the position after it.
+// The values of src are read with the settings of the header from then on,
+// so ReadHeader must be called before any other read.
+func (src *Source) ReadHeader(pos int64) (h Header, end int64, err error) {
+	r := src.reader(pos)
+	defer r.close()
+	b, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	if h.Hash = HashFunc(b); !h.Hash.valid() {
+		err = fmt.Errorf("failed to read header: unknown hash function %v", h.Hash)
+		return
+	}
+	flags, err := readUintValue(&r)
+	if err != nil {
+		return
+	}
+	if unknown := flags &^ (headerDict | headerPool | headerCodec | headerAligned); unknown != 0 {
+		err = fmt.Errorf("failed to read header: unknown flags %#x", unknown)
+		return
+	}
+	if flags&headerDict != 0 {
+		if h.Dict, err = readBinaryValue(&r); err != nil {
+			return
+		}
+	}
+	var poolSize uint64
+	if flags&headerPool != 0 {
+		if poolSize, err = readUintValue(&r); err != nil {
+			return
+		}
+	}
+	if flags&headerCodec != 0 {
+		var name []byte
+		if name, err = readBinaryValue(&r); err != nil {
+			return
+		}
+		h.Codec = string(name)
+		if h.Schema, err = readBinaryValue(&r); err != nil {
+			return
+		}
+	}
+	// The content of Pool is the end of the header.
+	poolPos := r.pos()
+	if err = r.skip(poolSize); err != nil {
+		return
+	}
+	end = r.pos()
+	if h.Aligned = flags&headerAligned != 0; h.Aligned {
+		end = int64(alignUp(int(end), cacheLineSize))
+	}
+	src.hash = h.Hash
+	src.dict = h.Dict
+	src.poolPos, src.poolSize = poolPos, poolSize
+	return
+}
@@ -6,7 +6,6 @@ import (
 	"encoding/binary"
 	"errors"
 	"fmt"
-	"hash/fnv"
 	"io"
 	"math"
 )
@@ -20,7 +19,8 @@ func (t typeMarker) Type() typ {
 }
 
 // OffsetSize returns the offset size of t.
-// Offset size is only exists in [typeArray] and [typeObject].
+// Offset size is only exists in [typeArray] and the object types.
+// The offset size of [typeTypedArray] is the width of its elements.
 func (t typeMarker) OffsetSize() byte {
 	return byte(t >> 4)
 }
@@ -42,6 +42,18 @@ const (
 	typeGob               // gob encoded go values
 	typeArray             // []any
 	typeObject            // map[string]any
+	// map[string]any with a hash fingerprint of every key.
+	typeFingerprintObject
+	// map[string]any indexed by a minimal perfect hash.
+	typeMPHObject
+	// []any of elements of the same type, see typed.go.
+	typeTypedArray
+	// string, []byte or gob compressed with DEFLATE, see compress.go.
+	typeCompressed
+	// Reference to a string or []byte in the string pool, see pool.go.
+	typeRef
+	// map[string]any of short keys in an open-addressed slot table, see slot.go.
+	typeSlotObject
 )
 
 // ByteWriter is the interface that groups the io.Writer and io.ByteWriter.
@@ -173,19 +185,32 @@ func writeFixedUint(w io.Writer, n uint64, size byte) (err error) {
 }
 
 // readFixedUint reads a byte sequence from r and convert it to a unsigned integer.
-func readFixedUint(r ByteReadSeeker, size byte) (n uint64, err error) {
-	var buf [8]byte // size of uint64
-	if _, err = io.ReadFull(r, buf[:size]); err != nil {
+func readFixedUint(r *reader, size byte) (n uint64, err error) {
+	if size > 8 {
+		err = fmt.Errorf("invalid size %v", size)
+		return
+	}
+	p, err := r.next(int(size))
+	if err != nil {
 		return
 	}
+	// The sizes of the aligned layout are read from p directly.
+	switch size {
+	case 4:
+		return uint64(littleEndian.Uint32(p)), nil
+	case 8:
+		return littleEndian.Uint64(p), nil
+	}
+	var buf [8]byte // size of uint64
+	copy(buf[:], p)
 	switch size {
 	case 1:
 		n = uint64(buf[0])
 	case 2:
 		n = uint64(littleEndian.Uint16(buf[:]))
-	case 3, 4:
+	case 3:
 		n = uint64(littleEndian.Uint32(buf[:]))
-	case 5, 6, 7, 8:
+	case 5, 6, 7:
 		n = littleEndian.Uint64(buf[:])
 	default:
 		err = fmt.Errorf("invalid size %v", size)
@@ -238,9 +263,17 @@ func writeUintValue(w io.Writer, n uint64) (err error) {
 	return
 }
 
+// uintValueSize returns the size of n written by [writeUintValue].
+func uintValueSize(n uint64) int {
+	if n <= math.MaxInt8 {
+		return 1
+	}
+	return 1 + int(fixedUintSize(n))
+}
+
 // readUintValue reads a variable-length encoded unsigned integer form r
 // after the type mark.
-func readUintValue(r ByteReadSeeker) (n uint64, err error) {
+func readUintValue(r *reader) (n uint64, err error) {
 	var b0 byte
 	if b0, err = r.ReadByte(); err != nil {
 		return
@@ -264,6 +297,10 @@ func WriteUint(w ByteWriter, n uint64) (err error) {
 
 // ReadUint reads a variable-length encoded unsigned integer.
 func ReadUint(r ByteReadSeeker) (n uint64, err error) {
+	return streamRead(r, readUint)
+}
+
+func readUint(r *reader) (n uint64, err error) {
 	b, err := r.ReadByte()
 	if err != nil {
 		return
@@ -290,7 +327,7 @@ func WriteBool(w ByteWriter, b bool) (err error) {
 }
 
 // readBoolValue reads a bool from r after the type mark.
-func readBoolValue(r ByteReadSeeker) (b bool, err error) {
+func readBoolValue(r *reader) (b bool, err error) {
 	n, err := readUintValue(r)
 	if err != nil {
 		return
@@ -309,6 +346,10 @@ func readBoolValue(r ByteReadSeeker) (b bool, err error) {
 
 // ReadBool reads a bool from r.
 func ReadBool(r ByteReadSeeker) (b bool, err error) {
+	return streamRead(r, readBool)
+}
+
+func readBool(r *reader) (b bool, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
@@ -349,14 +390,14 @@ func int2Uint(n int64) uint64 {
 func uint2Int(u uint64) int64 {
 	// See int2Uint.
 	if u&1 == 1 {
-		return int64(^(u >> 1) | 0x80000000)
+		return int64(^(u >> 1))
 	} else {
 		return int64(u >> 1)
 	}
 }
 
 // readIntValue reads a singed integer from r after the type mark.
-func readIntValue(r ByteReadSeeker) (n int64, err error) {
+func readIntValue(r *reader) (n int64, err error) {
 	u, err := readUintValue(r)
 	if err != nil {
 		return
@@ -367,6 +408,10 @@ func readIntValue(r ByteReadSeeker) (n int64, err error) {
 
 // ReadInt reads a signed integer from r.
 func ReadInt(r ByteReadSeeker) (n int64, err error) {
+	return streamRead(r, readInt)
+}
+
+func readInt(r *reader) (n int64, err error) {
 	b, err := r.ReadByte()
 	if err != nil {
 		return
@@ -405,7 +450,7 @@ func WriteFloat(w ByteWriter, f float64) (err error) {
 }
 
 // readFloatValue reads a float point number from r after the type mark.
-func readFloatValue(r ByteReadSeeker) (f float64, err error) {
+func readFloatValue(r *reader) (f float64, err error) {
 	n, err := readUintValue(r)
 	if err != nil {
 		return
@@ -416,6 +461,10 @@ func readFloatValue(r ByteReadSeeker) (f float64, err error) {
 
 // ReadFloat reads a float point number form r.
 func ReadFloat(r ByteReadSeeker) (f float64, err error) {
+	return streamRead(r, readFloat)
+}
+
+func readFloat(r *reader) (f float64, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
@@ -447,23 +496,43 @@ func writeBinaryValue(w io.Writer, p []byte) (err error) {
 	return
 }
 
-// readBinaryValue reads a byte sequence form r after the type mark.
-func readBinaryValue(r ByteReadSeeker) (p []byte, err error) {
-	length, err := readUintValue(r)
+// readBinaryLength reads the length of a byte sequence from r after the type mark.
+func readBinaryLength(r *reader) (length int, err error) {
+	n, err := readUintValue(r)
 	if err != nil {
 		return
 	}
-	if length > math.MaxInt {
-		err = fmt.Errorf("failed to read binary: invalid length %v", length)
+	if n > math.MaxInt {
+		err = fmt.Errorf("failed to read binary: invalid length %v", n)
+		return
+	}
+	length = int(n)
+	return
+}
+
+// readBinaryValue reads a byte sequence form r after the type mark.
+func readBinaryValue(r *reader) (p []byte, err error) {
+	length, err := readBinaryLength(r)
+	if err != nil {
 		return
 	}
 	p = make([]byte, length)
-	_, err = io.ReadFull(r, p)
+	err = r.read(p)
 	return
 }
 
+// readBinaryView is like [readBinaryValue] but returns the bytes without copying.
+// The returned slice is only valid until the next read of r.
+func readBinaryView(r *reader) (p []byte, err error) {
+	length, err := readBinaryLength(r)
+	if err != nil {
+		return
+	}
+	return r.next(length)
+}
+
 // readBinary reads a [typeString], [typeBinary] or [typeGob] from r.
-func readBinary(r ByteReadSeeker, t typ) (p []byte, err error) {
+func readBinary(r *reader, t typ) (p []byte, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
@@ -482,12 +551,14 @@ func WriteBinary(w ByteWriter, p []byte) (err error) {
 
 // ReadBinary reads a byte sequence form r.
 func ReadBinary(r ByteReadSeeker) (p []byte, err error) {
-	return readBinary(r, typeBinary)
+	return streamRead(r, func(r *reader) ([]byte, error) {
+		return readBinary(r, typeBinary)
+	})
 }
 
 // readStringValue reads a [typeString] from r after the type mark.
-func readStringValue(r ByteReadSeeker) (s string, err error) {
-	p, err := readBinaryValue(r)
+func readStringValue(r *reader) (s string, err error) {
+	p, err := readBinaryView(r)
 	if err != nil {
 		return
 	}
@@ -497,7 +568,9 @@ func readStringValue(r ByteReadSeeker) (s string, err error) {
 
 // ReadString reads a string from r.
 func ReadString(r ByteReadSeeker) (s string, err error) {
-	p, err := readBinary(r, typeString)
+	p, err := streamRead(r, func(r *reader) ([]byte, error) {
+		return readBinary(r, typeString)
+	})
 	if err != nil {
 		return
 	}
@@ -516,7 +589,7 @@ func WriteGob(w ByteWriter, v any, encode GobEncoder) (err error) {
 }
 
 // readGobValue reads a GobValue from r.
-func readGobValue(r ByteReadSeeker) (gob GobValue, err error) {
+func readGobValue(r *reader) (gob GobValue, err error) {
 	p, err := readBinaryValue(r)
 	if err != nil {
 		return
@@ -531,7 +604,9 @@ type GobValue []byte
 
 // ReadGob reads gob encoded value from r.
 func ReadGob(r ByteReadSeeker) (gob GobValue, err error) {
-	p, err := readBinary(r, typeGob)
+	p, err := streamRead(r, func(r *reader) ([]byte, error) {
+		return readBinary(r, typeGob)
+	})
 	if err != nil {
 		return
 	}
@@ -545,7 +620,71 @@ func WriteNull(w ByteWriter) (err error) {
 	return w.WriteByte(byte(typeNull))
 }
 
+// WriteOptions are the options of writing values.
+type WriteOptions struct {
+	// Gob encodes the values stored as gob encoded binary data.
+	Gob GobEncoder
+	// Codec encodes the values stored as gob encoded binary data instead of Gob
+	// if not nil.
+	Codec Codec
+	// MinimalPerfectHash writes objects with a minimal perfect hash
+	// instead of separate chaining. See [WriteObject].
+	MinimalPerfectHash bool
+	// Hash is the hash function of object keys.
+	// It must be the hash function of the [Source] reading the values.
+	Hash HashFunc
+	// Workers encodes the elements of arrays and the values of objects in parallel.
+	// Values are encoded sequentially if Workers is nil.
+	Workers *Workers
+	// TypedArrays writes []any of elements of the same type, and slices of
+	// integers, float point numbers, bools and strings as typed arrays,
+	// which are read back as []any like other arrays.
+	// Slices other than []any and []byte are gob encoded otherwise.
+	TypedArrays bool
+	// Compressor compresses large strings, []byte and gob values.
+	// Values are not compressed if Compressor is nil.
+	Compressor *Compressor
+	// Pool is the string pool of the values, see [NewStringPool].
+	// The strings and []byte in Pool are written as references to it.
+	Pool *StringPool
+	// PoolStrings requests a Pool of the value to write,
+	// which must be created by the writer of the header before writing the value.
+	PoolStrings bool
+	// InlineKeySize writes objects whose keys are at most InlineKeySize bytes
+	// as slot tables with the keys and small values inline, see slot.go.
+	// Keys are at most 64 bytes in slot tables.
+	InlineKeySize int
+	// Aligned writes objects and arrays in the aligned layout, see align.go.
+	// The value written must start at a cache line of the file, see [Header.Aligned].
+	Aligned bool
+	// Report reports the layouts of the objects and arrays written if not nil.
+	Report *WriteReport
+	// PowerOfTwo writes objects and slot tables with power of 2 bucket counts, see pow2.go.
+	PowerOfTwo bool
+	// Filter writes an xor filter of the keys of every object written with
+	// separate chaining, see filter.go.
+	Filter bool
+	// SortedKeys writes a sorted index of the keys of every object written with
+	// separate chaining, see sorted.go.
+	SortedKeys bool
+}
+
+// Header returns the file header of the values written with opts.
+func (opts *WriteOptions) Header() *Header {
+	h := &Header{Hash: opts.Hash, Dict: opts.Compressor.Dict(), Pool: opts.Pool.Bytes(), Aligned: opts.Aligned}
+	if opts.Codec != nil {
+		h.Codec, h.Schema = opts.Codec.Name(), opts.Codec.Schema()
+	}
+	return h
+}
+
 // WriteValue writes v to w.
+// It is equivalent to [EncodeValue] with only [WriteOptions.Gob] set.
+func WriteValue(w ByteWriter, v any, gobEncoder GobEncoder) (err error) {
+	return EncodeValue(w, v, &WriteOptions{Gob: gobEncoder})
+}
+
+// EncodeValue writes v to w with opts.
 //   - All singed integers are stored as int64.
 //   - All unsigned integers are stored as uint64.
 //   - Both float32 and float64 are stored as float64.
@@ -553,14 +692,18 @@ func WriteNull(w ByteWriter) (err error) {
 //   - []any is stored as array.
 //   - map[string]any is stored as associated object.
 //   - All the others types are stored as gob encoded binary data.
-func WriteValue(w ByteWriter, v any, gobEncoder GobEncoder) (err error) {
+//
+// See [WriteOptions.TypedArrays] for the arrays stored as typed arrays,
+// [WriteOptions.Compressor] for the values stored compressed,
+// and [WriteOptions.Pool] for the values stored as references.
+func EncodeValue(w ByteWriter, v any, opts *WriteOptions) (err error) {
 	switch value := v.(type) {
 	case nil:
 		return WriteNull(w)
 	case int8:
-		return WriteUint(w, uint64(value))
-	case uint8:
 		return WriteInt(w, int64(value))
+	case uint8:
+		return WriteUint(w, uint64(value))
 	case int16:
 		return WriteInt(w, int64(value))
 	case uint16:
@@ -580,44 +723,83 @@ func WriteValue(w ByteWriter, v any, gobEncoder GobEncoder) (err error) {
 	case bool:
 		return WriteBool(w, value)
 	case string:
-		return WriteString(w, value)
+		return encodeBinary(w, typeString, []byte(value), opts)
 	case float32:
 		return WriteFloat(w, float64(value))
 	case float64:
 		return WriteFloat(w, value)
 	case []byte:
-		return WriteBinary(w, value)
+		return encodeBinary(w, typeBinary, value, opts)
+	case GobValue:
+		// Gob values read from a database are written as is.
+		return encodeBinary(w, typeGob, value, opts)
 	case []any:
-		return WriteArray(w, value, gobEncoder)
+		return writeArray(w, value, opts)
 	case map[string]any:
-		return WriteObject(w, value, gobEncoder)
+		return writeObject(w, value, opts)
 	default:
-		return WriteGob(w, v, gobEncoder)
+		if opts.TypedArrays {
+			if e, ok := typedArrayElems(v); ok {
+				opts.Report.array(0)
+				return writeTypedArray(w, &e)
+			}
+		}
+		if opts.Codec == nil {
+			return encodeBinary(w, typeGob, opts.Gob(v), opts)
+		}
+		var p []byte
+		if p, err = opts.Codec.Encode(v); err != nil {
+			return
+		}
+		return encodeBinary(w, typeGob, p, opts)
 	}
 }
 
+// tableOffsetSize returns the size of the offsets in an offset table of tableLen offsets,
+// where maxOffset is the max offset relative to the end of the table.
+func tableOffsetSize(maxOffset, tableLen int) (offsetSize byte, err error) {
+	offsetSize = fixedUintSize(uint64(maxOffset))
+	// offsetSize must be large enough to hold the max offset plus the size of offset section.
+	for offsetSize < fixedUintSize(uint64(maxOffset+tableLen*int(offsetSize))) {
+		offsetSize *= 2
+		if offsetSize > 8 {
+			err = fmt.Errorf("invalid offset size %v", offsetSize)
+			return
+		}
+	}
+	return
+}
+
 // WriteArray writes an array to w.
 func WriteArray(w io.Writer, array []any, gobEncoder GobEncoder) (err error) {
-	var offsets = make([]int, len(array))
-	var data bytes.Buffer
-	for i, elem := range array {
-		offsets[i] = data.Len()
-		WriteValue(&data, elem, gobEncoder)
+	return writeArray(w, array, &WriteOptions{Gob: gobEncoder})
+}
+
+func writeArray(w io.Writer, array []any, opts *WriteOptions) (err error) {
+	if opts.TypedArrays {
+		if e, ok := typedArrayElems(array); ok {
+			opts.Report.array(0)
+			return writeTypedArray(w, &e)
+		}
+	}
+	data, offsets, err := encodeValues(len(array), func(i int) any { return array[i] }, opts)
+	if err != nil {
+		return
 	}
+	offsets = offsets[:len(array)] // Start of every element.
 
 	var maxOffset = 0
 	if len(offsets) > 0 {
 		maxOffset = offsets[len(offsets)-1]
 	}
-	offsetSize := fixedUintSize(uint64(maxOffset))
-	// offsetSize must be large enough to hold the max offset plus the size of offset section.
-	for offsetSize < fixedUintSize(uint64(maxOffset+len(array)*int(offsetSize))) {
-		offsetSize *= 2
-		if offsetSize > 8 {
-			err = fmt.Errorf("invalid offset size %v", offsetSize)
-			return
-		}
+	if opts.Aligned {
+		return writeAlignedArray(w, array, data, offsets, maxOffset, opts.Report)
+	}
+	offsetSize, err := tableOffsetSize(maxOffset, len(array))
+	if err != nil {
+		return
 	}
+	opts.Report.array(offsetSize)
 
 	// Fix offsets
 	delta := len(array) * int(offsetSize)
@@ -631,17 +813,73 @@ func WriteArray(w io.Writer, array []any, gobEncoder GobEncoder) (err error) {
 	for _, offset := range offsets {
 		writeFixedUint(&buf, uint64(offset), offsetSize)
 	}
-	io.Copy(&buf, &data)
+	buf.Write(data)
 
 	_, err = io.Copy(w, &buf)
 	return
 }
 
+// writeAlignedArray writes array in the aligned layout, where the elements are encoded
+// in data at offsets, and maxOffset is the max of offsets.
+// Objects and arrays in array start at cache lines relative to the start of array.
+// The array is reported to report.
+func writeAlignedArray(w io.Writer, array []any, data []byte, offsets []int, maxOffset int, report *WriteReport) (err error) {
+	elem := func(i int) []byte {
+		if i+1 < len(array) {
+			return data[offsets[i]:offsets[i+1]]
+		}
+		return data[offsets[i]:]
+	}
+	// The elements are moved by the table and the padding,
+	// which is less than a cache line per element.
+	offsetSize := alignedOffsetSize(maxOffset + (len(array)+1)*(8+cacheLineSize))
+	tablePos := 1 + int(offsetSize) // offsets are relative to the table
+	report.array(offsetSize)
+	pos := tablePos + len(array)*int(offsetSize)
+	positions := make([]int, len(array))
+	for i := range array {
+		if isContainer(array[i]) {
+			pos = alignUp(pos, cacheLineSize)
+		}
+		positions[i] = pos
+		pos += len(elem(i))
+	}
+
+	var buf bytes.Buffer
+	buf.WriteByte(byte(newTypeMarker(typeArray, offsetSize)))
+	writeFixedUint(&buf, uint64(len(array)), offsetSize)
+	for _, p := range positions {
+		writeFixedUint(&buf, uint64(p-tablePos), offsetSize)
+	}
+	for i := range array {
+		writePadding(&buf, 0, positions[i]-buf.Len())
+		buf.Write(elem(i))
+	}
+	_, err = io.Copy(w, &buf)
+	return
+}
+
 // ReadValue reads a value from r.
 // See [WriteValue] for the the type of v.
 // If recursive is false, arrays and maps are returned as [Array] and [Object],
 // otherwise they are returned as []any and map[string]any.
 func ReadValue(r ByteReadSeeker, recursive bool) (v any, err error) {
+	return streamRead(r, func(r *reader) (any, error) {
+		return readValue(r, recursive)
+	})
+}
+
+// ReadValue reads a value at position pos of src.
+// See [ReadValue] for the meaning of recursive.
+func (src *Source) ReadValue(pos int64, recursive bool) (v any, err error) {
+	r := src.reader(pos)
+	defer r.close()
+	return readValue(&r, recursive)
+}
+
+// readValue reads a value from r.
+// See [ReadValue] for the meaning of recursive.
+func readValue(r *reader, recursive bool) (v any, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
@@ -692,9 +930,15 @@ func ReadValue(r ByteReadSeeker, recursive bool) (v any, err error) {
 			return
 		}
 		v = g
-	case typeArray:
+	case typeCompressed, typeRef:
+		var target Value
+		if target, err = readIndirect(r); err != nil {
+			return
+		}
+		v, err = target.Decode(recursive)
+	case typeArray, typeTypedArray:
 		var array *Array
-		if array, err = readArrayValue(r, mt.OffsetSize()); err != nil {
+		if array, err = readArrayValue(r, mt); err != nil {
 			return
 		}
 		if !recursive {
@@ -706,9 +950,9 @@ func ReadValue(r ByteReadSeeker, recursive bool) (v any, err error) {
 			return
 		}
 		v = value
-	case typeObject:
+	case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
 		var obj *Object
-		if obj, err = readObjectValue(r, mt.OffsetSize()); err != nil {
+		if obj, err = readObjectValue(r, mt); err != nil {
 			return
 		}
 		if !recursive {
@@ -735,12 +979,14 @@ func (err *BoundsError) Error() string {
 	return fmt.Sprintf("array index out of range, %v of %v", err.Index, err.Length)
 }
 
-// Array is an descriptor of []any read from a stream.
+// Array is an descriptor of []any read from a [Source].
 type Array struct {
-	r          ByteReadSeeker
+	src        *Source
 	pos        int64
 	length     int
 	offsetSize byte
+	elem       typ   // type of the elements of a typed array, typeNull otherwise
+	start      int64 // position of the type mark of a typed array
 }
 
 // Len returns the length of array.
@@ -748,20 +994,18 @@ func (array *Array) Len() int {
 	return array.length
 }
 
-// Index returns the ith element of array.
-// If recursive is false, arrays and maps are returned as [Array] and [Object],
-// otherwise they are returned as []any and map[string]any.
-func (array *Array) Index(i int, recursive bool) (v any, err error) {
+// checkIndex returns a [BoundsError] if i is out of the range of array.
+func (array *Array) checkIndex(i int) error {
 	if i < 0 || i+1 > array.length {
-		err = &BoundsError{Length: array.length, Index: i}
-		return
+		return &BoundsError{Length: array.length, Index: i}
 	}
-	offsetPos := int64(array.offsetSize) * int64(i)
-	_, err = array.r.Seek(array.pos+offsetPos, io.SeekStart)
-	if err != nil {
-		return
-	}
-	offset, err := readFixedUint(array.r, array.offsetSize)
+	return nil
+}
+
+// seekElem seeks r to the ith element of array.
+func (array *Array) seekElem(r *reader, i int) (err error) {
+	r.seek(array.pos + int64(array.offsetSize)*int64(i))
+	offset, err := readFixedUint(r, array.offsetSize)
 	if err != nil {
 		return
 	}
@@ -769,41 +1013,92 @@ func (array *Array) Index(i int, recursive bool) (v any, err error) {
 		err = fmt.Errorf("invalid offset %v", offset)
 		return
 	}
-	_, err = array.r.Seek(array.pos+int64(offset), io.SeekStart)
-	if err != nil {
+	r.seek(array.pos + int64(offset))
+	return
+}
+
+// Index returns the ith element of array.
+// If recursive is false, arrays and maps are returned as [Array] and [Object],
+// otherwise they are returned as []any and map[string]any.
+func (array *Array) Index(i int, recursive bool) (v any, err error) {
+	if err = array.checkIndex(i); err != nil {
+		return
+	}
+	if array.elem != typeNull {
+		return array.typedElemValue(i).Decode(recursive)
+	}
+	r := array.src.reader(array.pos)
+	defer r.close()
+	if err = array.seekElem(&r, i); err != nil {
 		return
 	}
-	return ReadValue(array.r, recursive)
+	return readValue(&r, recursive)
 }
 
 // Value reads and returns the content of array.
 func (array *Array) Value() (v []any, err error) {
+	if array.elem != typeNull {
+		return array.typedValue()
+	}
 	v = make([]any, 0, array.length)
-	for i := range array.length {
-		offsetPos := int64(array.offsetSize) * int64(i)
-		if _, err = array.r.Seek(array.pos+offsetPos, io.SeekStart); err != nil {
-			return
+	var errDecode error
+	if err = array.Range(func(i int, elem Value) bool {
+		var value any
+		if value, errDecode = elem.Decode(true); errDecode != nil {
+			return false
 		}
+		v = append(v, value)
+		return true
+	}); err == nil {
+		err = errDecode
+	}
+	return
+}
+
+// Range calls yield with every element of array in order,
+// until yield returns false.
+// The elements are not decoded, and the offset table is read sequentially.
+func (array *Array) Range(yield func(i int, elem Value) bool) (err error) {
+	if array.elem != typeNull {
+		for i := range array.length {
+			if !yield(i, array.typedElemValue(i)) {
+				break
+			}
+		}
+		return
+	}
+	r := array.src.reader(array.pos)
+	defer r.close()
+	for i := range array.length {
 		var offset uint64
-		offset, err = readFixedUint(array.r, array.offsetSize)
-		if err != nil {
+		if offset, err = readFixedUint(&r, array.offsetSize); err != nil {
 			return
 		}
-		if _, err = array.r.Seek(array.pos+int64(offset), io.SeekStart); err != nil {
-			return
+		if offset > math.MaxInt64 {
+			return fmt.Errorf("invalid offset %v", offset)
 		}
-		var elem any
-		elem, err = ReadValue(array.r, true)
-		if err != nil {
+		if !yield(i, Value{src: array.src, pos: array.pos + int64(offset)}) {
 			return
 		}
-		v = append(v, elem)
 	}
 	return
 }
 
-// readArrayValue reads an Array form r after the type mark.
-func readArrayValue(r ByteReadSeeker, offsetSize byte) (array *Array, err error) {
+// readArrayValue reads an Array form r after the type mark tm.
+func readArrayValue(r *reader, tm typeMarker) (array *Array, err error) {
+	array = &Array{}
+	if err = array.read(r, tm); err != nil {
+		array = nil
+	}
+	return
+}
+
+// read reads the descriptor of array from r after the type mark tm.
+func (array *Array) read(r *reader, tm typeMarker) (err error) {
+	offsetSize := tm.OffsetSize()
+	if tm.Type() == typeTypedArray {
+		return array.readTyped(r, offsetSize)
+	}
 	length, err := readFixedUint(r, offsetSize)
 	if err != nil {
 		return
@@ -813,13 +1108,9 @@ func readArrayValue(r ByteReadSeeker, offsetSize byte) (array *Array, err error)
 		return
 	}
 
-	pos, err := r.Seek(0, io.SeekCurrent)
-	if err != nil {
-		return
-	}
-	array = &Array{
-		r:          r,
-		pos:        pos,
+	*array = Array{
+		src:        r.src,
+		pos:        r.pos(),
 		length:     int(length),
 		offsetSize: offsetSize,
 	}
@@ -837,177 +1128,529 @@ func (err *TypeError) Error() string {
 
 // ReadArray reads an Array from r.
 func ReadArray(r ByteReadSeeker) (array *Array, err error) {
+	return streamRead(r, readArray)
+}
+
+func readArray(r *reader) (array *Array, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
 	}
 	tm := typeMarker(tb)
-	if t := tm.Type(); t != typeArray {
+	if t := tm.Type(); t != typeArray && t != typeTypedArray {
 		err = fmt.Errorf("failed to read array: invalid type %w", &TypeError{t})
 		return
 	}
-	return readArrayValue(r, tm.OffsetSize())
+	return readArrayValue(r, tm)
 }
 
-func stringHash(s string) uint64 {
-	h := fnv.New64a()
-	io.WriteString(h, s)
-	return h.Sum64()
+// objectEntry is a key-value pair of an object being written.
+// The value is already encoded and stored elsewhere.
+type objectEntry struct {
+	key  string
+	hash uint64
+	off  uint64 // offset of the encoded value in its storage
+	size uint64 // size of the encoded value
+	// container is whether the value is an object or an array,
+	// which is aligned in the aligned layout.
+	container bool
 }
 
-type bucketKV struct {
-	K string
-	V any
+// encodedSize returns the size of e in a bucket list:
+// the key, the value size and the value.
+func (e *objectEntry) encodedSize() uint64 {
+	return uint64(uintValueSize(uint64(len(e.key)))+len(e.key)+uintValueSize(e.size)) + e.size
 }
 
-// genBuckets is the Separate Chaining hash table algorithm.
-func genBuckets(obj map[string]any, bucketCount int) (buckets [][]bucketKV, avgOverflow int) {
-	buckets = make([][]bucketKV, bucketCount)
-	for k, v := range obj {
-		hash := stringHash(k)
-		i := hash % uint64(bucketCount)
-		buckets[i] = append(buckets[i], bucketKV{k, v})
+// writeEntry writes e to w, where copyValue writes the encoded value of e.
+func writeEntry(w io.Writer, e *objectEntry, copyValue func(w io.Writer, e *objectEntry) error) (err error) {
+	if err = writeBinaryValue(w, []byte(e.key)); err != nil {
+		return
 	}
+	// Used to skip value
+	if err = writeUintValue(w, e.size); err != nil {
+		return
+	}
+	return copyValue(w, e)
+}
+
+// genBuckets is the Separate Chaining hash table algorithm.
+// The returned buckets are the indexes of entries.
+// The lists are sized by counting the entries of every bucket first,
+// and share one array.
+func genBuckets(entries []objectEntry, index bucketIndex) (buckets [][]int, avgOverflow int) {
+	of := make([]int, len(entries)) // bucket of every entry
+	counts := make([]int, index.count)
+	for i := range entries {
+		of[i] = int(index.of(entries[i].hash))
+		counts[of[i]]++
+	}
+	buckets = make([][]int, index.count)
+	lists := make([]int, len(entries))
 	var sumOverflow int
 	var numOverflow int
-	for _, b := range buckets {
-		if overflow := len(b); overflow > 1 {
+	for b, n := range counts {
+		buckets[b], lists = lists[:0:n], lists[n:]
+		if n > 1 {
 			numOverflow++
-			sumOverflow += overflow
+			sumOverflow += n
 		}
 	}
+	for i, b := range of {
+		buckets[b] = append(buckets[b], i)
+	}
 	if numOverflow > 0 {
 		avgOverflow = sumOverflow / numOverflow
 	}
 	return
 }
 
+// fingerprintSize is the size of a key fingerprint in [typeFingerprintObject].
+const fingerprintSize = 4
+
+// fingerprint returns the key fingerprint of a hash.
+func fingerprint(hash uint64) uint32 {
+	return uint32(mixHash(hash) >> 32)
+}
+
 // WriteObject writes a map[string]any to w.
+//
+// Every bucket list starts with the fingerprints of its keys,
+// so non-matching entries are skipped without comparing their keys.
 func WriteObject(w io.Writer, obj map[string]any, gobEncoder GobEncoder) (err error) {
-	bucketCount := nearestPrime(len(obj) * 4 / 3)
-	buckets, avgOverflow := genBuckets(obj, bucketCount)
-	if avgOverflow > 5 {
-		bucketCount = nearestPrime(max(bucketCount*4/3, bucketCount+1))
-		buckets, _ = genBuckets(obj, bucketCount)
+	return writeObject(w, obj, &WriteOptions{Gob: gobEncoder})
+}
+
+// writeObject writes a map[string]any to w.
+func writeObject(w io.Writer, obj map[string]any, opts *WriteOptions) (err error) {
+	entries, values, err := encodeEntries(obj, opts)
+	if err != nil {
+		return
 	}
+	return writeEntries(w, entries, opts, values.copy)
+}
 
-	var bucketData bytes.Buffer
-	var offsets = make([]int, bucketCount)
-	for i, list := range buckets {
-		if listLen := len(list); listLen == 0 {
-			offsets[i] = -1
-			continue
-		}
-		offsets[i] = bucketData.Len()
-		// List size
-		writeUintValue(&bucketData, uint64(len(list)))
-		// List data
-		for _, bucket := range list {
-			writeBinaryValue(&bucketData, []byte(bucket.K))
-			var valueData bytes.Buffer
-			WriteValue(&valueData, bucket.V, gobEncoder)
-			// Used to skip value
-			writeUintValue(&bucketData, uint64(valueData.Len()))
-			io.Copy(&bucketData, &valueData)
+// encodeEntries encodes the values of obj into the returned values.
+func encodeEntries(obj map[string]any, opts *WriteOptions) (entries []objectEntry, values valueBuffer, err error) {
+	keys := make([]string, 0, len(obj))
+	for k := range obj {
+		keys = append(keys, k)
+	}
+	data, offsets, err := encodeValues(len(keys), func(i int) any { return obj[keys[i]] }, opts)
+	if err != nil {
+		return
+	}
+	entries = make([]objectEntry, len(keys))
+	for i, k := range keys {
+		entries[i] = objectEntry{
+			key:       k,
+			hash:      opts.Hash.sum(k),
+			off:       uint64(offsets[i]),
+			size:      uint64(offsets[i+1] - offsets[i]),
+			container: isContainer(obj[k]),
 		}
 	}
+	return entries, valueBuffer(data), nil
+}
 
-	var maxOffset = 0
-	for i := len(offsets) - 1; i >= 0; i-- {
-		if offset := offsets[i]; offset != -1 {
-			maxOffset = offset
-			break // The last real offset
+// valueBuffer stores the encoded values of entries in memory.
+type valueBuffer []byte
+
+// copy writes the encoded value of e to w.
+func (b valueBuffer) copy(w io.Writer, e *objectEntry) (err error) {
+	_, err = w.Write(b[e.off : e.off+e.size])
+	return
+}
+
+// writeEntries writes an object of entries to w,
+// where copyValue writes the encoded value of an entry.
+// The slot table layout is used if the keys are at most opts.InlineKeySize bytes,
+// otherwise the minimal perfect hash layout is used if opts.MinimalPerfectHash is true,
+// unless the hash can't be built for the keys.
+func writeEntries(w io.Writer, entries []objectEntry, opts *WriteOptions, copyValue func(w io.Writer, e *objectEntry) error) (err error) {
+	if opts.InlineKeySize > 0 {
+		if keySize, ok := slotKeySize(entries, opts.InlineKeySize); ok {
+			return writeSlotObject(w, entries, keySize, copyValue, opts.PowerOfTwo, opts.Report)
 		}
 	}
-	var offsetSize = fixedUintSize(uint64(maxOffset))
-	// offsetSize must be large enough to hold the max offset plus the size of offset section.
-	for offsetSize < fixedUintSize(uint64(maxOffset+bucketCount*int(offsetSize))) {
-		offsetSize *= 2
-		if offsetSize > 8 {
-			err = fmt.Errorf("invalid offset size %v", offsetSize)
+	if opts.MinimalPerfectHash && len(entries) > 0 {
+		if err = writeMPHObject(w, entries, copyValue, opts.Report); err != errMPHBuild {
 			return
 		}
 	}
+	var flags uint64
+	if opts.Aligned {
+		flags |= objectAligned
+	}
+	if opts.PowerOfTwo {
+		flags |= objectPow2
+	}
+	if opts.Filter {
+		flags |= objectFilter
+	}
+	if opts.SortedKeys {
+		flags |= objectSorted
+	}
+	return writeChainedObject(w, entries, copyValue, typeFingerprintObject, flags, opts.Report)
+}
 
-	// Fix offsets
-	delta := bucketCount * int(offsetSize)
-	for i := range offsets {
-		if offsets[i] != -1 {
-			offsets[i] += delta
+// writeChainedObject writes an object of entries to w as [typeObject] or [typeFingerprintObject],
+// where flags of typeFingerprintObject are objectAligned, objectPow2, objectFilter and objectSorted.
+// See [writeEntries] for copyValue. The object is reported to report.
+func writeChainedObject(w io.Writer, entries []objectEntry, copyValue func(w io.Writer, e *objectEntry) error, t typ, flags uint64, report *WriteReport) (err error) {
+	if t != typeFingerprintObject && flags != 0 {
+		return fmt.Errorf("invalid flags %#x of type %v", flags, t)
+	}
+	var buckets [][]int
+	var bucketCount int
+	if flags&objectPow2 != 0 {
+		// A load factor in [0.375, 0.75), without a second pass.
+		bucketCount = pow2BucketCount(len(entries)*4/3 + 1)
+		buckets, _ = genBuckets(entries, newBucketIndex(bucketCount, true))
+	} else {
+		bucketCount = nearestPrime(len(entries) * 4 / 3)
+		var avgOverflow int
+		buckets, avgOverflow = genBuckets(entries, newBucketIndex(bucketCount, false))
+		if avgOverflow > 5 {
+			bucketCount = nearestPrime(max(bucketCount*4/3, bucketCount+1))
+			buckets, _ = genBuckets(entries, newBucketIndex(bucketCount, false))
+		}
+	}
+	for _, list := range buckets {
+		for j, e := range list {
+			for _, e2 := range list[j+1:] {
+				if entries[e].key == entries[e2].key {
+					return fmt.Errorf("duplicate key %q", entries[e].key)
+				}
+			}
+		}
+	}
+	var filter xorFilter
+	var filterSize int // size of the filter with its size
+	if len(entries) < minFilterKeys {
+		flags &^= objectFilter
+	}
+	if flags&objectFilter != 0 {
+		hashes := make([]uint64, len(entries))
+		for i := range entries {
+			hashes[i] = entries[i].hash
+		}
+		var ok bool
+		if filter, ok = buildXorFilter(hashes); ok {
+			filterSize = uintValueSize(uint64(filter.encodedSize())) + filter.encodedSize()
 		} else {
-			// 0 can't be a real offset for an non-empty hashmap.
-			offsets[i] = 0
+			flags &^= objectFilter
+		}
+	}
+
+	// The offsets are computed from the sizes before anything is written,
+	// so the bucket lists are written to w directly.
+	var offsets []int
+	var offsetSize byte
+	var tablePos int              // position of the offset table in the object
+	var listPads, entryPads []int // padding of the aligned layout
+	var listsEnd int              // end of the bucket lists from the offset table
+	aligned := flags&objectAligned != 0
+	if aligned {
+		listPads, entryPads = make([]int, bucketCount), make([]int, len(entries))
+		headerSize := 1 + uintValueSize(flags) + uintValueSize(uint64(bucketCount)) + filterSize
+		if flags&objectSorted != 0 {
+			headerSize += sortedIndexOffsetSize
+		}
+		for _, offsetSize = range []byte{4, 8} {
+			tablePos = alignUp(headerSize, int(offsetSize))
+			var maxOffset, end int
+			offsets, maxOffset, end = layoutAligned(entries, buckets, tablePos, offsetSize, listPads, entryPads)
+			if alignedOffsetSize(maxOffset) == offsetSize {
+				listsEnd = end - tablePos
+				break
+			}
+		}
+	} else {
+		offsets = make([]int, bucketCount)
+		var dataSize = 0
+		var maxOffset = 0
+		for i, list := range buckets {
+			if len(list) == 0 {
+				offsets[i] = -1
+				continue
+			}
+			offsets[i] = dataSize
+			maxOffset = dataSize
+			dataSize += uintValueSize(uint64(len(list)))
+			if t == typeFingerprintObject {
+				dataSize += len(list) * fingerprintSize
+			}
+			for _, e := range list {
+				dataSize += int(entries[e].encodedSize())
+			}
+		}
+		if offsetSize, err = tableOffsetSize(maxOffset, bucketCount); err != nil {
+			return
+		}
+
+		// Fix offsets
+		delta := bucketCount * int(offsetSize)
+		listsEnd = delta + dataSize
+		for i := range offsets {
+			if offsets[i] != -1 {
+				offsets[i] += delta
+			} else {
+				// 0 can't be a real offset for an non-empty hashmap.
+				offsets[i] = 0
+			}
 		}
 	}
 
+	report.chainedObject(buckets, offsetSize, filterSize)
+
 	var header bytes.Buffer
-	header.WriteByte(byte(newTypeMarker(typeObject, offsetSize)))
+	header.WriteByte(byte(newTypeMarker(t, offsetSize)))
+	if t == typeFingerprintObject {
+		writeUintValue(&header, flags)
+	}
 	writeUintValue(&header, uint64(bucketCount))
+	if flags&objectFilter != 0 {
+		filter.write(&header)
+	}
+	sortedField := header.Len() // position of the offset of the sorted index
+	if flags&objectSorted != 0 {
+		writePadding(&header, 0, sortedIndexOffsetSize)
+	}
+	writePadding(&header, 0, tablePos-header.Len())
+	sortedPos := header.Len() + listsEnd // position of the sorted index
+	if flags&objectSorted != 0 {
+		littleEndian.PutUint64(header.Bytes()[sortedField:], uint64(sortedPos))
+	}
 	for _, offset := range offsets {
 		writeFixedUint(&header, uint64(offset), offsetSize)
 	}
+	if _, err = w.Write(header.Bytes()); err != nil {
+		return
+	}
+	pos := header.Len() // position in the object
+	var distances []uint64
+	if flags&objectSorted != 0 {
+		distances = make([]uint64, len(entries))
+	}
 
-	if _, err = io.Copy(w, &header); err == nil {
-		_, err = io.Copy(w, &bucketData)
+	var list bytes.Buffer
+	for i, bucket := range buckets {
+		if len(bucket) == 0 {
+			continue
+		}
+		// List size
+		list.Reset()
+		if aligned {
+			writePadding(&list, padByte, listPads[i])
+		}
+		writeUintValue(&list, uint64(len(bucket)))
+		if t == typeFingerprintObject {
+			for _, e := range bucket {
+				writeFixedUint(&list, uint64(fingerprint(entries[e].hash)), fingerprintSize)
+			}
+		}
+		if _, err = w.Write(list.Bytes()); err != nil {
+			return
+		}
+		pos += list.Len()
+		// List data
+		for _, e := range bucket {
+			if aligned {
+				if err = writePadding(w, padByte, entryPads[e]); err != nil {
+					return
+				}
+				pos += entryPads[e]
+			}
+			if err = writeEntry(w, &entries[e], copyValue); err != nil {
+				return
+			}
+			size := int(entries[e].encodedSize())
+			if distances != nil {
+				distances[e] = uint64(sortedPos - (pos + size - int(entries[e].size)))
+			}
+			pos += size
+		}
+	}
+	if distances != nil {
+		if pos != sortedPos {
+			return fmt.Errorf("sorted index at %v, want %v", pos, sortedPos)
+		}
+		return writeSortedIndex(w, entries, distances)
 	}
 	return
 }
 
+// layoutAligned computes the offsets of the bucket lists of an object in the aligned layout,
+// where the offset table of offsetSize is at tablePos of the object,
+// and stores the padding before the bucket lists and the entries in listPads and entryPads.
+// The returned maxOffset is the max of offsets, and end is the end of the bucket lists.
+func layoutAligned(entries []objectEntry, buckets [][]int, tablePos int, offsetSize byte, listPads, entryPads []int) (offsets []int, maxOffset, end int) {
+	offsets = make([]int, len(buckets))
+	pos := tablePos + len(buckets)*int(offsetSize)
+	for i, list := range buckets {
+		if len(list) == 0 {
+			continue // 0 is the offset of empty buckets.
+		}
+		// The length and the fingerprints of a list don't cross a cache line if they fit in one.
+		listPads[i] = 0
+		listHeader := uintValueSize(uint64(len(list))) + len(list)*fingerprintSize
+		if listHeader <= cacheLineSize && pos/cacheLineSize != (pos+listHeader-1)/cacheLineSize {
+			listPads[i] = alignUp(pos, cacheLineSize) - pos
+		}
+		pos += listPads[i]
+		offsets[i] = pos - tablePos
+		maxOffset = offsets[i]
+		pos += listHeader
+		for _, e := range list {
+			entry := &entries[e]
+			entryPads[e] = 0
+			if entry.container {
+				valuePos := pos + int(entry.encodedSize()-entry.size)
+				entryPads[e] = alignUp(valuePos, cacheLineSize) - valuePos
+			}
+			pos += entryPads[e] + int(entry.encodedSize())
+		}
+	}
+	return offsets, maxOffset, pos
+}
+
 // ErrNotFound is returned when no value is associated with a key
 // when indexing an map[string]any.
 var ErrNotFound = errors.New("not found")
 
-// Array is an descriptor of map[string]any read from a stream.
+// Object is an descriptor of map[string]any read from a [Source].
 type Object struct {
-	r           ByteReadSeeker
+	src         *Source
 	pos         int64
-	bucketCount uint64
+	bucketCount uint64 // number of offsets, which is the key count in typeMPHObject
+	shift       uint8  // shift of a power of 2 bucket count, see pow2.go, 0 otherwise
 	offsetSize  byte
+	layout      typ        // type of the object
+	aligned     bool       // whether the object is in the aligned layout
+	mph         mphHeader  // used if layout is typeMPHObject
+	slots       slotHeader // used if layout is typeSlotObject
+	filter      xorFilter  // the zero filter if the object has no filter
+	sortedPos   int64      // position of the sorted index, 0 if the object has none
+}
+
+// seekBucket seeks r to the ith bucket list of obj.
+// Argument found is false if the bucket is empty.
+func (obj *Object) seekBucket(r *reader, i uint64) (found bool, err error) {
+	r.seek(obj.pos + int64(i)*int64(obj.offsetSize))
+	offset, err := readFixedUint(r, obj.offsetSize)
+	if err != nil {
+		return
+	}
+	if offset > math.MaxInt {
+		err = fmt.Errorf("invalid offset %v", offset)
+		return
+	}
+	if offset == 0 {
+		return // Not exists
+	}
+	r.seek(obj.pos + int64(offset))
+	return true, nil
 }
 
 // Value reads and returns the content of obj.
 func (obj *Object) Value() (v map[string]any, err error) {
 	v = make(map[string]any)
-	for i := range obj.bucketCount {
-		offsetPos := obj.pos + int64(i)*int64(obj.offsetSize)
-		if _, err = obj.r.Seek(offsetPos, io.SeekStart); err != nil {
-			return
-		}
+	var errDecode error
+	if err = obj.Range(func(key string, value Value) bool {
+		v[key], errDecode = value.Decode(true)
+		return errDecode == nil
+	}); err == nil {
+		err = errDecode
+	}
+	return
+}
+
+// Range calls yield with every entry of obj in the order of the file,
+// until yield returns false.
+// The values are not decoded, and the entries are read sequentially
+// with one reader.
+func (obj *Object) Range(yield func(key string, value Value) bool) (err error) {
+	return obj.RangeBuckets(0, obj.bucketCount, yield)
+}
+
+// Buckets returns the number of buckets of obj, whose ranges can be
+// read in parallel by [Object.RangeBuckets].
+// The buckets are the slots of a [typeSlotObject] or a [typeMPHObject].
+func (obj *Object) Buckets() uint64 {
+	return obj.bucketCount
+}
+
+// RangeBuckets is like [Object.Range], but only calls yield with the entries
+// of the buckets in [first, end) of obj, so disjoint ranges of buckets
+// can be read concurrently.
+func (obj *Object) RangeBuckets(first, end uint64, yield func(key string, value Value) bool) (err error) {
+	end = min(end, obj.bucketCount)
+	if first >= end {
+		return
+	}
+	if obj.layout == typeSlotObject {
+		return obj.rangeSlots(first, end, yield)
+	}
+	r := obj.src.reader(obj.pos + int64(first)*int64(obj.offsetSize))
+	defer r.close()
+	// The bucket lists follow the offset table in the order of the table,
+	// so the lists of the range start at the first offset of them.
+	var lists, start uint64
+	for range end - first {
 		var offset uint64
-		offset, err = readFixedUint(obj.r, obj.offsetSize)
-		if err != nil {
+		if offset, err = readFixedUint(&r, obj.offsetSize); err != nil {
 			return
 		}
-		if offset > math.MaxInt {
-			err = fmt.Errorf("invalid offset %v", offset)
-			return
-		}
-		if offset == 0 {
-			continue // Not exists
+		if offset != 0 {
+			if lists == 0 {
+				start = offset
+			}
+			lists++
 		}
-		_, err = obj.r.Seek(obj.pos+int64(offset), io.SeekStart)
-		if err != nil {
-			return
+	}
+	if lists == 0 {
+		return
+	}
+	if start > math.MaxInt64-uint64(obj.pos) {
+		return fmt.Errorf("invalid offset %v", start)
+	}
+	r.seek(obj.pos + int64(start))
+	for range lists {
+		var listLen uint64 = 1
+		if obj.layout != typeMPHObject {
+			if err = obj.skipPadding(&r); err != nil {
+				return
+			}
+			if listLen, err = readUintValue(&r); err != nil {
+				return
+			}
 		}
-		var listLen uint64
-		listLen, err = readUintValue(obj.r)
-		if err != nil {
-			return
+		if obj.layout == typeFingerprintObject {
+			if err = r.skip(listLen * fingerprintSize); err != nil {
+				return
+			}
 		}
 		for range listLen {
+			if err = obj.skipPadding(&r); err != nil {
+				return
+			}
 			var key string
-			if key, err = readStringValue(obj.r); err != nil {
+			if key, err = readStringValue(&r); err != nil {
+				return
+			}
+			var valueSize uint64
+			if valueSize, err = readUintValue(&r); err != nil {
 				return
 			}
-			// Read value size
-			if _, err = readUintValue(obj.r); err != nil {
+			valuePos := r.pos()
+			if !yield(key, Value{src: obj.src, pos: valuePos}) {
 				return
 			}
-			var value any
-			if value, err = ReadValue(obj.r, true); err != nil {
+			r.seek(valuePos)
+			if err = r.skip(valueSize); err != nil {
 				return
 			}
-			v[key] = value
 		}
 	}
 	return
@@ -1017,87 +1660,256 @@ func (obj *Object) Value() (v map[string]any, err error) {
 // if no value is associated with key.
 // See [Array.Index] for the meaning of recursive.
 func (obj *Object) Index(key string, recursive bool) (v any, err error) {
-	hash := stringHash(key)
-	i := hash % obj.bucketCount
-	offsetPos := obj.pos + int64(i)*int64(obj.offsetSize)
-	if _, err = obj.r.Seek(offsetPos, io.SeekStart); err != nil {
+	r := obj.src.reader(obj.pos)
+	defer r.close()
+	if err = obj.find(&r, key); err != nil {
 		return
 	}
-	offset, err := readFixedUint(obj.r, obj.offsetSize)
-	if err != nil {
-		return
+	return readValue(&r, recursive)
+}
+
+// find seeks r to the value associated with key.
+// The returned error is [ErrNotFound] if no value is associated with key.
+// Keys are compared in place without being copied.
+func (obj *Object) find(r *reader, key string) (err error) {
+	hash := obj.src.hash.sum(key)
+	if obj.layout == typeSlotObject {
+		return obj.findSlot(r, key, hash)
 	}
-	if offset > math.MaxInt {
-		err = fmt.Errorf("invalid offset %v", offset)
-		return
+	if obj.filter.rejects(hash) {
+		r.src.stats.filtered()
+		return ErrNotFound
 	}
-	if offset == 0 {
-		err = ErrNotFound // Not exists
+	i, err := obj.slot(r, hash)
+	if err != nil {
 		return
 	}
-	_, err = obj.r.Seek(obj.pos+int64(offset), io.SeekStart)
+	found, err := obj.seekBucket(r, i)
 	if err != nil {
 		return
+	} else if !found {
+		return ErrNotFound
+	}
+	return obj.scanList(r, key, hash)
+}
+
+// slot returns the index of the bucket list of hash in the offset table.
+func (obj *Object) slot(r *reader, hash uint64) (i uint64, err error) {
+	if obj.layout == typeMPHObject {
+		return obj.slotMPH(r, hash)
+	}
+	return obj.bucket(hash), nil
+}
+
+// bucket returns the bucket of hash in a [typeFingerprintObject] or a [typeSlotObject].
+func (obj *Object) bucket(hash uint64) uint64 {
+	return bucketIndex{count: obj.bucketCount, shift: obj.shift}.of(hash)
+}
+
+// scanList seeks r to the value associated with key in the bucket list at the position of r.
+// The returned error is [ErrNotFound] if key is not in the list.
+func (obj *Object) scanList(r *reader, key string, hash uint64) (err error) {
+	if obj.layout == typeMPHObject {
+		return obj.verifyMPH(r, key)
 	}
-	listLen, err := readUintValue(obj.r)
+	listLen, err := readUintValue(r)
 	if err != nil {
 		return
 	}
+	if obj.layout == typeFingerprintObject {
+		return obj.findFingerprint(r, key, fingerprint(hash), listLen)
+	}
 	for range listLen {
-		var bucketKey string
-		if bucketKey, err = readStringValue(obj.r); err != nil {
+		r.src.stats.probe()
+		var bucketKey []byte
+		if bucketKey, err = readBinaryView(r); err != nil {
+			return
+		}
+		found := key == string(bucketKey)
+		// Read value size
+		var valueSize uint64
+		if valueSize, err = readUintValue(r); err != nil {
+			return
+		}
+		if found { // FOUND!
+			return
+		}
+		// Skip value
+		if err = r.skip(valueSize); err != nil {
 			return
 		}
-		if key == bucketKey { // FOUND!
-			// Read value size
-			if _, err = readUintValue(obj.r); err != nil {
+	}
+	return ErrNotFound
+}
+
+// findFingerprint is the [Object.find] of a bucket list with key fingerprints.
+// Argument r is positioned after the list length.
+func (obj *Object) findFingerprint(r *reader, key string, fp uint32, listLen uint64) (err error) {
+	fpPos := r.pos()
+	if err = r.skip(listLen * fingerprintSize); err != nil {
+		return
+	}
+	entryPos := r.pos() // position of the entry at index entry
+	var entry uint64
+	for i := range listLen {
+		r.src.stats.probe()
+		r.seek(fpPos + int64(i)*fingerprintSize)
+		var entryFP uint64
+		if entryFP, err = readFixedUint(r, fingerprintSize); err != nil {
+			return
+		} else if uint32(entryFP) != fp {
+			continue
+		}
+		r.seek(entryPos)
+		// Skip entries before i without comparing their keys.
+		for ; entry < i; entry++ {
+			if err = obj.skipPadding(r); err != nil {
+				return
+			}
+			if err = skipEntry(r); err != nil {
 				return
 			}
-			return ReadValue(obj.r, recursive)
 		}
-
-		// Read value size
+		if err = obj.skipPadding(r); err != nil {
+			return
+		}
+		var bucketKey []byte
+		if bucketKey, err = readBinaryView(r); err != nil {
+			return
+		}
+		found := key == string(bucketKey)
 		var valueSize uint64
-		if valueSize, err = readUintValue(obj.r); err != nil {
+		if valueSize, err = readUintValue(r); err != nil {
 			return
 		}
-		// Skip value
-		if _, err = obj.r.Seek(int64(valueSize), io.SeekCurrent); err != nil {
+		if found { // FOUND!
+			return
+		}
+		if err = r.skip(valueSize); err != nil {
 			return
 		}
+		entry++
+		entryPos = r.pos()
 	}
-	return nil, ErrNotFound
+	return ErrNotFound
+}
+
+// skipEntry skips a key value pair of a bucket list.
+func skipEntry(r *reader) (err error) {
+	keySize, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	if err = r.skip(keySize); err != nil {
+		return
+	}
+	valueSize, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	return r.skip(valueSize)
 }
 
 // readObjectValue reads a map[string]any from r after the type mark.
-func readObjectValue(r ByteReadSeeker, offsetSize byte) (obj *Object, err error) {
+func readObjectValue(r *reader, tm typeMarker) (obj *Object, err error) {
+	obj = &Object{}
+	if err = obj.read(r, tm); err != nil {
+		obj = nil
+	}
+	return
+}
+
+// read reads the descriptor of obj from r after the type mark tm.
+func (obj *Object) read(r *reader, tm typeMarker) (err error) {
+	layout := tm.Type()
+	if layout == typeMPHObject {
+		return obj.readMPH(r, tm)
+	}
+	if layout == typeSlotObject {
+		return obj.readSlots(r, tm)
+	}
+	start := r.pos() - 1 // position of the type mark
+	var flags uint64
+	if layout == typeFingerprintObject {
+		if flags, err = readUintValue(r); err != nil {
+			return
+		}
+		if unknown := flags &^ (objectAligned | objectPow2 | objectFilter | objectSorted); unknown != 0 {
+			err = fmt.Errorf("failed to read object: unknown flags %#x", unknown)
+			return
+		}
+	}
 	bucketCount, err := readUintValue(r)
 	if err != nil {
 		return
 	}
-	pos, err := r.Seek(0, io.SeekCurrent)
-	if err != nil {
+	if bucketCount == 0 {
+		err = errors.New("failed to read object: zero bucket count")
 		return
 	}
-	obj = &Object{
-		r:           r,
+	var filter xorFilter
+	if flags&objectFilter != 0 {
+		var size uint64
+		if size, err = readUintValue(r); err != nil {
+			return
+		}
+		if filter, err = readXorFilter(r, size); err != nil {
+			return
+		}
+	}
+	var sortedPos int64
+	if flags&objectSorted != 0 {
+		var offset uint64
+		if offset, err = readFixedUint(r, sortedIndexOffsetSize); err != nil {
+			return
+		}
+		if offset <= uint64(r.pos()-start) || offset > uint64(maxPos-start) {
+			err = fmt.Errorf("failed to read object: invalid sorted index offset %v", offset)
+			return
+		}
+		sortedPos = start + int64(offset)
+	}
+	pos := r.pos()
+	aligned := flags&objectAligned != 0
+	if aligned && tm.OffsetSize() > 0 {
+		pos = start + int64(alignUp(int(pos-start), int(tm.OffsetSize())))
+	}
+	var shift uint8
+	if flags&objectPow2 != 0 {
+		if bucketCount&(bucketCount-1) != 0 {
+			err = fmt.Errorf("failed to read object: bucket count %v is not a power of 2", bucketCount)
+			return
+		}
+		shift = pow2Shift(bucketCount)
+	}
+	*obj = Object{
+		src:         r.src,
 		pos:         pos,
 		bucketCount: bucketCount,
-		offsetSize:  offsetSize,
+		shift:       shift,
+		offsetSize:  tm.OffsetSize(),
+		layout:      layout,
+		aligned:     aligned,
+		filter:      filter,
+		sortedPos:   sortedPos,
 	}
 	return
 }
 
 // ReadObject reads a map[string]any from r.
 func ReadObject(r ByteReadSeeker) (obj *Object, err error) {
+	return streamRead(r, readObject)
+}
+
+func readObject(r *reader) (obj *Object, err error) {
 	tb, err := r.ReadByte()
 	if err != nil {
 		return
 	}
 	tm := typeMarker(tb)
-	if t := tm.Type(); t != typeObject {
-		err = fmt.Errorf("failed to read object: invalid type %v", t)
+	if t := tm.Type(); t != typeObject && t != typeFingerprintObject && t != typeMPHObject && t != typeSlotObject {
+		err = fmt.Errorf("failed to read object: invalid type %w", &TypeError{t})
 		return
 	}
-	return readObjectValue(r, tm.OffsetSize())
+	return readObjectValue(r, tm)
 }
@@ -4,7 +4,9 @@ import (
 	"bytes"
 	"errors"
 	"io"
+	"math"
 	"reflect"
+	"strconv"
 	"testing"
 )
 
@@ -454,3 +456,212 @@ func TestByteReadSeeker3(t *testing.T) {
 		t.Fatal(v)
 	}
 }
+
+func TestReadLegacyObject(t *testing.T) {
+	gobEncoder := NewGobEncoder()
+	obj := map[string]any{
+		"true": true,
+		"123":  int64(123),
+		"789":  map[string]any{"ary": []any{"abc", 0.625}},
+	}
+	entries, values, err := encodeEntries(obj, &WriteOptions{Gob: gobEncoder})
+	if err != nil {
+		t.Fatal(err)
+	}
+	var buf bytes.Buffer
+	if err := writeChainedObject(&buf, entries, values.copy, typeObject, 0, nil); err != nil {
+		t.Fatal(err)
+	}
+	if tm := typeMarker(buf.Bytes()[0]); tm.Type() != typeObject {
+		t.Fatal(tm.Type())
+	}
+
+	readObj, err := ReadObject(bytes.NewReader(buf.Bytes()))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if v, err := readObj.Index("123", true); err != nil {
+		t.Fatal(err)
+	} else if v != int64(123) {
+		t.Fatal(v)
+	}
+	if _, err := readObj.Index("456", true); err != ErrNotFound {
+		t.Fatal(err)
+	}
+	if read, err := readObj.Value(); err != nil {
+		t.Fatal(err)
+	} else if !reflect.DeepEqual(obj, read) {
+		t.Fatal(read)
+	}
+}
+
+func TestFingerprintObject(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 5000 {
+		obj[strconv.Itoa(i)] = int64(i)
+	}
+	var buf bytes.Buffer
+	if err := WriteObject(&buf, obj, nil); err != nil {
+		t.Fatal(err)
+	}
+
+	readObj, err := ReadObject(bytes.NewReader(buf.Bytes()))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if readObj.layout != typeFingerprintObject {
+		t.Fatal("no fingerprint")
+	}
+	for i := range 5000 {
+		if v, err := readObj.Index(strconv.Itoa(i), true); err != nil {
+			t.Fatal(err)
+		} else if v != int64(i) {
+			t.Fatal(v)
+		}
+		if _, err := readObj.Index(strconv.Itoa(-i-1), true); err != ErrNotFound {
+			t.Fatal(err)
+		}
+	}
+}
+
+func TestMPHObject(t *testing.T) {
+	opts := &WriteOptions{Gob: NewGobEncoder(), MinimalPerfectHash: true}
+	for _, n := range []int{1, 2, 10, 5000} {
+		obj := make(map[string]any)
+		for i := range n {
+			obj[strconv.Itoa(i)] = int64(i)
+		}
+		obj["nested"] = map[string]any{"ary": []any{"abc", 0.625}}
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+
+		readObj, err := ReadObject(bytes.NewReader(buf.Bytes()))
+		if err != nil {
+			t.Fatal(err)
+		}
+		if readObj.layout != typeMPHObject {
+			t.Fatal(readObj.layout)
+		} else if readObj.bucketCount != uint64(len(obj)) {
+			t.Fatal(readObj.bucketCount)
+		}
+		for i := range n {
+			if v, err := readObj.Index(strconv.Itoa(i), true); err != nil {
+				t.Fatal(err)
+			} else if v != int64(i) {
+				t.Fatal(v)
+			}
+			if _, err := readObj.Index(strconv.Itoa(-i-1), true); err != ErrNotFound {
+				t.Fatal(err)
+			}
+		}
+		if read, err := readObj.Value(); err != nil {
+			t.Fatal(err)
+		} else if !reflect.DeepEqual(obj, read) {
+			t.Fatal(read)
+		}
+	}
+}
+
+func Test_buildMPH(t *testing.T) {
+	hashes := make([]uint64, 100000)
+	for i := range hashes {
+		hashes[i] = HashFNV1a.sum(strconv.Itoa(i))
+	}
+	_, slots, err := buildMPH(hashes)
+	if err != nil {
+		t.Fatal(err)
+	}
+	used := make([]bool, len(hashes))
+	for _, slot := range slots {
+		if used[slot] {
+			t.Fatalf("slot %v is used twice", slot)
+		}
+		used[slot] = true
+	}
+
+	if _, _, err := buildMPH([]uint64{1, 2, 1}); err != errMPHBuild {
+		t.Fatal(err)
+	}
+}
+
+func TestRangeBuckets(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 1000 {
+		obj[strconv.Itoa(i)] = int64(i)
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder()},
+		{Gob: NewGobEncoder(), MinimalPerfectHash: true},
+		{Gob: NewGobEncoder(), Aligned: true},
+		{Gob: NewGobEncoder(), InlineKeySize: 8},
+	} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		o, err := NewBytesSource(buf.Bytes()).Value(0).Object()
+		if err != nil {
+			t.Fatal(err)
+		}
+		var all []string
+		o.Range(func(key string, value Value) bool {
+			all = append(all, key)
+			return true
+		})
+		var got []string
+		for first := uint64(0); first < o.Buckets(); first += 7 {
+			if err := o.RangeBuckets(first, first+7, func(key string, value Value) bool {
+				if n, err := value.Int(); err != nil || strconv.Itoa(int(n)) != key {
+					t.Fatal(key, n, err)
+				}
+				got = append(got, key)
+				return true
+			}); err != nil {
+				t.Fatal(err)
+			}
+		}
+		if len(all) != len(obj) || !reflect.DeepEqual(got, all) {
+			t.Fatal(o.layout, len(all), len(got))
+		}
+	}
+}
+
+func TestScalar(t *testing.T) {
+	for _, test := range []struct {
+		v    any
+		kind Kind
+		bits uint64
+	}{
+		{nil, KindNull, 0},
+		{int64(-2), KindInt, math.MaxUint64 - 1},
+		{uint64(3), KindUint, 3},
+		{1.5, KindFloat, math.Float64bits(1.5)},
+		{true, KindBool, 1},
+		{false, KindBool, 0},
+		{"s", KindString, 0},
+		{[]byte("b"), KindOther, 0},
+		{map[string]any{}, KindOther, 0},
+	} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, test.v, &WriteOptions{Gob: NewGobEncoder()}); err != nil {
+			t.Fatal(err)
+		}
+		if kind, bits, err := NewBytesSource(buf.Bytes()).Value(0).Scalar(); err != nil || kind != test.kind || bits != test.bits {
+			t.Fatal(test.v, kind, bits, err)
+		}
+	}
+	// Elements of typed arrays
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, []any{int64(-1), int64(2)}, &WriteOptions{Gob: NewGobEncoder(), TypedArrays: true}); err != nil {
+		t.Fatal(err)
+	}
+	elem, err := NewBytesSource(buf.Bytes()).Value(0).Lookup("0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if kind, bits, err := elem.Scalar(); err != nil || kind != KindInt || int64(bits) != -1 {
+		t.Fatal(kind, bits, err)
+	}
+}
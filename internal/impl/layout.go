@@ -0,0 +1,439 @@
+package impl
+
+import (
+	"fmt"
+	"slices"
+	"strconv"
+)
+
+// Layout is the layout of the objects and arrays of a value, see [Value.Layout].
+type Layout struct {
+	// Levels[i] is the layout of the objects and arrays at nesting level i.
+	// The value itself is at level 0.
+	Levels []LevelLayout
+	// Largest is the largest values other than objects and arrays, in descending order of size.
+	Largest []LargeValue
+	// Size is the size of the value.
+	Size int64
+}
+
+// LevelLayout is the layout of the objects and arrays at a nesting level.
+// The bytes of an object or an array are one of TableBytes, KeyBytes,
+// ValueBytes and OtherBytes, or the bytes of the objects and arrays
+// at the next level.
+type LevelLayout struct {
+	Objects     int // number of objects
+	MPHObjects  int // number of objects indexed by a minimal perfect hash
+	SlotObjects int // number of objects written as slot tables
+	Filters     int // number of objects with key filters
+	Sorted      int // number of objects with sorted key indexes
+	Keys        int // number of keys of the objects
+
+	// Buckets is the number of buckets of the objects,
+	// and Lists is the number of non-empty buckets.
+	// The slots of a slot table are its buckets, and a run of occupied slots is a list,
+	// which is probed until an empty slot.
+	Buckets, Lists int
+	// Chains[n] is the number of lists of n keys.
+	Chains []int
+
+	Arrays      int // number of arrays
+	TypedArrays int // number of typed arrays
+	Elems       int // number of elements of the arrays
+
+	// OffsetSizes[i] is the number of offset tables of offset size i.
+	OffsetSizes [9]int
+
+	// TableBytes is the bytes of the offset tables, the hash seeds of minimal perfect hashes,
+	// the key filters, the sorted key indexes, and the slot tables except the keys and values.
+	TableBytes int64
+	KeyBytes   int64 // bytes of the keys
+	ValueBytes int64 // bytes of the values other than objects and arrays, and the data of typed arrays
+	OtherBytes int64 // bytes of the descriptors, the key fingerprints, value sizes and padding
+}
+
+// LoadFactor returns the average number of keys per bucket of the objects.
+func (l *LevelLayout) LoadFactor() float64 {
+	if l.Buckets == 0 {
+		return 0
+	}
+	return float64(l.Keys) / float64(l.Buckets)
+}
+
+// MaxChain returns the max number of keys of the lists.
+func (l *LevelLayout) MaxChain() int {
+	return max(len(l.Chains)-1, 0)
+}
+
+// LargeValue is a value reported in [Layout.Largest].
+type LargeValue struct {
+	Path []string // path of the value, where array indexes are in decimal
+	Size int64    // encoded size of the value
+}
+
+// Layout walks v recursively and returns its layout,
+// where at most largest largest values are reported.
+// Every object and array in v is read.
+func (v Value) Layout(largest int) (layout *Layout, err error) {
+	if v.index > 0 {
+		return nil, fmt.Errorf("element of typed array at %v", v.pos)
+	}
+	a := layoutWalker{layout: &Layout{}, largest: largest}
+	end, _, err := a.value(v.src, v.pos, 0, nil)
+	if err != nil {
+		return
+	}
+	a.layout.Size = end - v.pos
+	return a.layout, nil
+}
+
+// layoutWalker walks the values of a [Layout].
+type layoutWalker struct {
+	layout  *Layout
+	largest int
+}
+
+// level returns the layout of level i.
+func (a *layoutWalker) level(i int) *LevelLayout {
+	for len(a.layout.Levels) <= i {
+		a.layout.Levels = append(a.layout.Levels, LevelLayout{})
+	}
+	return &a.layout.Levels[i]
+}
+
+// chain counts a list of n keys at level l.
+func (l *LevelLayout) chain(n int) {
+	for len(l.Chains) <= n {
+		l.Chains = append(l.Chains, 0)
+	}
+	l.Lists++
+	l.Chains[n]++
+}
+
+// leaf counts a value of size at path, which is neither an object nor an array.
+func (a *layoutWalker) leaf(path []string, size int64) {
+	largest := a.layout.Largest
+	if a.largest <= 0 || len(largest) == a.largest && largest[len(largest)-1].Size >= size {
+		return
+	}
+	i, _ := slices.BinarySearchFunc(largest, size, func(v LargeValue, size int64) int {
+		if v.Size >= size {
+			return -1
+		}
+		return 1
+	})
+	largest = slices.Insert(largest, i, LargeValue{Path: slices.Clone(path), Size: size})
+	a.layout.Largest = largest[:min(len(largest), a.largest)]
+}
+
+// value walks the value at pos of src at level, and returns the end position of it,
+// and whether it is an object or an array, which is counted at level.
+// The other values are counted at the level of their container,
+// or level 0 if the value is the root.
+func (a *layoutWalker) value(src *Source, pos int64, level int, path []string) (end int64, container bool, err error) {
+	r := src.reader(pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	tm := typeMarker(tb)
+	switch t := tm.Type(); t {
+	case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
+		var obj Object
+		if err = obj.read(&r, tm); err != nil {
+			return
+		}
+		end, err = a.object(&obj, pos, level, path)
+		return end, true, err
+	case typeArray, typeTypedArray:
+		var array Array
+		if err = array.read(&r, tm); err != nil {
+			return
+		}
+		end, err = a.array(&r, &array, pos, level, path)
+		return end, true, err
+	case typeNull:
+	case typeInt, typeUint:
+		_, err = readUintValue(&r)
+	case typeBool:
+		_, err = readBoolValue(&r)
+	case typeFloat:
+		_, err = readFloatValue(&r)
+	case typeString, typeBinary, typeGob:
+		var length int
+		if length, err = readBinaryLength(&r); err == nil {
+			err = r.skip(uint64(length))
+		}
+	case typeCompressed:
+		if _, err = readUintValue(&r); err == nil {
+			_, err = readBinaryView(&r)
+		}
+	case typeRef:
+		_, err = readFixedUint(&r, tm.OffsetSize())
+	default:
+		err = fmt.Errorf("failed to read value: invalid type %v", t)
+	}
+	if err != nil {
+		return
+	}
+	end = r.pos()
+	a.level(max(level-1, 0)).ValueBytes += end - pos
+	a.leaf(path, end-pos)
+	return
+}
+
+// containerWalker counts the bytes of an object or an array.
+type containerWalker struct {
+	*layoutWalker
+	depth       int   // level of the container
+	end         int64 // end of the container so far
+	table, keys int64 // bytes of the offset table and the keys
+	values      int64 // bytes of the values counted at the level
+	nested      int64 // bytes of the containers nested
+	path        []string
+}
+
+// elem walks the value at pos of the container, whose key or index is key.
+func (c *containerWalker) elem(src *Source, pos int64, key string) (err error) {
+	end, container, err := c.value(src, pos, c.depth+1, append(c.path, key))
+	if err != nil {
+		return
+	}
+	if container {
+		c.nested += end - pos
+	} else {
+		c.values += end - pos
+	}
+	c.end = max(c.end, end)
+	return
+}
+
+// done counts the bytes of the container at pos.
+func (c *containerWalker) done(pos int64) {
+	l := c.level(c.depth)
+	l.TableBytes += c.table
+	l.KeyBytes += c.keys
+	l.OtherBytes += c.end - pos - c.table - c.keys - c.values - c.nested
+}
+
+// array walks array at pos, whose descriptor is read from r.
+func (a *layoutWalker) array(r *reader, array *Array, pos int64, level int, path []string) (end int64, err error) {
+	l := a.level(level)
+	l.Arrays++
+	l.Elems += array.length
+	width := int64(array.offsetSize)
+	table := int64(array.length) * width
+	if array.elem != typeNull {
+		l.TypedArrays++
+		var data int64
+		switch array.elem {
+		case typeBool:
+			data = int64(array.length+7) / 8
+			table = 0
+		case typeString:
+			if array.length > 0 {
+				var u uint64
+				if u, err = array.readElem(r, array.length-1); err != nil {
+					return
+				}
+				data = r.pos() + int64(u) - array.pos - table
+			}
+		default:
+			data, table = table, 0
+		}
+		l.TableBytes += table
+		l.ValueBytes += data
+		l.OtherBytes += array.pos - pos
+		return array.pos + table + data, nil
+	}
+	l.OffsetSizes[array.offsetSize]++
+	c := containerWalker{layoutWalker: a, depth: level, end: array.pos + table, table: table, path: slices.Clip(path)}
+	var errElem error
+	if err = array.Range(func(i int, elem Value) bool {
+		errElem = c.elem(array.src, elem.pos, strconv.Itoa(i))
+		return errElem == nil
+	}); err == nil {
+		err = errElem
+	}
+	if err != nil {
+		return
+	}
+	c.done(pos)
+	return c.end, nil
+}
+
+// object walks obj at pos.
+func (a *layoutWalker) object(obj *Object, pos int64, level int, path []string) (end int64, err error) {
+	l := a.level(level)
+	l.Objects++
+	l.OffsetSizes[obj.offsetSize]++
+	c := containerWalker{layoutWalker: a, depth: level, path: slices.Clip(path)}
+	switch obj.layout {
+	case typeSlotObject:
+		err = c.slots(obj)
+	case typeMPHObject:
+		l.MPHObjects++
+		c.table = obj.pos - obj.mph.seedsPos
+		err = c.lists(obj)
+	default:
+		if obj.filter.blockLength > 0 {
+			l.Filters++
+			c.table = int64(obj.filter.encodedSize())
+		}
+		if obj.sortedPos != 0 {
+			// Before the lists, which may grow the levels l is in.
+			l.Sorted++
+		}
+		err = c.lists(obj)
+		if err == nil && obj.sortedPos != 0 {
+			err = c.sortedIndex(obj)
+		}
+	}
+	if err != nil {
+		return
+	}
+	c.done(pos)
+	return c.end, nil
+}
+
+// lists walks the bucket lists of obj, which is not a [typeSlotObject].
+func (c *containerWalker) lists(obj *Object) (err error) {
+	r := obj.src.reader(obj.pos)
+	defer r.close()
+	lists := obj.bucketCount
+	if obj.layout != typeMPHObject {
+		lists = 0
+		for range obj.bucketCount {
+			var offset uint64
+			if offset, err = readFixedUint(&r, obj.offsetSize); err != nil {
+				return
+			}
+			if offset != 0 {
+				lists++
+			}
+		}
+	}
+	l := c.level(c.depth)
+	l.Buckets += int(obj.bucketCount)
+	table := int64(obj.bucketCount) * int64(obj.offsetSize)
+	c.table += table
+	c.end = obj.pos + table
+	r.seek(c.end)
+	for range lists {
+		var listLen uint64 = 1
+		if obj.layout != typeMPHObject {
+			if err = obj.skipPadding(&r); err != nil {
+				return
+			}
+			if listLen, err = readUintValue(&r); err != nil {
+				return
+			}
+		}
+		l = c.level(c.depth)
+		l.Keys += int(listLen)
+		l.chain(int(listLen))
+		if obj.layout == typeFingerprintObject {
+			if err = r.skip(listLen * fingerprintSize); err != nil {
+				return
+			}
+		}
+		for range listLen {
+			if err = obj.skipPadding(&r); err != nil {
+				return
+			}
+			var key string
+			if key, err = readStringValue(&r); err != nil {
+				return
+			}
+			c.keys += int64(len(key))
+			var valueSize uint64
+			if valueSize, err = readUintValue(&r); err != nil {
+				return
+			}
+			valuePos := r.pos()
+			if err = c.elem(obj.src, valuePos, key); err != nil {
+				return
+			}
+			r.seek(valuePos)
+			if err = r.skip(valueSize); err != nil {
+				return
+			}
+			c.end = max(c.end, r.pos())
+		}
+	}
+	return
+}
+
+// sortedIndex counts the sorted index of obj.
+func (c *containerWalker) sortedIndex(obj *Object) (err error) {
+	r := obj.src.reader(obj.sortedPos)
+	defer r.close()
+	idx, err := obj.readSortedIndex(&r)
+	if err != nil {
+		return
+	}
+	c.table += idx.end - obj.sortedPos
+	c.end = max(c.end, idx.end)
+	return
+}
+
+// slots walks the slots of obj, which is a [typeSlotObject].
+// The runs of occupied slots are counted as lists.
+func (c *containerWalker) slots(obj *Object) (err error) {
+	r := obj.src.reader(obj.pos)
+	defer r.close()
+	size := int64(obj.slots.size())
+	l := c.level(c.depth)
+	l.SlotObjects++
+	l.Buckets += int(obj.bucketCount)
+	c.end = obj.pos + int64(obj.bucketCount)*size
+	// Inline values are in the slot table.
+	table := c.end - obj.pos
+	// The run before the first empty slot continues the run at the end of the table.
+	var run, firstRun, keys int
+	seenEmpty := false
+	for s := range obj.bucketCount {
+		pos := obj.pos + int64(s)*size
+		r.seek(pos)
+		var p []byte
+		if p, err = r.next(int(size)); err != nil {
+			return
+		}
+		if p[0] == 0 {
+			if !seenEmpty {
+				firstRun, seenEmpty = run, true
+			} else if run > 0 {
+				c.level(c.depth).chain(run)
+			}
+			run = 0
+			continue
+		}
+		run++
+		var key []byte
+		if key, err = obj.slotKey(p); err != nil {
+			return
+		}
+		k := string(key)
+		keys++
+		c.keys += int64(len(k))
+		inline := p[0]&slotOutOfLine == 0
+		if err = obj.slotValue(&r, p, pos); err != nil {
+			return
+		}
+		before := c.values + c.nested
+		if err = c.elem(obj.src, r.pos(), k); err != nil {
+			return
+		}
+		if inline {
+			table -= c.values + c.nested - before
+		}
+	}
+	l = c.level(c.depth)
+	if run += firstRun; run > 0 {
+		l.chain(run)
+	}
+	l.Keys += keys
+	c.table += table - c.keys
+	return
+}
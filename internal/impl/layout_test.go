@@ -0,0 +1,95 @@
+package impl
+
+import (
+	"bytes"
+	"slices"
+	"strconv"
+	"strings"
+	"testing"
+)
+
+func TestLayout(t *testing.T) {
+	long := strings.Repeat("x", 300)
+	elems := make([]any, 50)
+	for i := range elems {
+		elems[i] = map[string]any{"i": int64(i), "s": []any{"a", "b"}}
+	}
+	obj := map[string]any{
+		"long":   long,
+		"elems":  elems,
+		"ints":   []any{int64(1), int64(2), int64(3)},
+		"bools":  []any{true, false},
+		"null":   nil,
+		"nested": map[string]any{"abcdefghijklmnopqrstuvwxyz": 1.5},
+	}
+	for i := range 100 {
+		obj[strconv.Itoa(i)] = strconv.Itoa(i * i)
+	}
+	for name, opts := range map[string]*WriteOptions{
+		"chained":    {Gob: NewGobEncoder()},
+		"mph":        {Gob: NewGobEncoder(), MinimalPerfectHash: true},
+		"aligned":    {Gob: NewGobEncoder(), Aligned: true},
+		"inline":     {Gob: NewGobEncoder(), InlineKeySize: 16},
+		"typed":      {Gob: NewGobEncoder(), TypedArrays: true},
+		"compressed": {Gob: NewGobEncoder(), Compressor: NewCompressor(nil, 100)},
+	} {
+		t.Run(name, func(t *testing.T) {
+			var buf bytes.Buffer
+			if err := EncodeValue(&buf, obj, opts); err != nil {
+				t.Fatal(err)
+			}
+			layout, err := NewReaderAtSource(bytes.NewReader(buf.Bytes()), 16).Value(0).Layout(3)
+			if err != nil {
+				t.Fatal(err)
+			}
+			if layout.Size != int64(buf.Len()) || len(layout.Levels) != 4 {
+				t.Fatal(layout.Size, len(layout.Levels))
+			}
+			var size int64
+			for i := range layout.Levels {
+				l := &layout.Levels[i]
+				size += l.TableBytes + l.KeyBytes + l.ValueBytes + l.OtherBytes
+				if l.OtherBytes < 0 || l.TableBytes < 0 {
+					t.Fatalf("%v: %+v", i, l)
+				}
+				var lists, keys int
+				for n, count := range l.Chains {
+					lists += count
+					keys += n * count
+				}
+				if lists != l.Lists || keys != l.Keys || l.Lists > l.Buckets {
+					t.Fatalf("%v: %+v", i, l)
+				}
+			}
+			if size != layout.Size {
+				t.Fatal(size, layout.Size)
+			}
+			root := &layout.Levels[0]
+			if root.Objects != 1 || root.Keys != len(obj) || root.LoadFactor() <= 0 || root.MaxChain() < 1 {
+				t.Fatalf("%+v", root)
+			}
+			if opts.InlineKeySize > 0 && root.SlotObjects != 1 || opts.MinimalPerfectHash && root.MPHObjects != 1 {
+				t.Fatalf("%+v", root)
+			}
+			typed := 0
+			if opts.TypedArrays {
+				typed = 2
+			}
+			if l := &layout.Levels[1]; l.Objects != 1 || l.Arrays != 3 || l.TypedArrays != typed || l.Elems != 55 {
+				t.Fatalf("%+v", l)
+			}
+			if l := &layout.Levels[2]; l.Objects != 50 || l.Keys != 100 {
+				t.Fatalf("%+v", l)
+			}
+			if l := &layout.Levels[3]; l.Arrays != 50 || l.TypedArrays != typed*25 || l.Elems != 100 {
+				t.Fatalf("%+v", l)
+			}
+			if len(layout.Largest) != 3 || !slices.Equal(layout.Largest[0].Path, []string{"long"}) {
+				t.Fatal(layout.Largest)
+			}
+			if layout.Largest[0].Size < layout.Largest[1].Size || layout.Largest[1].Size < layout.Largest[2].Size {
+				t.Fatal(layout.Largest)
+			}
+		})
+	}
+}
@@ -0,0 +1,12 @@
+package impl
+
+import "syscall"
+
+// adviseWillNeed advises the kernel to page in p, which is memory mapped.
+// The pages are read asynchronously.
+func adviseWillNeed(p []byte) error {
+	if len(p) == 0 {
+		return nil
+	}
+	return syscall.Madvise(p, syscall.MADV_WILLNEED)
+}
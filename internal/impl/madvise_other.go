@@ -0,0 +1,16 @@
+//go:build !linux
+
+package impl
+
+import "os"
+
+// adviseWillNeed pages in p, which is memory mapped,
+// by reading a byte of every page, for madvise is not available on this platform.
+func adviseWillNeed(p []byte) error {
+	var sum byte
+	for i := 0; i < len(p); i += os.Getpagesize() {
+		sum += p[i]
+	}
+	_ = sum
+	return nil
+}
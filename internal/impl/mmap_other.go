@@ -0,0 +1,19 @@
+//go:build !unix
+
+package impl
+
+import (
+	"io"
+	"os"
+)
+
+// Mmap reads the entire content of f into memory,
+// for memory mapping is not supported on this platform.
+// The returned munmap function does nothing.
+func Mmap(f *os.File) (data []byte, munmap func() error, err error) {
+	if data, err = io.ReadAll(f); err != nil {
+		return
+	}
+	munmap = func() error { return nil }
+	return
+}
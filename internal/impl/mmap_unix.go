@@ -0,0 +1,34 @@
+//go:build unix
+
+package impl
+
+import (
+	"fmt"
+	"math"
+	"os"
+	"syscall"
+)
+
+// Mmap maps the entire content of f into memory read-only.
+// The returned munmap function must be called to unmap the data after use.
+func Mmap(f *os.File) (data []byte, munmap func() error, err error) {
+	info, err := f.Stat()
+	if err != nil {
+		return
+	}
+	size := info.Size()
+	if size == 0 {
+		return []byte{}, func() error { return nil }, nil
+	}
+	if size > math.MaxInt {
+		err = fmt.Errorf("file too large to mmap: %v", size)
+		return
+	}
+	if data, err = syscall.Mmap(int(f.Fd()), 0, int(size), syscall.PROT_READ, syscall.MAP_SHARED); err != nil {
+		return
+	}
+	munmap = func() error {
+		return syscall.Munmap(data)
+	}
+	return
+}
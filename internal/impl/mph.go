@@ -0,0 +1,310 @@
+package impl
+
+import (
+	"bytes"
+	"errors"
+	"fmt"
+	"io"
+	"math/bits"
+	"slices"
+)
+
+// The minimal perfect hash is a CHD (Compress, Hash and Displace) variant.
+// Keys are grouped into displacement buckets by their hashes.
+// Each bucket has a seed, which is searched at write time,
+// so that the keys of all buckets are hashed to distinct slots.
+// A few more slots than keys are used to speed up the search,
+// and the slots beyond the key count are remapped to the free slots
+// before the key count, so that the offset table has exactly one
+// offset per key.
+
+const (
+	mphBucketSize = 4       // average key count of a displacement bucket
+	mphMaxSeed    = 1 << 24 // max seed to try for a bucket
+)
+
+// errMPHBuild is returned when the minimal perfect hash can't be built,
+// for example two keys have the same hash.
+var errMPHBuild = errors.New("failed to build minimal perfect hash")
+
+// mphHeader is the minimal perfect hash of a [typeMPHObject].
+type mphHeader struct {
+	buckets   uint64 // displacement bucket count
+	slots     uint64 // slot count, which is greater than or equal to the key count
+	seedSize  byte
+	indexSize byte
+	seedsPos  int64 // position of the seeds
+	remapPos  int64 // position of the remapped slots
+}
+
+// mphBucket returns the displacement bucket of a hash.
+func mphBucket(hash, buckets uint64) uint64 {
+	hi, _ := bits.Mul64(mixHash(hash), buckets)
+	return hi
+}
+
+// mphSlot returns the slot of a hash displaced by seed.
+func mphSlot(hash, seed, slots uint64) uint64 {
+	hi, _ := bits.Mul64(mixHash(hash^(seed+1)*0x9E3779B97F4A7C15), slots)
+	return hi
+}
+
+// mph is a minimal perfect hash being built.
+type mph struct {
+	buckets, slots uint64
+	seeds          []uint64
+	remap          []uint64 // slot-keyCount to slot
+}
+
+// buildMPH builds the minimal perfect hash of hashes,
+// and returns the slot of every hash.
+func buildMPH(hashes []uint64) (m *mph, keySlots []uint64, err error) {
+	n := uint64(len(hashes))
+	m = &mph{
+		buckets: n/mphBucketSize + 1,
+		slots:   n + n/100 + 1,
+	}
+	// Group the keys by bucket with a counting sort.
+	bucketStarts := make([]int, m.buckets+1)
+	for _, hash := range hashes {
+		bucketStarts[mphBucket(hash, m.buckets)+1]++
+	}
+	for i := 1; i < len(bucketStarts); i++ {
+		bucketStarts[i] += bucketStarts[i-1]
+	}
+	bucketKeys := make([]int, n)
+	fill := slices.Clone(bucketStarts[:m.buckets])
+	for k, hash := range hashes {
+		b := mphBucket(hash, m.buckets)
+		bucketKeys[fill[b]] = k
+		fill[b]++
+	}
+	// Place the largest buckets first.
+	order := make([]int, m.buckets)
+	for i := range order {
+		order[i] = i
+	}
+	slices.SortStableFunc(order, func(a, b int) int {
+		return (bucketStarts[b+1] - bucketStarts[b]) - (bucketStarts[a+1] - bucketStarts[a])
+	})
+
+	m.seeds = make([]uint64, m.buckets)
+	keySlots = make([]uint64, n)
+	taken := make([]uint64, (m.slots+63)/64)
+	isTaken := func(slot uint64) bool { return taken[slot/64]&(1<<(slot%64)) != 0 }
+	setTaken := func(slot uint64, v bool) {
+		if v {
+			taken[slot/64] |= 1 << (slot % 64)
+		} else {
+			taken[slot/64] &^= 1 << (slot % 64)
+		}
+	}
+	for _, b := range order {
+		keys := bucketKeys[bucketStarts[b]:bucketStarts[b+1]]
+		if len(keys) == 0 {
+			break // The rest are all empty.
+		}
+		for i, k := range keys {
+			for _, k2 := range keys[i+1:] {
+				if hashes[k] == hashes[k2] {
+					return nil, nil, errMPHBuild // Keys with the same hash can't be separated.
+				}
+			}
+		}
+	search:
+		for seed := uint64(0); ; seed++ {
+			if seed == mphMaxSeed {
+				return nil, nil, errMPHBuild
+			}
+			for i, k := range keys {
+				slot := mphSlot(hashes[k], seed, m.slots)
+				if isTaken(slot) {
+					for _, k := range keys[:i] {
+						setTaken(keySlots[k], false)
+					}
+					continue search
+				}
+				setTaken(slot, true)
+				keySlots[k] = slot
+			}
+			m.seeds[b] = seed
+			break
+		}
+	}
+
+	// Remap the taken slots beyond n to the free slots before n.
+	m.remap = make([]uint64, m.slots-n)
+	free := uint64(0)
+	for slot := n; slot < m.slots; slot++ {
+		if !isTaken(slot) {
+			continue
+		}
+		for isTaken(free) {
+			free++
+		}
+		m.remap[slot-n] = free
+		setTaken(free, true)
+	}
+	for k, slot := range keySlots {
+		if slot >= n {
+			keySlots[k] = m.remap[slot-n]
+		}
+	}
+	return
+}
+
+// writeMPHObject writes an object of entries to w as [typeMPHObject].
+// See [writeEntries] for copyValue.
+// The returned error is [errMPHBuild] if the minimal perfect hash can't be built.
+// The object is reported to report.
+func writeMPHObject(w io.Writer, entries []objectEntry, copyValue func(w io.Writer, e *objectEntry) error, report *WriteReport) (err error) {
+	hashes := make([]uint64, len(entries))
+	for i := range entries {
+		hashes[i] = entries[i].hash
+	}
+	m, keySlots, err := buildMPH(hashes)
+	if err != nil {
+		return
+	}
+	slotEntries := make([]int, len(entries))
+	for i, slot := range keySlots {
+		slotEntries[slot] = i
+	}
+
+	offsets := make([]int, len(slotEntries))
+	dataSize := 0
+	for i, e := range slotEntries {
+		offsets[i] = dataSize
+		dataSize += int(entries[e].encodedSize())
+	}
+	offsetSize, err := tableOffsetSize(offsets[len(offsets)-1], len(offsets))
+	if err != nil {
+		return
+	}
+	report.object(typeMPHObject, len(entries), offsetSize)
+
+	seedSize := fixedUintSize(slices.Max(m.seeds))
+	indexSize := fixedUintSize(uint64(len(entries) - 1))
+	var header bytes.Buffer
+	header.WriteByte(byte(newTypeMarker(typeMPHObject, offsetSize)))
+	writeUintValue(&header, 0) // Flags, none is defined yet.
+	writeUintValue(&header, uint64(len(entries)))
+	writeUintValue(&header, m.buckets)
+	writeUintValue(&header, m.slots)
+	header.WriteByte(seedSize)
+	header.WriteByte(indexSize)
+	for _, seed := range m.seeds {
+		writeFixedUint(&header, seed, seedSize)
+	}
+	for _, slot := range m.remap {
+		writeFixedUint(&header, slot, indexSize)
+	}
+	// Offsets are relative to the start of the offset table.
+	delta := len(offsets) * int(offsetSize)
+	for _, offset := range offsets {
+		writeFixedUint(&header, uint64(offset+delta), offsetSize)
+	}
+	if _, err = w.Write(header.Bytes()); err != nil {
+		return
+	}
+
+	for _, e := range slotEntries {
+		if err = writeEntry(w, &entries[e], copyValue); err != nil {
+			return
+		}
+	}
+	return
+}
+
+// readMPH reads the descriptor of a [typeMPHObject] from r after the type mark tm.
+func (obj *Object) readMPH(r *reader, tm typeMarker) (err error) {
+	var header [4]uint64 // flags, key count, buckets and slots
+	for i := range header {
+		if header[i], err = readUintValue(r); err != nil {
+			return
+		}
+	}
+	flags, keyCount, buckets, slots := header[0], header[1], header[2], header[3]
+	if flags != 0 {
+		err = fmt.Errorf("failed to read object: unknown flags %#x", flags)
+		return
+	}
+	if keyCount == 0 || buckets == 0 || slots < keyCount {
+		err = fmt.Errorf("failed to read object: invalid hash %v/%v/%v", keyCount, buckets, slots)
+		return
+	}
+	var sizes [2]byte // seed size and index size
+	for i := range sizes {
+		if sizes[i], err = r.ReadByte(); err != nil {
+			return
+		}
+		if sizes[i] < 1 || sizes[i] > 8 {
+			err = fmt.Errorf("invalid size %v", sizes[i])
+			return
+		}
+	}
+	mph := mphHeader{
+		buckets:   buckets,
+		slots:     slots,
+		seedSize:  sizes[0],
+		indexSize: sizes[1],
+		seedsPos:  r.pos(),
+	}
+	seedsSize, remapSize := buckets*uint64(mph.seedSize), (slots-keyCount)*uint64(mph.indexSize)
+	if err = r.skip(seedsSize); err != nil {
+		return
+	}
+	mph.remapPos = r.pos()
+	if err = r.skip(remapSize); err != nil {
+		return
+	}
+	*obj = Object{
+		src:         r.src,
+		pos:         r.pos(),
+		bucketCount: keyCount,
+		offsetSize:  tm.OffsetSize(),
+		layout:      typeMPHObject,
+		mph:         mph,
+	}
+	return
+}
+
+// slotMPH is the [Object.slot] of a [typeMPHObject].
+func (obj *Object) slotMPH(r *reader, hash uint64) (slot uint64, err error) {
+	m := &obj.mph
+	r.seek(m.seedsPos + int64(mphBucket(hash, m.buckets))*int64(m.seedSize))
+	seed, err := readFixedUint(r, m.seedSize)
+	if err != nil {
+		return
+	}
+	slot = mphSlot(hash, seed, m.slots)
+	if slot >= obj.bucketCount {
+		r.seek(m.remapPos + int64(slot-obj.bucketCount)*int64(m.indexSize))
+		if slot, err = readFixedUint(r, m.indexSize); err != nil {
+			return
+		}
+		if slot >= obj.bucketCount {
+			err = fmt.Errorf("invalid slot %v", slot)
+			return
+		}
+	}
+	return
+}
+
+// verifyMPH is the [Object.scanList] of a [typeMPHObject].
+// Every slot holds a key, which is compared with key.
+func (obj *Object) verifyMPH(r *reader, key string) (err error) {
+	r.src.stats.probe()
+	entryKey, err := readBinaryView(r)
+	if err != nil {
+		return
+	}
+	found := key == string(entryKey)
+	if _, err = readUintValue(r); err != nil { // Value size
+		return
+	}
+	if !found {
+		return ErrNotFound
+	}
+	return
+}
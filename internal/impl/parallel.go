@@ -0,0 +1,109 @@
+package impl
+
+import (
+	"bytes"
+	"sync"
+)
+
+// Workers limits the number of goroutines encoding values in parallel.
+// A Workers is shared by all the nested arrays and objects of a value,
+// so parallelism is not lost when the top-level value has few elements.
+type Workers struct {
+	n   int
+	sem chan struct{}
+}
+
+// NewWorkers creates a Workers that encodes values with at most n goroutines,
+// including the goroutine writing the value.
+// n is at least 1.
+func NewWorkers(n int) *Workers {
+	n = max(n, 1)
+	return &Workers{n: n, sem: make(chan struct{}, n-1)}
+}
+
+// tryGo calls f in a new goroutine added to wg if a worker is idle,
+// and returns whether it did.
+func (workers *Workers) tryGo(wg *sync.WaitGroup, f func()) bool {
+	select {
+	case workers.sem <- struct{}{}:
+		wg.Add(1)
+		go func() {
+			defer func() {
+				<-workers.sem
+				wg.Done()
+			}()
+			f()
+		}()
+		return true
+	default:
+		return false
+	}
+}
+
+// encodeValues encodes the n values returned by value into data.
+// The value i is data[offsets[i]:offsets[i+1]].
+// The values are encoded in chunks in parallel if opts.Workers is not nil.
+// Chunks that can't get an idle worker are encoded by the calling goroutine,
+// so nested calls never wait for each other.
+func encodeValues(n int, value func(i int) any, opts *WriteOptions) (data []byte, offsets []int, err error) {
+	offsets = make([]int, n+1)
+	if opts.Workers == nil || opts.Workers.n == 1 || n < 2 {
+		var buf bytes.Buffer
+		for i := range n {
+			if err = EncodeValue(&buf, value(i), opts); err != nil {
+				return
+			}
+			offsets[i+1] = buf.Len()
+		}
+		return buf.Bytes(), offsets, nil
+	}
+
+	type chunk struct {
+		start, end int // range of values
+		buf        bytes.Buffer
+		err        error
+		panicked   any // recovered panic of the gob encoder
+	}
+	chunks := make([]chunk, min(n, opts.Workers.n*4))
+	var wg sync.WaitGroup
+	for c := range chunks {
+		ck := &chunks[c]
+		ck.start, ck.end = c*n/len(chunks), (c+1)*n/len(chunks)
+		encode := func() {
+			defer func() {
+				ck.panicked = recover()
+			}()
+			for i := ck.start; i < ck.end; i++ {
+				if ck.err = EncodeValue(&ck.buf, value(i), opts); ck.err != nil {
+					return
+				}
+				offsets[i+1] = ck.buf.Len() // Relative to the chunk.
+			}
+		}
+		if !opts.Workers.tryGo(&wg, encode) {
+			encode()
+		}
+	}
+	wg.Wait()
+
+	size := 0
+	for c := range chunks {
+		if p := chunks[c].panicked; p != nil {
+			panic(p)
+		}
+		if err = chunks[c].err; err != nil {
+			return
+		}
+		size += chunks[c].buf.Len()
+	}
+	data = make([]byte, 0, size)
+	for c := range chunks {
+		ck := &chunks[c]
+		base := len(data)
+		for i := ck.start; i < ck.end; i++ {
+			offsets[i+1] += base
+		}
+		data = append(data, ck.buf.Bytes()...)
+	}
+	return
+}
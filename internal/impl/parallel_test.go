@@ -0,0 +1,51 @@
+package impl
+
+import (
+	"bytes"
+	"strconv"
+	"testing"
+)
+
+func TestEncodeValuesParallel(t *testing.T) {
+	array := make([]any, 1000)
+	for i := range array {
+		array[i] = []any{int64(i), strconv.Itoa(i), []any{float64(i)}}
+	}
+	var seq, par bytes.Buffer
+	if err := writeArray(&seq, array, &WriteOptions{}); err != nil {
+		t.Fatal(err)
+	}
+	if err := writeArray(&par, array, &WriteOptions{Workers: NewWorkers(4)}); err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.Equal(seq.Bytes(), par.Bytes()) {
+		t.Fatal("parallel encoding differs")
+	}
+
+	obj := make(map[string]any)
+	for i := range 1000 {
+		obj[strconv.Itoa(i)] = map[string]any{"i": int64(i)}
+	}
+	var buf bytes.Buffer
+	if err := writeObject(&buf, obj, &WriteOptions{Workers: NewWorkers(4)}); err != nil {
+		t.Fatal(err)
+	}
+	readObj, err := NewBytesSource(buf.Bytes()).Value(0).Decode(true)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if m := readObj.(map[string]any); len(m) != len(obj) || m["999"].(map[string]any)["i"] != int64(999) {
+		t.Fatal(m["999"])
+	}
+}
+
+func TestEncodeValuesPanic(t *testing.T) {
+	defer func() {
+		if recover() == nil {
+			t.Fatal("panic expected")
+		}
+	}()
+	array := make([]any, 100)
+	array[50] = make(chan int) // Channels can't be gob encoded.
+	writeArray(&bytes.Buffer{}, array, &WriteOptions{Gob: NewGobEncoder(), Workers: NewWorkers(4)})
+}
@@ -0,0 +1,156 @@
+package impl
+
+import (
+	"bytes"
+	"cmp"
+	"fmt"
+	"slices"
+)
+
+// The string pool of a database is a section of the file header,
+// which stores every string and []byte value that occurs more than once.
+// The occurrences are written as references to the pool:
+//
+//	type mark | offset
+//
+// The offset size of the type mark is the size of the offset,
+// which is relative to the start of the pool, see [Header.Pool].
+
+// poolMinLen is the min length of strings and []byte stored in a [StringPool].
+// A reference is at least 2 bytes, shorter values are not worth it.
+const poolMinLen = 4
+
+type poolKey struct {
+	t typ // typeString or typeBinary
+	s string
+}
+
+// StringPool is the string pool of the values to write.
+type StringPool struct {
+	data       []byte
+	offsets    map[poolKey]uint64
+	offsetSize byte
+}
+
+// NewStringPool creates a StringPool of the strings and []byte that occur
+// more than once in v, which is to be written with opts.
+// Pooled values are compressed if opts.Compressor is not nil.
+func NewStringPool(v any, opts *WriteOptions) *StringPool {
+	counts := make(map[poolKey]int)
+	countStrings(v, opts, counts)
+	var keys []poolKey
+	for key, n := range counts {
+		if n > 1 {
+			keys = append(keys, key)
+		}
+	}
+	// Sort the keys, so the pool doesn't depend on the iteration order of maps.
+	slices.SortFunc(keys, func(a, b poolKey) int {
+		if a.t != b.t {
+			return cmp.Compare(a.t, b.t)
+		}
+		return cmp.Compare(a.s, b.s)
+	})
+
+	pool := &StringPool{offsets: make(map[poolKey]uint64, len(keys))}
+	poolOpts := *opts
+	poolOpts.Pool = nil // The pooled values are stored in place.
+	var buf bytes.Buffer
+	for _, key := range keys {
+		pool.offsets[key] = uint64(buf.Len())
+		if err := encodeBinary(&buf, key.t, []byte(key.s), &poolOpts); err != nil {
+			panic(err) // bytes.Buffer never fails
+		}
+	}
+	pool.data = buf.Bytes()
+	pool.offsetSize = fixedUintSize(uint64(len(pool.data)))
+	return pool
+}
+
+// countStrings counts the occurrences of strings and []byte in v.
+func countStrings(v any, opts *WriteOptions, counts map[poolKey]int) {
+	switch v := v.(type) {
+	case string:
+		if len(v) >= poolMinLen {
+			counts[poolKey{typeString, v}]++
+		}
+	case []byte:
+		if len(v) >= poolMinLen {
+			counts[poolKey{typeBinary, string(v)}]++
+		}
+	case []any:
+		if opts.TypedArrays {
+			// The strings of typed arrays are stored in place.
+			if _, ok := typedArrayElems(v); ok {
+				return
+			}
+		}
+		for _, elem := range v {
+			countStrings(elem, opts, counts)
+		}
+	case map[string]any:
+		for _, value := range v {
+			countStrings(value, opts, counts)
+		}
+	}
+}
+
+// Bytes returns the content of pool.
+func (pool *StringPool) Bytes() []byte {
+	if pool == nil {
+		return nil
+	}
+	return pool.data
+}
+
+// writeRef writes a reference to p of type t if p is in pool.
+func (pool *StringPool) writeRef(w ByteWriter, t typ, p []byte) (ok bool, err error) {
+	offset, ok := pool.offsets[poolKey{t, string(p)}]
+	if !ok {
+		return
+	}
+	if err = w.WriteByte(byte(newTypeMarker(typeRef, pool.offsetSize))); err != nil {
+		return
+	}
+	err = writeFixedUint(w, offset, pool.offsetSize)
+	return
+}
+
+// readRef reads a reference from r after the type mark,
+// and returns the value it refers to.
+func readRef(r *reader, offsetSize byte) (v Value, err error) {
+	offset, err := readFixedUint(r, offsetSize)
+	if err != nil {
+		return
+	}
+	if offset >= r.src.poolSize {
+		err = fmt.Errorf("failed to read reference: invalid offset %v", offset)
+		return
+	}
+	return Value{src: r.src, pos: r.src.poolPos + int64(offset)}, nil
+}
+
+// readIndirect reads a compressed value or a reference from r after the type mark,
+// and returns the value it stands for.
+func readIndirect(r *reader) (v Value, err error) {
+	r.seek(r.pos() - 1)
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	switch tm := typeMarker(tb); tm.Type() {
+	case typeCompressed:
+		return inflateValue(r)
+	case typeRef:
+		return readRef(r, tm.OffsetSize())
+	default:
+		err = &TypeError{tm.Type()}
+		return
+	}
+}
+
+// isIndirect returns whether err is the [TypeError] of a compressed value or a reference.
+func isIndirect(err error) bool {
+	typeErr, ok := err.(*TypeError)
+	return ok && (typeErr.t == typeCompressed || typeErr.t == typeRef)
+}
@@ -0,0 +1,75 @@
+package impl
+
+import (
+	"bytes"
+	"reflect"
+	"testing"
+)
+
+func TestStringPool(t *testing.T) {
+	obj := map[string]any{
+		"a":     "repeated",
+		"b":     "repeated",
+		"c":     []any{"repeated", []byte("repeated"), "abc", "abc"},
+		"d":     []byte("repeated"),
+		"once":  "only once",
+		"typed": []string{"repeated"},
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder(), TypedArrays: true},
+		{Gob: NewGobEncoder(), TypedArrays: true, Compressor: NewCompressor(nil, 1)},
+	} {
+		opts.Pool = NewStringPool(obj, opts)
+		if len(opts.Pool.offsets) != 2 {
+			t.Fatal(opts.Pool.offsets)
+		}
+		var buf bytes.Buffer
+		if err := WriteHeader(&buf, 0, opts.Header()); err != nil {
+			t.Fatal(err)
+		}
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+
+		src := NewReaderAtSource(bytes.NewReader(buf.Bytes()), 16)
+		_, pos, err := src.ReadHeader(0)
+		if err != nil {
+			t.Fatal(err)
+		}
+		root := src.Value(pos)
+		a, err := root.Lookup("a")
+		if err != nil {
+			t.Fatal(err)
+		}
+		r := src.reader(a.pos)
+		if b, _ := r.ReadByte(); typeMarker(b).Type() != typeRef {
+			t.Fatal(b)
+		}
+		r.close()
+		if s, err := a.Str(); err != nil || s != "repeated" {
+			t.Fatal(s, err)
+		}
+		if _, err := a.Int(); !isIndirect(err) {
+			t.Fatal(err)
+		}
+		d, _ := root.Lookup("d")
+		if p, err := d.AppendBytes(nil); err != nil || string(p) != "repeated" {
+			t.Fatal(p, err)
+		}
+		read, err := root.Decode(true)
+		if err != nil {
+			t.Fatal(err)
+		}
+		want := map[string]any{
+			"a":     "repeated",
+			"b":     "repeated",
+			"c":     []any{"repeated", []byte("repeated"), "abc", "abc"},
+			"d":     []byte("repeated"),
+			"once":  "only once",
+			"typed": []any{"repeated"},
+		}
+		if !reflect.DeepEqual(read, want) {
+			t.Fatal(read)
+		}
+	}
+}
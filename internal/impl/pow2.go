@@ -0,0 +1,63 @@
+package impl
+
+import "math/bits"
+
+// The bucket count of a [typeFingerprintObject] or a [typeSlotObject] flagged
+// with objectPow2 is a power of 2, see [WriteOptions.PowerOfTwo].
+// The bucket of a hash is selected by its high bits after a multiplication:
+//
+//	bucket = hash * pow2Multiplier >> (64 - log2(bucket count))
+//
+// So neither the writer searches for a prime nor the lookup divides.
+// Only the high bits of the product select the bucket, and every bit of the hash
+// is carried into them by the multiplication, so the keys differing in the low bits
+// of their hashes are spread over the buckets too.
+
+// Flag of [typeFingerprintObject] and [typeSlotObject].
+const objectPow2 = 2 // the bucket count is a power of 2
+
+// pow2Multiplier is 2^64 divided by the golden ratio, an odd number
+// whose products spread keys evenly over the high bits.
+const pow2Multiplier = 0x9E3779B97F4A7C15
+
+// pow2BucketCount returns the least power of 2 not less than n, and at least 1.
+func pow2BucketCount(n int) int {
+	if n <= 1 {
+		return 1
+	}
+	return 1 << bits.Len(uint(n-1))
+}
+
+// pow2Shift returns the shift of a bucket count which is a power of 2.
+// It is 64 for a single bucket, where every shifted hash is 0.
+func pow2Shift(bucketCount uint64) uint8 {
+	return uint8(64 - bits.TrailingZeros64(bucketCount))
+}
+
+// pow2Bucket returns the bucket of hash in the buckets of shift, see [pow2Shift].
+func pow2Bucket(hash uint64, shift uint8) uint64 {
+	return hash * pow2Multiplier >> shift
+}
+
+// bucketIndex selects the buckets of hashes.
+type bucketIndex struct {
+	count uint64
+	shift uint8 // shift of a power of 2 bucket count, or 0 if the bucket is selected by modulo
+}
+
+// newBucketIndex returns the bucketIndex of count buckets, where count is a power of 2 if pow2 is true.
+func newBucketIndex(count int, pow2 bool) bucketIndex {
+	index := bucketIndex{count: uint64(count)}
+	if pow2 {
+		index.shift = pow2Shift(index.count)
+	}
+	return index
+}
+
+// of returns the bucket of hash.
+func (index bucketIndex) of(hash uint64) uint64 {
+	if index.shift != 0 {
+		return pow2Bucket(hash, index.shift)
+	}
+	return hash % index.count
+}
@@ -0,0 +1,69 @@
+package impl
+
+import (
+	"bytes"
+	"strconv"
+	"testing"
+)
+
+func TestPow2BucketCount(t *testing.T) {
+	for n, want := range map[int]int{0: 1, 1: 1, 2: 2, 3: 4, 4: 4, 5: 8, 1000: 1024, 1024: 1024} {
+		if got := pow2BucketCount(n); got != want {
+			t.Fatal(n, got)
+		}
+	}
+	// Every bucket of a table is selected.
+	for _, count := range []int{1, 2, 16, 1024} {
+		index := newBucketIndex(count, true)
+		seen := make([]bool, count)
+		for i := range count * 16 {
+			b := index.of(HashWyhash.sum(strconv.Itoa(i)))
+			if b >= uint64(count) {
+				t.Fatal(count, b)
+			}
+			seen[b] = true
+		}
+		for b := range seen {
+			if !seen[b] {
+				t.Fatal(count, b)
+			}
+		}
+	}
+}
+
+func TestPow2Object(t *testing.T) {
+	obj := make(map[string]any)
+	for i := range 300 {
+		obj[strconv.Itoa(i)] = int64(i)
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder(), PowerOfTwo: true},
+		{Gob: NewGobEncoder(), PowerOfTwo: true, InlineKeySize: 8},
+	} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		o, err := NewBytesSource(buf.Bytes()).Value(0).Object()
+		if err != nil {
+			t.Fatal(err)
+		}
+		if o.bucketCount != 512 || o.shift != 55 {
+			t.Fatal(o.bucketCount, o.shift)
+		}
+		for key, want := range obj {
+			if v, err := o.Index(key, false); err != nil || v != want {
+				t.Fatal(key, v, err)
+			}
+		}
+		if _, err := o.Index("300", false); err != ErrNotFound {
+			t.Fatal(err)
+		}
+	}
+
+	// A bucket count which is not a power of 2 is invalid.
+	data := []byte{byte(newTypeMarker(typeFingerprintObject, 1)), objectPow2, 3, 0, 0, 0}
+	if _, err := NewBytesSource(data).Value(0).Object(); err == nil {
+		t.Fatal("invalid bucket count")
+	}
+}
@@ -0,0 +1,115 @@
+package impl
+
+import (
+	"io"
+	"os"
+)
+
+// prefetchBufferSize is the size of the buffer reading ahead a [Source] of an [io.ReaderAt].
+const prefetchBufferSize = 1 << 20
+
+// Prefetch hints that the n bytes at pos of src will be read soon,
+// or the bytes from pos to the end if n < 0.
+// Memory mapped data is advised to be paged in, see [NewMmapSource],
+// and the other storages are read through, so the OS caches
+// the content in the page cache. The content of a [NewBytesSource] is
+// in memory already, and nothing is done.
+func (src *Source) Prefetch(pos, n int64) (err error) {
+	if n < 0 {
+		n = maxPos - pos
+	}
+	if src.data != nil {
+		if !src.mapped || pos >= int64(len(src.data)) {
+			return
+		}
+		end := int64(len(src.data))
+		if n < end-pos {
+			end = pos + n
+		}
+		// The mapping starts at a page boundary.
+		pos -= pos % int64(os.Getpagesize())
+		return adviseWillNeed(src.data[pos:end])
+	}
+	if n <= 0 {
+		return
+	}
+	buf := make([]byte, min(n, prefetchBufferSize))
+	for n > 0 {
+		m, errRead := src.r.ReadAt(buf[:min(n, int64(len(buf)))], pos)
+		pos, n = pos+int64(m), n-int64(m)
+		if errRead == io.EOF {
+			return
+		} else if errRead != nil {
+			return errRead
+		} else if m == 0 {
+			return io.ErrNoProgress
+		}
+	}
+	return
+}
+
+// tableRange returns the range of the type mark, the header and the offset table
+// of v if v is an object or an untyped array.
+func (v Value) tableRange() (pos, end int64, ok bool, err error) {
+	if v.index > 0 {
+		return
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	tm := typeMarker(tb)
+	switch tm.Type() {
+	case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
+		var obj Object
+		if err = obj.read(&r, tm); err != nil {
+			return
+		}
+		end = obj.pos + int64(obj.bucketCount)*int64(obj.offsetSize)
+		if obj.layout == typeSlotObject {
+			end = obj.pos + int64(obj.bucketCount)*int64(obj.slots.size())
+		}
+	case typeArray:
+		var array Array
+		if err = array.read(&r, tm); err != nil {
+			return
+		}
+		end = array.pos + int64(array.length)*int64(array.offsetSize)
+	default:
+		return
+	}
+	return v.pos, end, true, nil
+}
+
+// PrefetchTables prefetches the offset table of v if v is an object or an array.
+// If recursive is true, the offset tables of all the objects and arrays in v are
+// prefetched too, which reads every bucket list and array element to find them.
+// Nothing is done if v is in memory, see [Source.Prefetch].
+func (v Value) PrefetchTables(recursive bool) (err error) {
+	if v.src.Resident() {
+		return
+	}
+	pos, end, ok, err := v.tableRange()
+	if err != nil || !ok {
+		return
+	}
+	if err = v.src.Prefetch(pos, end-pos); err != nil || !recursive {
+		return
+	}
+	var errElem error
+	yield := func(elem Value) bool {
+		errElem = elem.PrefetchTables(true)
+		return errElem == nil
+	}
+	if obj, errObj := v.Object(); errObj == nil {
+		err = obj.Range(func(key string, value Value) bool { return yield(value) })
+	} else if array, errArray := v.Array(); errArray == nil {
+		err = array.Range(func(i int, elem Value) bool { return yield(elem) })
+	}
+	if err == nil {
+		err = errElem
+	}
+	return
+}
@@ -0,0 +1,46 @@
+package impl
+
+import (
+	"bytes"
+	"testing"
+)
+
+// readSizes records the sizes of the reads of an io.ReaderAt.
+type readSizes struct {
+	r     *bytes.Reader
+	sizes []int
+}
+
+func (r *readSizes) ReadAt(p []byte, off int64) (n int, err error) {
+	n, err = r.r.ReadAt(p, off)
+	r.sizes = append(r.sizes, n)
+	return
+}
+
+func TestPrefetch(t *testing.T) {
+	data := make([]byte, prefetchBufferSize*5/2)
+	r := &readSizes{r: bytes.NewReader(data)}
+	src := NewReaderAtSource(r, 0)
+	for _, test := range []struct {
+		pos, n int64
+		sizes  []int
+	}{
+		{0, -1, []int{prefetchBufferSize, prefetchBufferSize, prefetchBufferSize / 2}},
+		{10, 100, []int{100}},
+		{0, 0, nil},
+		{int64(len(data)) - 10, 100, []int{10}},
+	} {
+		r.sizes = nil
+		if err := src.Prefetch(test.pos, test.n); err != nil {
+			t.Fatal(test, err)
+		}
+		if len(r.sizes) != len(test.sizes) {
+			t.Fatal(test, r.sizes)
+		}
+		for i := range r.sizes {
+			if r.sizes[i] != test.sizes[i] {
+				t.Fatal(test, r.sizes)
+			}
+		}
+	}
+}
@@ -0,0 +1,300 @@
+package impl
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+)
+
+// An object of short keys can be written as a [typeSlotObject],
+// an open-addressed hash table with linear probing, where every slot is:
+//
+//	tag | key | value
+//
+// The tag is 0 in an empty slot, or the key length plus 1,
+// with bit slotOutOfLine set if the value is stored after the slot table.
+// The key is padded with zeros to the key size of the object.
+// The value is the encoded value if it fits in the value size of the object,
+// otherwise it is a fixed size offset of the value relative to the start of the slot table.
+// A lookup of a key compares the keys of the slots from the slot of its hash
+// until an empty slot, and resolves the value in the slot in most cases.
+//
+// The descriptor of the table follows the type mark:
+//
+//	flags | key count | slot count | key size | value size
+//
+// Flags, the key count and the slot count are uvarints.
+// The key size and the value size are bytes.
+// The only flag is objectPow2, see pow2.go.
+
+const (
+	// maxSlotKeySize is the max key size of a [typeSlotObject].
+	maxSlotKeySize = 64
+	// maxSlotValueSize is the max value size of a [typeSlotObject].
+	// Values larger than it are always stored after the slot table.
+	maxSlotValueSize = 16
+	// slotOutOfLine is the bit of the tag of a slot whose value is stored after the slot table.
+	slotOutOfLine = 0x80
+)
+
+// slotHeader is the descriptor of the slots of a [typeSlotObject].
+type slotHeader struct {
+	keySize, valueSize byte
+}
+
+// size returns the size of a slot.
+func (h slotHeader) size() int {
+	return 1 + int(h.keySize) + int(h.valueSize)
+}
+
+// slotKeySize returns the key size of a [typeSlotObject] of entries,
+// and false if entries can't be written as one: some key is longer than maxKeySize.
+func slotKeySize(entries []objectEntry, maxKeySize int) (keySize byte, ok bool) {
+	if len(entries) == 0 {
+		return
+	}
+	maxKeySize = min(maxKeySize, maxSlotKeySize)
+	for i := range entries {
+		if len(entries[i].key) > maxKeySize {
+			return
+		}
+		keySize = max(keySize, byte(len(entries[i].key)))
+	}
+	return keySize, true
+}
+
+// slotValueSize returns the value size of a [typeSlotObject] of entries,
+// which is large enough to hold an offset of offsetSize.
+func slotValueSize(entries []objectEntry, offsetSize byte) (valueSize byte) {
+	valueSize = offsetSize
+	for i := range entries {
+		if size := entries[i].size; size <= maxSlotValueSize {
+			valueSize = max(valueSize, byte(size))
+		}
+	}
+	return
+}
+
+// writeSlotObject writes an object of entries to w as [typeSlotObject],
+// where the keys are at most keySize bytes, and the slot count is a power of 2 if pow2 is true.
+// See [writeEntries] for copyValue. The object is reported to report.
+func writeSlotObject(w io.Writer, entries []objectEntry, keySize byte, copyValue func(w io.Writer, e *objectEntry) error, pow2 bool, report *WriteReport) (err error) {
+	var flags uint64
+	var slotCount int
+	if pow2 {
+		flags = objectPow2
+		slotCount = pow2BucketCount(len(entries)*4/3 + 1)
+	} else {
+		slotCount = nearestPrime(len(entries)*4/3 + 1)
+	}
+	index := newBucketIndex(slotCount, pow2)
+	slots := make([]int, slotCount) // index of the entry plus 1, 0 if empty
+	for i := range entries {
+		s := index.of(entries[i].hash)
+		for ; slots[s] != 0; s = (s + 1) % uint64(slotCount) {
+			if entries[slots[s]-1].key == entries[i].key {
+				return fmt.Errorf("duplicate key %q", entries[i].key)
+			}
+		}
+		slots[s] = i + 1
+	}
+
+	// The offsets of the values after the table depend on the size of the table,
+	// which depends on the size of the offsets.
+	var h slotHeader
+	var offsetSize byte
+	for offsetSize = 1; ; offsetSize *= 2 {
+		h = slotHeader{keySize: keySize, valueSize: slotValueSize(entries, offsetSize)}
+		end := slotCount * h.size()
+		for i := range entries {
+			if entries[i].size > uint64(h.valueSize) {
+				end += int(entries[i].size)
+			}
+		}
+		if offsetSize == 8 || fixedUintSize(uint64(end)) <= offsetSize {
+			break
+		}
+	}
+
+	report.object(typeSlotObject, len(entries), offsetSize)
+
+	var table bytes.Buffer
+	table.WriteByte(byte(newTypeMarker(typeSlotObject, offsetSize)))
+	writeUintValue(&table, flags)
+	writeUintValue(&table, uint64(len(entries)))
+	writeUintValue(&table, uint64(slotCount))
+	table.WriteByte(h.keySize)
+	table.WriteByte(h.valueSize)
+	tablePos := table.Len()
+	offset := slotCount * h.size() // offset of the next value after the table
+	for _, slot := range slots {
+		if slot == 0 {
+			writePadding(&table, 0, h.size())
+			continue
+		}
+		e := &entries[slot-1]
+		start := table.Len()
+		if e.size <= uint64(h.valueSize) {
+			table.WriteByte(byte(len(e.key) + 1))
+			table.WriteString(e.key)
+			writePadding(&table, 0, int(h.keySize)-len(e.key))
+			if err = copyValue(&table, e); err != nil {
+				return
+			}
+		} else {
+			table.WriteByte(byte(len(e.key)+1) | slotOutOfLine)
+			table.WriteString(e.key)
+			writePadding(&table, 0, int(h.keySize)-len(e.key))
+			writeFixedUint(&table, uint64(offset), offsetSize)
+			offset += int(e.size)
+		}
+		writePadding(&table, 0, start+h.size()-table.Len())
+	}
+	if table.Len() != tablePos+slotCount*h.size() {
+		panic("invalid slot table size") // should not happen
+	}
+	if _, err = w.Write(table.Bytes()); err != nil {
+		return
+	}
+	for _, slot := range slots {
+		if slot == 0 {
+			continue
+		}
+		if e := &entries[slot-1]; e.size > uint64(h.valueSize) {
+			if err = copyValue(w, e); err != nil {
+				return
+			}
+		}
+	}
+	return
+}
+
+// readSlots reads the descriptor of a [typeSlotObject] from r after the type mark tm.
+func (obj *Object) readSlots(r *reader, tm typeMarker) (err error) {
+	var header [3]uint64 // flags, key count and slot count
+	for i := range header {
+		if header[i], err = readUintValue(r); err != nil {
+			return
+		}
+	}
+	flags, keyCount, slotCount := header[0], header[1], header[2]
+	if unknown := flags &^ objectPow2; unknown != 0 {
+		err = fmt.Errorf("failed to read object: unknown flags %#x", unknown)
+		return
+	}
+	if slotCount <= keyCount {
+		err = fmt.Errorf("failed to read object: invalid slot count %v of %v keys", slotCount, keyCount)
+		return
+	}
+	var shift uint8
+	if flags&objectPow2 != 0 {
+		if slotCount&(slotCount-1) != 0 {
+			err = fmt.Errorf("failed to read object: slot count %v is not a power of 2", slotCount)
+			return
+		}
+		shift = pow2Shift(slotCount)
+	}
+	p, err := r.next(2)
+	if err != nil {
+		return
+	}
+	h := slotHeader{keySize: p[0], valueSize: p[1]}
+	if h.keySize > maxSlotKeySize || h.valueSize < tm.OffsetSize() {
+		err = fmt.Errorf("failed to read object: invalid slot sizes %v, %v", h.keySize, h.valueSize)
+		return
+	}
+	*obj = Object{
+		src:         r.src,
+		pos:         r.pos(),
+		bucketCount: slotCount,
+		shift:       shift,
+		offsetSize:  tm.OffsetSize(),
+		layout:      typeSlotObject,
+		slots:       h,
+	}
+	return
+}
+
+// slotKey returns the key of slot p, which is not empty.
+func (obj *Object) slotKey(p []byte) (key []byte, err error) {
+	keyLen := int(p[0]&^slotOutOfLine) - 1
+	if keyLen < 0 || keyLen > int(obj.slots.keySize) {
+		err = fmt.Errorf("invalid slot key length %v", keyLen)
+		return
+	}
+	return p[1 : 1+keyLen], nil
+}
+
+// slotValue seeks r to the value of slot p at pos, which is not empty.
+// Slot p is invalid after that.
+func (obj *Object) slotValue(r *reader, p []byte, pos int64) (err error) {
+	valuePos := pos + 1 + int64(obj.slots.keySize)
+	r.seek(valuePos)
+	if p[0]&slotOutOfLine == 0 {
+		return
+	}
+	offset, err := readFixedUint(r, obj.offsetSize)
+	if err != nil {
+		return
+	}
+	r.seek(obj.pos + int64(offset))
+	return
+}
+
+// findSlot is the [Object.find] of a [typeSlotObject].
+func (obj *Object) findSlot(r *reader, key string, hash uint64) (err error) {
+	if len(key) > int(obj.slots.keySize) {
+		return ErrNotFound
+	}
+	size := obj.slots.size()
+	for i, s := uint64(0), obj.bucket(hash); i < obj.bucketCount; i++ {
+		pos := obj.pos + int64(s)*int64(size)
+		r.seek(pos)
+		var p []byte
+		if p, err = r.next(size); err != nil {
+			return
+		}
+		if p[0] == 0 {
+			return ErrNotFound
+		}
+		r.src.stats.probe()
+		// The key length in the tag is compared before the key.
+		if int(p[0]&^slotOutOfLine) == len(key)+1 && string(p[1:1+len(key)]) == key {
+			return obj.slotValue(r, p, pos)
+		}
+		if s++; s == obj.bucketCount {
+			s = 0
+		}
+	}
+	return ErrNotFound
+}
+
+// rangeSlots is the [Object.RangeBuckets] of the slots in [first, end) of a [typeSlotObject].
+func (obj *Object) rangeSlots(first, end uint64, yield func(key string, value Value) bool) (err error) {
+	r := obj.src.reader(obj.pos)
+	defer r.close()
+	size := obj.slots.size()
+	for s := first; s < end; s++ {
+		pos := obj.pos + int64(s)*int64(size)
+		r.seek(pos)
+		var p []byte
+		if p, err = r.next(size); err != nil {
+			return
+		}
+		if p[0] == 0 {
+			continue
+		}
+		var key []byte
+		if key, err = obj.slotKey(p); err != nil {
+			return
+		}
+		k := string(key)
+		if err = obj.slotValue(&r, p, pos); err != nil {
+			return
+		}
+		if !yield(k, Value{src: obj.src, pos: r.pos()}) {
+			return
+		}
+	}
+	return
+}
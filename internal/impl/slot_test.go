@@ -0,0 +1,79 @@
+package impl
+
+import (
+	"bytes"
+	"reflect"
+	"strconv"
+	"strings"
+	"testing"
+)
+
+func TestSlotObject(t *testing.T) {
+	long := strings.Repeat("x", 300)
+	obj := map[string]any{
+		"":       "empty key",
+		"int":    int64(-1),
+		"float":  1.5,
+		"null":   nil,
+		"long":   long,
+		"nested": map[string]any{"abcdefghijklmnopqrstuvwxyz": []any{"a", true}},
+	}
+	for i := range 100 {
+		obj[strconv.Itoa(i)] = strconv.Itoa(i * i)
+	}
+	opts := &WriteOptions{Gob: NewGobEncoder(), InlineKeySize: 16}
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, obj, opts); err != nil {
+		t.Fatal(err)
+	}
+	if typ := typeMarker(buf.Bytes()[0]).Type(); typ != typeSlotObject {
+		t.Fatal(typ)
+	}
+	for _, src := range []*Source{NewBytesSource(buf.Bytes()), NewReaderAtSource(bytes.NewReader(buf.Bytes()), 16)} {
+		root := src.Value(0)
+		o, err := root.Object()
+		if err != nil {
+			t.Fatal(err)
+		}
+		if o.layout != typeSlotObject || o.slots.keySize != 6 || o.offsetSize != 2 {
+			t.Fatal(o.layout, o.slots, o.offsetSize)
+		}
+		for key, want := range obj {
+			if v, err := o.Index(key, true); err != nil {
+				t.Fatal(key, err)
+			} else if !reflect.DeepEqual(v, want) {
+				t.Fatal(key, v)
+			}
+		}
+		for _, key := range []string{"100", "in", "intx", "abcdefghijklmnopq"} {
+			if _, err := root.Lookup(key); err != ErrNotFound {
+				t.Fatal(key, err)
+			}
+		}
+		if v, err := root.Decode(true); err != nil {
+			t.Fatal(err)
+		} else if !reflect.DeepEqual(v, obj) {
+			t.Fatal(v)
+		}
+		values, errs := root.LookupMany([]string{"int", "missing"})
+		if n, err := values[0].Int(); err != nil || n != -1 || errs[1] != ErrNotFound {
+			t.Fatal(n, err, errs)
+		}
+	}
+	// Objects with longer keys keep the chained layout.
+	nested, err := NewBytesSource(buf.Bytes()).Value(0).Lookup("nested")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if o, err := nested.Object(); err != nil || o.layout != typeFingerprintObject {
+		t.Fatal(err)
+	}
+
+	var entries []objectEntry
+	for _, key := range []string{"a", "b", "a"} {
+		entries = append(entries, objectEntry{key: key, hash: HashWyhash.sum(key), size: 1})
+	}
+	if err := writeSlotObject(&buf, entries, 1, valueBuffer{byte(typeNull)}.copy, false, nil); err == nil {
+		t.Fatal("duplicate key")
+	}
+}
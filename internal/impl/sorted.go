@@ -0,0 +1,292 @@
+package impl
+
+import (
+	"bytes"
+	"cmp"
+	"fmt"
+	"io"
+	"slices"
+	"sort"
+	"strings"
+)
+
+// A [typeFingerprintObject] flagged with objectSorted has a sorted index of its keys
+// after the bucket lists, see [WriteOptions.SortedKeys]. The position of the index
+// relative to the type mark is an 8-byte fixed uint after the bucket count and the filter.
+// The index is:
+//
+//	uvarint size | uvarint key count | uvarint block count | byte offset size |
+//	fences | blocks
+//
+// where size is the size of the index after it, and fences are the offsets of
+// the blocks from the end of the fences, of the offset size.
+// A block has sortedBlockKeys keys in the order of bytes, the last block may have fewer.
+// The first key of a block is stored in full as a binary value, and every other key
+// as the uvarint length of the prefix it shares with the previous key and
+// the rest of it as a binary value. Every key is followed by the uvarint distance
+// from its value back to the index.
+//
+// A range of keys is found by a binary search of the first keys of the blocks,
+// and read sequentially from there.
+
+// Flag of [typeFingerprintObject].
+const objectSorted = 8 // the object has a sorted index of its keys
+
+// sortedBlockKeys is the number of keys of a block of the sorted index.
+const sortedBlockKeys = 16
+
+// sortedIndexOffsetSize is the size of the position of the sorted index in an object.
+const sortedIndexOffsetSize = 8
+
+// writeSortedIndex writes the sorted index of entries to w,
+// where the distance from the value of entries[i] to the index is distances[i].
+func writeSortedIndex(w io.Writer, entries []objectEntry, distances []uint64) (err error) {
+	order := make([]int, len(entries))
+	for i := range order {
+		order[i] = i
+	}
+	slices.SortFunc(order, func(a, b int) int {
+		return cmp.Compare(entries[a].key, entries[b].key)
+	})
+	var blocks bytes.Buffer
+	fences := make([]uint64, 0, (len(order)+sortedBlockKeys-1)/sortedBlockKeys)
+	var prev string
+	for i, e := range order {
+		key := entries[e].key
+		if i%sortedBlockKeys == 0 {
+			fences = append(fences, uint64(blocks.Len()))
+			writeBinaryValue(&blocks, []byte(key))
+		} else {
+			shared := commonPrefix(prev, key)
+			writeUintValue(&blocks, uint64(shared))
+			writeBinaryValue(&blocks, []byte(key[shared:]))
+		}
+		writeUintValue(&blocks, distances[e])
+		prev = key
+	}
+	offsetSize := byte(1)
+	if len(fences) > 0 {
+		offsetSize = fixedUintSize(fences[len(fences)-1])
+	}
+	var index bytes.Buffer
+	writeUintValue(&index, uint64(len(order)))
+	writeUintValue(&index, uint64(len(fences)))
+	index.WriteByte(offsetSize)
+	for _, fence := range fences {
+		writeFixedUint(&index, fence, offsetSize)
+	}
+	if err = writeUintValue(w, uint64(index.Len()+blocks.Len())); err != nil {
+		return
+	}
+	if _, err = w.Write(index.Bytes()); err != nil {
+		return
+	}
+	_, err = w.Write(blocks.Bytes())
+	return
+}
+
+// commonPrefix returns the length of the common prefix of a and b.
+func commonPrefix(a, b string) (n int) {
+	for n < len(a) && n < len(b) && a[n] == b[n] {
+		n++
+	}
+	return
+}
+
+// sortedIndex is the descriptor of the sorted index of an object.
+type sortedIndex struct {
+	pos        int64 // position of the index
+	keys       uint64
+	blocks     uint64
+	offsetSize byte
+	fencesPos  int64
+	blocksPos  int64 // position of the first block, the end of the fences
+	end        int64
+}
+
+// readSortedIndex reads the descriptor of the sorted index of obj.
+func (obj *Object) readSortedIndex(r *reader) (idx sortedIndex, err error) {
+	idx.pos = obj.sortedPos
+	r.seek(idx.pos)
+	size, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	if size > uint64(maxPos-r.pos()) {
+		err = fmt.Errorf("invalid sorted index size %v", size)
+		return
+	}
+	idx.end = r.pos() + int64(size)
+	if idx.keys, err = readUintValue(r); err != nil {
+		return
+	}
+	if idx.blocks, err = readUintValue(r); err != nil {
+		return
+	}
+	if idx.blocks != (idx.keys+sortedBlockKeys-1)/sortedBlockKeys {
+		err = fmt.Errorf("invalid sorted index of %v keys in %v blocks", idx.keys, idx.blocks)
+		return
+	}
+	if idx.offsetSize, err = r.ReadByte(); err != nil {
+		return
+	}
+	if idx.offsetSize == 0 || idx.offsetSize > 8 || idx.blocks > uint64(size)/uint64(idx.offsetSize) {
+		err = fmt.Errorf("invalid sorted index of %v blocks of offset size %v", idx.blocks, idx.offsetSize)
+		return
+	}
+	idx.fencesPos = r.pos()
+	idx.blocksPos = idx.fencesPos + int64(idx.blocks)*int64(idx.offsetSize)
+	return
+}
+
+// seekBlock seeks r to block i of idx.
+func (idx *sortedIndex) seekBlock(r *reader, i uint64) (err error) {
+	r.seek(idx.fencesPos + int64(i)*int64(idx.offsetSize))
+	offset, err := readFixedUint(r, idx.offsetSize)
+	if err != nil {
+		return
+	}
+	if offset >= uint64(idx.end-idx.blocksPos) {
+		return fmt.Errorf("invalid sorted index block offset %v", offset)
+	}
+	r.seek(idx.blocksPos + int64(offset))
+	return
+}
+
+// sortedCursor reads the keys of a sorted index sequentially.
+type sortedCursor struct {
+	idx *sortedIndex
+	i   uint64 // index of the next key
+	key []byte // the current key
+}
+
+// next reads the next key at the position of r, and returns the position of its value.
+func (c *sortedCursor) next(r *reader) (valuePos int64, err error) {
+	r.src.stats.probe()
+	if c.i%sortedBlockKeys == 0 {
+		var key []byte
+		if key, err = readBinaryView(r); err != nil {
+			return
+		}
+		c.key = append(c.key[:0], key...)
+	} else {
+		var shared uint64
+		if shared, err = readUintValue(r); err != nil {
+			return
+		}
+		if shared > uint64(len(c.key)) {
+			err = fmt.Errorf("invalid shared prefix %v of key %q", shared, c.key)
+			return
+		}
+		var suffix []byte
+		if suffix, err = readBinaryView(r); err != nil {
+			return
+		}
+		c.key = append(c.key[:shared], suffix...)
+	}
+	distance, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	if distance > uint64(c.idx.pos) {
+		err = fmt.Errorf("invalid value distance %v", distance)
+		return
+	}
+	c.i++
+	return c.idx.pos - int64(distance), nil
+}
+
+// RangeKeys calls yield with the entries of obj whose keys are in [lo, hi)
+// in the order of keys, until yield returns false. If hi is empty,
+// the keys are not bounded above. The values are not decoded.
+//
+// The keys of an object with a sorted index, see [WriteOptions.SortedKeys],
+// are found by a binary search of the index and read sequentially,
+// and the keys of other objects are collected by [Object.Range] and sorted.
+func (obj *Object) RangeKeys(lo, hi string, yield func(key string, value Value) bool) (err error) {
+	if obj.sortedPos == 0 {
+		type entry struct {
+			key   string
+			value Value
+		}
+		var entries []entry
+		if err = obj.Range(func(key string, value Value) bool {
+			if key >= lo && (hi == "" || key < hi) {
+				entries = append(entries, entry{key, value})
+			}
+			return true
+		}); err != nil {
+			return
+		}
+		slices.SortFunc(entries, func(a, b entry) int {
+			return strings.Compare(a.key, b.key)
+		})
+		for _, e := range entries {
+			if !yield(e.key, e.value) {
+				return
+			}
+		}
+		return
+	}
+
+	r := obj.src.reader(obj.sortedPos)
+	defer r.close()
+	idx, err := obj.readSortedIndex(&r)
+	if err != nil || idx.keys == 0 {
+		return
+	}
+	// The last block whose first key <= lo.
+	var errSearch error
+	block := sort.Search(int(idx.blocks), func(i int) bool {
+		if errSearch != nil {
+			return true
+		}
+		if errSearch = idx.seekBlock(&r, uint64(i)); errSearch != nil {
+			return true
+		}
+		var first []byte
+		if first, errSearch = readBinaryView(&r); errSearch != nil {
+			return true
+		}
+		return string(first) > lo
+	})
+	if errSearch != nil {
+		return errSearch
+	}
+	block = max(block-1, 0)
+	if err = idx.seekBlock(&r, uint64(block)); err != nil {
+		return
+	}
+	c := sortedCursor{idx: &idx, i: uint64(block) * sortedBlockKeys}
+	for c.i < idx.keys {
+		var valuePos int64
+		if valuePos, err = c.next(&r); err != nil {
+			return
+		}
+		if hi != "" && string(c.key) >= hi {
+			return
+		}
+		if string(c.key) < lo {
+			continue
+		}
+		pos := r.pos()
+		if !yield(string(c.key), Value{src: obj.src, pos: valuePos}) {
+			return
+		}
+		r.seek(pos)
+	}
+	return
+}
+
+// PrefixEnd returns the least string greater than all the strings of prefix,
+// or "" if there is none, so the strings of prefix are in [prefix, PrefixEnd(prefix)).
+func PrefixEnd(prefix string) string {
+	end := []byte(prefix)
+	for i := len(end) - 1; i >= 0; i-- {
+		if end[i] < 0xFF {
+			end[i]++
+			return string(end[:i+1])
+		}
+	}
+	return ""
+}
@@ -0,0 +1,106 @@
+package impl
+
+import (
+	"bytes"
+	"fmt"
+	"slices"
+	"strings"
+	"testing"
+)
+
+func TestPrefixEnd(t *testing.T) {
+	for prefix, want := range map[string]string{"": "", "a": "b", "ab": "ac", "a\xff": "b", "\xff\xff": ""} {
+		if got := PrefixEnd(prefix); got != want {
+			t.Fatalf("%q: %q", prefix, got)
+		}
+	}
+}
+
+func TestRangeKeys(t *testing.T) {
+	obj := make(map[string]any)
+	var keys []string
+	for i := range 1000 {
+		key := fmt.Sprintf("%02X%02X", i/100, i%100)
+		obj[key] = key
+		keys = append(keys, key)
+	}
+	obj[""] = "empty"
+	keys = append(keys, "")
+	slices.Sort(keys)
+	want := func(lo, hi string) (want []string) {
+		for _, key := range keys {
+			if key >= lo && (hi == "" || key < hi) {
+				want = append(want, key)
+			}
+		}
+		return
+	}
+	ranges := [][2]string{
+		{"", ""}, {"", "0"}, {"01", "02"}, {"0150", "0153"}, {"05", ""},
+		{"0A", "0B"}, {"09", "09"}, {"095", "0A"}, {"ZZ", ""}, {"0", "01"},
+	}
+	for _, opts := range []*WriteOptions{
+		{Gob: NewGobEncoder(), SortedKeys: true},
+		{Gob: NewGobEncoder(), SortedKeys: true, Aligned: true},
+		{Gob: NewGobEncoder(), SortedKeys: true, PowerOfTwo: true, Filter: true},
+		{Gob: NewGobEncoder()}, // without an index
+	} {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, obj, opts); err != nil {
+			t.Fatal(err)
+		}
+		for _, src := range []*Source{
+			NewBytesSource(buf.Bytes()),
+			NewReaderAtSource(bytes.NewReader(buf.Bytes()), 64),
+		} {
+			o, err := src.Value(0).Object()
+			if err != nil {
+				t.Fatal(err)
+			}
+			if (o.sortedPos != 0) != opts.SortedKeys {
+				t.Fatal(o.sortedPos)
+			}
+			for _, r := range ranges {
+				var got []string
+				if err := o.RangeKeys(r[0], r[1], func(key string, value Value) bool {
+					v, err := value.Decode(false)
+					if err != nil || key != "" && v != key {
+						t.Fatal(key, v, err)
+					}
+					got = append(got, key)
+					return true
+				}); err != nil {
+					t.Fatal(err)
+				}
+				if !slices.Equal(got, want(r[0], r[1])) {
+					t.Fatal(r, got)
+				}
+			}
+			// Stops when yield returns false.
+			var n int
+			o.RangeKeys("01", "", func(key string, value Value) bool {
+				n++
+				return !strings.HasPrefix(key, "0110")
+			})
+			if n != 17 { // 0100 to 0110 in hex
+				t.Fatal(n)
+			}
+			if v, err := o.Index("0150", false); err != nil || v != "0150" {
+				t.Fatal(v, err)
+			}
+		}
+	}
+
+	// Empty objects
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, map[string]any{}, &WriteOptions{Gob: NewGobEncoder(), SortedKeys: true}); err != nil {
+		t.Fatal(err)
+	}
+	o, err := NewBytesSource(buf.Bytes()).Value(0).Object()
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := o.RangeKeys("", "", func(string, Value) bool { t.Fatal("empty"); return true }); err != nil {
+		t.Fatal(err)
+	}
+}
@@ -0,0 +1,267 @@
+package impl
+
+import (
+	"errors"
+	"fmt"
+	"io"
+	"sync"
+)
+
+// Source is the random access storage of a Hashive database.
+// Descriptors such as [Array] and [Object] only store positions in a Source,
+// and every read operation uses a short-lived reader created from it,
+// so a Source and its descriptors are safe for concurrent use
+// as long as the underlying storage is.
+type Source struct {
+	data       []byte      // the entire content if not nil
+	mapped     bool        // whether data is memory mapped, see [NewMmapSource]
+	r          io.ReaderAt // used if data is nil
+	bufferSize int
+	bufPool    sync.Pool // *[]byte of bufferSize
+	hash       HashFunc  // hash function of object keys, see [Source.ReadHeader]
+	dict       []byte    // preset dictionary of compressed values, see [Source.ReadHeader]
+	inflaters  sync.Pool // *inflater
+	poolPos    int64     // position of the string pool, see [Source.ReadHeader]
+	poolSize   uint64
+	stats      *Stats // nil if not counted, see [Source.CountStats]
+	filterMu   sync.RWMutex
+	filters    map[int64]*xorFilter // by position, see [readXorFilter]
+	filterSize int                  // estimated size of filters
+}
+
+// NewBytesSource creates a Source that reads data directly.
+// The content of data must not be modified while the Source is in use.
+func NewBytesSource(data []byte) *Source {
+	if data == nil {
+		data = []byte{}
+	}
+	return &Source{data: data}
+}
+
+// NewMmapSource is like [NewBytesSource], but data is memory mapped by [Mmap],
+// so [Source.Prefetch] advises the OS to page it in.
+func NewMmapSource(data []byte) *Source {
+	src := NewBytesSource(data)
+	src.mapped = true
+	return src
+}
+
+// Resident returns whether the content of src is in memory, see [NewBytesSource],
+// so reads never wait for the storage, not even for page faults.
+func (src *Source) Resident() bool {
+	return src.data != nil && !src.mapped
+}
+
+// NewReaderAtSource creates a Source that reads from r.
+// Argument bufferSize is the size of the read buffer of each read operation.
+// If bufferSize is 0, only the bytes actually needed are read from r.
+func NewReaderAtSource(r io.ReaderAt, bufferSize int) *Source {
+	return &Source{r: r, bufferSize: max(bufferSize, 0)}
+}
+
+// NewReadSeekerSource creates a Source that reads r.
+// If r implements [io.ReaderAt], its ReadAt method is used directly,
+// otherwise reads are serialized as a Seek followed by a Read.
+// See [NewReaderAtSource] for the meaning of bufferSize.
+func NewReadSeekerSource(r io.ReadSeeker, bufferSize int) *Source {
+	return NewReaderAtSource(readerAt(r), bufferSize)
+}
+
+// readerAt returns r itself if r implements [io.ReaderAt],
+// or an [io.ReaderAt] that seeks and reads r.
+func readerAt(r io.ReadSeeker) io.ReaderAt {
+	if ra, ok := r.(io.ReaderAt); ok {
+		return ra
+	}
+	return &readSeekerAt{r: r}
+}
+
+// ReadAt implements [io.ReaderAt].
+func (src *Source) ReadAt(p []byte, off int64) (n int, err error) {
+	if src.data == nil {
+		return src.r.ReadAt(p, off)
+	}
+	if off < 0 {
+		return 0, errors.New("negative offset")
+	}
+	if off >= int64(len(src.data)) {
+		return 0, io.EOF
+	}
+	n = copy(p, src.data[off:])
+	if n < len(p) {
+		err = io.EOF
+	}
+	return
+}
+
+// readSeekerAt implements [io.ReaderAt] on top of an [io.ReadSeeker].
+// It is safe for concurrent use.
+type readSeekerAt struct {
+	mu sync.Mutex
+	r  io.ReadSeeker
+}
+
+func (r *readSeekerAt) ReadAt(p []byte, off int64) (n int, err error) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if _, err = r.r.Seek(off, io.SeekStart); err != nil {
+		return
+	}
+	n, err = io.ReadFull(r.r, p)
+	if err == io.ErrUnexpectedEOF {
+		err = io.EOF
+	}
+	return
+}
+
+// reader reads a Source sequentially.
+// A reader is not safe for concurrent use, and must be closed after use.
+type reader struct {
+	src *Source
+	buf []byte // content of src starting at position off
+	off int64
+	i   int     // read index in buf
+	mem *[]byte // the buffer backing buf, nil if src.data is used
+}
+
+// reader returns a reader that starts reading at pos.
+func (src *Source) reader(pos int64) (r reader) {
+	r.src = src
+	if src.data != nil {
+		r.buf = src.data
+	}
+	r.seek(pos)
+	return
+}
+
+// close releases the resources of r.
+func (r *reader) close() {
+	if r.mem != nil && cap(*r.mem) == r.src.bufferSize {
+		r.src.bufPool.Put(r.mem)
+	}
+	r.mem, r.buf = nil, nil
+}
+
+// pos returns the position of the next byte to read.
+func (r *reader) pos() int64 {
+	return r.off + int64(r.i)
+}
+
+// seek sets the position of the next byte to read.
+func (r *reader) seek(pos int64) {
+	if r.src.data == nil && (pos < r.off || pos > r.off+int64(len(r.buf))) {
+		r.off, r.buf = pos, r.buf[:0]
+	}
+	r.i = int(pos - r.off)
+}
+
+// skip skips n bytes.
+func (r *reader) skip(n uint64) (err error) {
+	pos := r.pos()
+	if n > uint64(maxPos-pos) {
+		return fmt.Errorf("invalid skip size %v", n)
+	}
+	r.seek(pos + int64(n))
+	return
+}
+
+// maxPos is the max position a reader can read.
+const maxPos = int64(^uint(0) >> 1)
+
+// fill reads at least n bytes from the current position into the buffer.
+func (r *reader) fill(n int) (err error) {
+	if r.src.data != nil {
+		return io.ErrUnexpectedEOF
+	}
+	pos := r.pos()
+	size := max(n, r.src.bufferSize)
+	if r.mem == nil || cap(*r.mem) < size {
+		r.close()
+		if size == r.src.bufferSize {
+			r.mem, _ = r.src.bufPool.Get().(*[]byte)
+		}
+		if r.mem == nil {
+			mem := make([]byte, size)
+			r.mem = &mem
+		}
+	}
+	buf := (*r.mem)[:size]
+	m, err := r.src.r.ReadAt(buf, pos)
+	r.src.stats.read(m)
+	if m < n {
+		if err == nil || err == io.EOF {
+			err = io.ErrUnexpectedEOF
+		}
+		r.off, r.buf, r.i = pos, buf[:0], 0
+		return
+	}
+	r.off, r.buf, r.i = pos, buf[:m], 0
+	return nil
+}
+
+// next returns the next n bytes.
+// The returned slice is only valid until the next read of r.
+func (r *reader) next(n int) (p []byte, err error) {
+	if n < 0 {
+		err = fmt.Errorf("invalid read size %v", n)
+		return
+	}
+	if r.i < 0 || r.i > len(r.buf) || len(r.buf)-r.i < n {
+		if err = r.fill(n); err != nil {
+			return
+		}
+	}
+	p = r.buf[r.i : r.i+n : r.i+n]
+	r.i += n
+	return
+}
+
+// read reads exactly len(p) bytes into p.
+func (r *reader) read(p []byte) (err error) {
+	if r.src.data != nil || len(p) <= r.src.bufferSize {
+		var view []byte
+		if view, err = r.next(len(p)); err == nil {
+			copy(p, view)
+		}
+		return
+	}
+	// Large reads bypass the buffer.
+	pos := r.pos()
+	n, err := r.src.r.ReadAt(p, pos)
+	r.src.stats.read(n)
+	if n == len(p) {
+		err = nil
+	} else if err == nil || err == io.EOF {
+		err = io.ErrUnexpectedEOF
+	}
+	r.seek(pos + int64(n))
+	return
+}
+
+// ReadByte implements [io.ByteReader].
+func (r *reader) ReadByte() (b byte, err error) {
+	if r.i < 0 || r.i >= len(r.buf) {
+		if err = r.fill(1); err != nil {
+			return
+		}
+	}
+	b = r.buf[r.i]
+	r.i++
+	return
+}
+
+// streamRead decodes a value with read from the current position of r,
+// and then seeks r to the end of the decoded value.
+func streamRead[T any](r ByteReadSeeker, read func(r *reader) (T, error)) (v T, err error) {
+	pos, err := r.Seek(0, io.SeekCurrent)
+	if err != nil {
+		return
+	}
+	sr := NewReadSeekerSource(r, 0).reader(pos)
+	defer sr.close()
+	if v, err = read(&sr); err != nil {
+		return
+	}
+	_, err = r.Seek(sr.pos(), io.SeekStart)
+	return
+}
@@ -0,0 +1,145 @@
+package impl
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+// Stats counts the work of reading a [Source], see [Source.CountStats].
+type Stats struct {
+	// Probes is the number of entries examined by key lookups in objects,
+	// by fingerprint or by key.
+	Probes atomic.Uint64
+	// Reads is the number of reads of the underlying storage,
+	// which refill the read buffer. The content of [NewBytesSource] and
+	// [NewMmapSource] is not read.
+	Reads atomic.Uint64
+	// BytesRead is the number of bytes of Reads.
+	BytesRead atomic.Uint64
+	// Filtered is the number of key lookups rejected by the filters of objects,
+	// see [WriteOptions.Filter].
+	Filtered atomic.Uint64
+}
+
+// probe counts a probe if s is not nil.
+func (s *Stats) probe() {
+	if s != nil {
+		s.Probes.Add(1)
+	}
+}
+
+// filtered counts a lookup rejected by a filter if s is not nil.
+func (s *Stats) filtered() {
+	if s != nil {
+		s.Filtered.Add(1)
+	}
+}
+
+// read counts a read of n bytes if s is not nil.
+func (s *Stats) read(n int) {
+	if s != nil {
+		s.Reads.Add(1)
+		s.BytesRead.Add(uint64(n))
+	}
+}
+
+// CountStats counts the work of reading src in stats.
+// It must be called before src is read concurrently.
+func (src *Source) CountStats(stats *Stats) {
+	src.stats = stats
+}
+
+// WriteReport is the report of the objects and arrays written with [WriteOptions.Report].
+// It is safe for concurrent use, and the fields must be read after the writing.
+type WriteReport struct {
+	mu sync.Mutex
+
+	Objects     int // number of objects
+	MPHObjects  int // number of objects written with a minimal perfect hash
+	SlotObjects int // number of objects written as slot tables
+	Keys        int // number of keys of all the objects
+
+	// Buckets is the number of buckets of the objects written with separate chaining,
+	// and Lists is the number of non-empty buckets.
+	Buckets, Lists int
+	// MaxChain is the max length of the bucket lists.
+	MaxChain int
+	listKeys int // number of keys in bucket lists
+
+	Arrays      int // number of arrays
+	TypedArrays int // number of typed arrays, see [WriteOptions.TypedArrays]
+	// OffsetSizes[i] is the number of offset tables of objects and arrays of offset size i.
+	OffsetSizes [9]int
+
+	Filters     int // number of objects with filters, see [WriteOptions.Filter]
+	FilterBytes int // bytes of the filters
+}
+
+// AvgChain returns the average length of the non-empty bucket lists.
+func (r *WriteReport) AvgChain() float64 {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if r.Lists == 0 {
+		return 0
+	}
+	return float64(r.listKeys) / float64(r.Lists)
+}
+
+// chainedObject reports an object of buckets written with separate chaining
+// and a filter of filterSize bytes, or no filter if filterSize is 0, if r is not nil.
+func (r *WriteReport) chainedObject(buckets [][]int, offsetSize byte, filterSize int) {
+	if r == nil {
+		return
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.Objects++
+	r.Buckets += len(buckets)
+	r.OffsetSizes[offsetSize]++
+	if filterSize > 0 {
+		r.Filters++
+		r.FilterBytes += filterSize
+	}
+	for _, list := range buckets {
+		if len(list) > 0 {
+			r.Keys += len(list)
+			r.listKeys += len(list)
+			r.Lists++
+			r.MaxChain = max(r.MaxChain, len(list))
+		}
+	}
+}
+
+// object reports an object of keys written as layout t if r is not nil.
+func (r *WriteReport) object(t typ, keys int, offsetSize byte) {
+	if r == nil {
+		return
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.Objects++
+	r.Keys += keys
+	r.OffsetSizes[offsetSize]++
+	switch t {
+	case typeMPHObject:
+		r.MPHObjects++
+	case typeSlotObject:
+		r.SlotObjects++
+	}
+}
+
+// array reports an array if r is not nil.
+// The offset size of typed arrays is 0.
+func (r *WriteReport) array(offsetSize byte) {
+	if r == nil {
+		return
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.Arrays++
+	if offsetSize == 0 {
+		r.TypedArrays++
+	} else {
+		r.OffsetSizes[offsetSize]++
+	}
+}
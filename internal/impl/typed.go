@@ -0,0 +1,459 @@
+package impl
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+	"math"
+	"slices"
+)
+
+// A typed array is an array whose elements are all integers, all unsigned integers,
+// all float point numbers, all bools or all strings.
+// The elements are stored without type marks and offset table:
+//
+//	type mark | element type | length | data
+//
+// The offset size of the type mark is the width of the elements,
+// and the length is a variable-length encoded unsigned integer.
+//   - Integers are width bytes each, encoded as by int2Uint for signed integers.
+//   - Float point numbers are the 8 bytes of their IEEE 754 representation.
+//   - Bools are bit-packed, the ith element is bit i%8 of byte i/8.
+//   - Strings are the end offsets of every string of width bytes,
+//     followed by the concatenation of the strings.
+//
+// So the ith element of integers and float point numbers is at data+i*width,
+// and an entire typed array can be scanned without decoding every element.
+
+// typedElems is the elements of a typed array being written.
+type typedElems struct {
+	t    typ
+	raw  []uint64 // elements of the types other than typeString, see typedElem
+	strs []string // elements of typeString
+}
+
+func (e *typedElems) len() int {
+	if e.t == typeString {
+		return len(e.strs)
+	}
+	return len(e.raw)
+}
+
+// typedElem returns the type of v as an element of a typed array,
+// and the raw data u of v if the type is not [typeString].
+// The raw data of signed integers is mapped by int2Uint,
+// the raw data of float point numbers is their IEEE 754 representation,
+// and the raw data of bools is 1 or 0.
+func typedElem(v any) (t typ, u uint64, s string, ok bool) {
+	switch v := v.(type) {
+	case int8:
+		return typeInt, int2Uint(int64(v)), "", true
+	case int16:
+		return typeInt, int2Uint(int64(v)), "", true
+	case int32:
+		return typeInt, int2Uint(int64(v)), "", true
+	case int64:
+		return typeInt, int2Uint(v), "", true
+	case int:
+		return typeInt, int2Uint(int64(v)), "", true
+	case uint8:
+		return typeUint, uint64(v), "", true
+	case uint16:
+		return typeUint, uint64(v), "", true
+	case uint32:
+		return typeUint, uint64(v), "", true
+	case uint64:
+		return typeUint, v, "", true
+	case uint:
+		return typeUint, uint64(v), "", true
+	case float32:
+		return typeFloat, math.Float64bits(float64(v)), "", true
+	case float64:
+		return typeFloat, math.Float64bits(v), "", true
+	case bool:
+		if v {
+			u = 1
+		}
+		return typeBool, u, "", true
+	case string:
+		return typeString, 0, v, true
+	}
+	return
+}
+
+func intElems[T int8 | int16 | int32 | int64 | int](s []T) []uint64 {
+	raw := make([]uint64, len(s))
+	for i, n := range s {
+		raw[i] = int2Uint(int64(n))
+	}
+	return raw
+}
+
+func uintElems[T uint16 | uint32 | uint64 | uint](s []T) []uint64 {
+	raw := make([]uint64, len(s))
+	for i, n := range s {
+		raw[i] = uint64(n)
+	}
+	return raw
+}
+
+func floatElems[T float32 | float64](s []T) []uint64 {
+	raw := make([]uint64, len(s))
+	for i, f := range s {
+		raw[i] = math.Float64bits(float64(f))
+	}
+	return raw
+}
+
+// typedArrayElems returns the elements of v if v can be stored as a typed array:
+// a non-empty []any of elements of the same type, or a slice of integers,
+// float point numbers, bools or strings. []byte is not a typed array.
+func typedArrayElems(v any) (e typedElems, ok bool) {
+	switch v := v.(type) {
+	case []any:
+		if len(v) == 0 {
+			return
+		}
+		for i, elem := range v {
+			t, u, s, ok := typedElem(elem)
+			if !ok || (i > 0 && t != e.t) {
+				return typedElems{}, false
+			}
+			if i == 0 {
+				e.t = t
+				if t == typeString {
+					e.strs = make([]string, 0, len(v))
+				} else {
+					e.raw = make([]uint64, 0, len(v))
+				}
+			}
+			if t == typeString {
+				e.strs = append(e.strs, s)
+			} else {
+				e.raw = append(e.raw, u)
+			}
+		}
+		return e, true
+	case []int8:
+		return typedElems{t: typeInt, raw: intElems(v)}, true
+	case []int16:
+		return typedElems{t: typeInt, raw: intElems(v)}, true
+	case []int32:
+		return typedElems{t: typeInt, raw: intElems(v)}, true
+	case []int64:
+		return typedElems{t: typeInt, raw: intElems(v)}, true
+	case []int:
+		return typedElems{t: typeInt, raw: intElems(v)}, true
+	case []uint16:
+		return typedElems{t: typeUint, raw: uintElems(v)}, true
+	case []uint32:
+		return typedElems{t: typeUint, raw: uintElems(v)}, true
+	case []uint64:
+		return typedElems{t: typeUint, raw: uintElems(v)}, true
+	case []uint:
+		return typedElems{t: typeUint, raw: uintElems(v)}, true
+	case []float32:
+		return typedElems{t: typeFloat, raw: floatElems(v)}, true
+	case []float64:
+		return typedElems{t: typeFloat, raw: floatElems(v)}, true
+	case []bool:
+		raw := make([]uint64, len(v))
+		for i, b := range v {
+			if b {
+				raw[i] = 1
+			}
+		}
+		return typedElems{t: typeBool, raw: raw}, true
+	case []string:
+		return typedElems{t: typeString, strs: v}, true
+	}
+	return
+}
+
+// appendFixedUint appends n of size bytes to p as by [writeFixedUint].
+func appendFixedUint(p []byte, n uint64, size byte) []byte {
+	p = littleEndian.AppendUint64(p, n)
+	return p[:len(p)-8+int(size)]
+}
+
+// writeTypedArray writes the elements of e as a typed array to w.
+func writeTypedArray(w io.Writer, e *typedElems) (err error) {
+	n := e.len()
+	var width byte
+	var dataSize int
+	switch e.t {
+	case typeInt, typeUint:
+		var maxRaw uint64
+		for _, u := range e.raw {
+			maxRaw = max(maxRaw, u)
+		}
+		width = fixedUintSize(maxRaw)
+		dataSize = n * int(width)
+	case typeFloat:
+		width = 8
+		dataSize = n * 8
+	case typeBool:
+		width = 1
+		dataSize = (n + 7) / 8
+	case typeString:
+		var total int
+		for _, s := range e.strs {
+			total += len(s)
+		}
+		width = fixedUintSize(uint64(total))
+		dataSize = n*int(width) + total
+	default:
+		return fmt.Errorf("invalid typed array element type %v", e.t)
+	}
+
+	var header bytes.Buffer
+	header.WriteByte(byte(newTypeMarker(typeTypedArray, width)))
+	header.WriteByte(byte(e.t))
+	writeUintValue(&header, uint64(n))
+	if _, err = w.Write(header.Bytes()); err != nil {
+		return
+	}
+
+	p := make([]byte, 0, dataSize+8) // appendFixedUint appends 8 bytes
+	switch e.t {
+	case typeBool:
+		p = p[:dataSize]
+		for i, u := range e.raw {
+			p[i/8] |= byte(u) << (i % 8)
+		}
+	case typeString:
+		var end uint64
+		for _, s := range e.strs {
+			end += uint64(len(s))
+			p = appendFixedUint(p, end, width)
+		}
+		for _, s := range e.strs {
+			p = append(p, s...)
+		}
+	default:
+		for _, u := range e.raw {
+			p = appendFixedUint(p, u, width)
+		}
+	}
+	_, err = w.Write(p)
+	return
+}
+
+// readTyped reads the descriptor of a typed array from r after the type mark.
+func (array *Array) readTyped(r *reader, width byte) (err error) {
+	start := r.pos() - 1
+	b, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	elem := typ(b)
+	switch {
+	case elem == typeFloat && width == 8:
+	case elem == typeBool && width == 1:
+	case (elem == typeInt || elem == typeUint || elem == typeString) && width >= 1 && width <= 8:
+	default:
+		return fmt.Errorf("failed to read typed array: invalid element type %v of size %v", elem, width)
+	}
+	length, err := readUintValue(r)
+	if err != nil {
+		return
+	}
+	if length > uint64(maxPos)/uint64(width) {
+		return fmt.Errorf("failed to read typed array: invalid length %v", length)
+	}
+	*array = Array{
+		src:        r.src,
+		pos:        r.pos(),
+		length:     int(length),
+		offsetSize: width,
+		elem:       elem,
+		start:      start,
+	}
+	return
+}
+
+// typedElemValue returns the ith element of a typed array as a [Value].
+func (array *Array) typedElemValue(i int) Value {
+	return Value{src: array.src, pos: array.start, index: i + 1}
+}
+
+// readElem reads the raw data of the ith element of a typed array from r.
+// If the elements are strings, u is the length of the string and
+// r is seeked to the content of the string.
+func (array *Array) readElem(r *reader, i int) (u uint64, err error) {
+	width := int64(array.offsetSize)
+	switch array.elem {
+	case typeBool:
+		r.seek(array.pos + int64(i/8))
+		var b byte
+		if b, err = r.ReadByte(); err != nil {
+			return
+		}
+		u = uint64(b>>(i%8)) & 1
+	case typeString:
+		var start, end uint64
+		if i > 0 {
+			r.seek(array.pos + int64(i-1)*width)
+			if start, err = readFixedUint(r, array.offsetSize); err != nil {
+				return
+			}
+		} else {
+			r.seek(array.pos)
+		}
+		if end, err = readFixedUint(r, array.offsetSize); err != nil {
+			return
+		}
+		if end < start || end > uint64(maxPos) {
+			err = fmt.Errorf("invalid string offset %v", end)
+			return
+		}
+		r.seek(array.pos + int64(array.length)*width + int64(start))
+		u = end - start
+	default:
+		r.seek(array.pos + int64(i)*width)
+		u, err = readFixedUint(r, array.offsetSize)
+	}
+	return
+}
+
+// readStringElems reads all the strings of a typed array from r.
+func (array *Array) readStringElems(r *reader, yield func(i int, s string) bool) (err error) {
+	ends := make([]uint64, array.length)
+	r.seek(array.pos)
+	for i := range ends {
+		if ends[i], err = readFixedUint(r, array.offsetSize); err != nil {
+			return
+		}
+	}
+	var start uint64
+	for i, end := range ends {
+		if end < start || end-start > math.MaxInt {
+			return fmt.Errorf("invalid string offset %v", end)
+		}
+		var p []byte
+		if p, err = r.next(int(end - start)); err != nil {
+			return
+		}
+		if !yield(i, string(p)) {
+			return
+		}
+		start = end
+	}
+	return
+}
+
+// rangeRaw calls yield with the raw data of every element of a typed array
+// of a type other than [typeString] in order, until yield returns false.
+// The elements are read sequentially.
+func (array *Array) rangeRaw(r *reader, yield func(i int, u uint64) bool) (err error) {
+	r.seek(array.pos)
+	var b byte
+	for i := range array.length {
+		var u uint64
+		if array.elem == typeBool {
+			if i%8 == 0 {
+				if b, err = r.ReadByte(); err != nil {
+					return
+				}
+			}
+			u = uint64(b>>(i%8)) & 1
+		} else if u, err = readFixedUint(r, array.offsetSize); err != nil {
+			return
+		}
+		if !yield(i, u) {
+			return
+		}
+	}
+	return
+}
+
+// rawValue converts the raw data of an element of type t to its value.
+func rawValue(t typ, u uint64) any {
+	switch t {
+	case typeInt:
+		return uint2Int(u)
+	case typeFloat:
+		return math.Float64frombits(u)
+	case typeBool:
+		return u != 0
+	default:
+		return u
+	}
+}
+
+// typedValue reads and returns the content of a typed array.
+func (array *Array) typedValue() (v []any, err error) {
+	v = make([]any, array.length)
+	r := array.src.reader(array.pos)
+	defer r.close()
+	if array.elem == typeString {
+		err = array.readStringElems(&r, func(i int, s string) bool {
+			v[i] = s
+			return true
+		})
+	} else {
+		err = array.rangeRaw(&r, func(i int, u uint64) bool {
+			v[i] = rawValue(array.elem, u)
+			return true
+		})
+	}
+	if err != nil {
+		v = nil
+	}
+	return
+}
+
+// appendArray appends the elements of v to dst if v is an array of elements of type t.
+// The raw data of typed arrays is converted by fromRaw, and the elements of other arrays
+// are converted by get.
+func appendArray[T any](v Value, dst []T, t typ, fromRaw func(u uint64) T, get func(elem Value) (T, error)) (p []T, err error) {
+	array, err := v.Array()
+	if err != nil {
+		return dst, err
+	}
+	p = dst
+	if array.elem == typeNull {
+		var errElem error
+		if err = array.Range(func(i int, elem Value) bool {
+			var e T
+			if e, errElem = get(elem); errElem != nil {
+				return false
+			}
+			p = append(p, e)
+			return true
+		}); err == nil {
+			err = errElem
+		}
+	} else if array.elem != t {
+		err = &TypeError{array.elem}
+	} else {
+		p = slices.Grow(p, array.length)
+		r := array.src.reader(array.pos)
+		defer r.close()
+		err = array.rangeRaw(&r, func(i int, u uint64) bool {
+			p = append(p, fromRaw(u))
+			return true
+		})
+	}
+	if err != nil {
+		p = dst
+	}
+	return
+}
+
+// AppendInts appends the elements of v to dst and returns the extended buffer.
+// v must be an array of signed integers.
+// Typed arrays are scanned sequentially without decoding every element.
+func (v Value) AppendInts(dst []int64) ([]int64, error) {
+	return appendArray(v, dst, typeInt, uint2Int, Value.Int)
+}
+
+// AppendUints is like [Value.AppendInts] but for unsigned integers.
+func (v Value) AppendUints(dst []uint64) ([]uint64, error) {
+	return appendArray(v, dst, typeUint, func(u uint64) uint64 { return u }, Value.Uint)
+}
+
+// AppendFloats is like [Value.AppendInts] but for float point numbers.
+func (v Value) AppendFloats(dst []float64) ([]float64, error) {
+	return appendArray(v, dst, typeFloat, math.Float64frombits, Value.Float)
+}
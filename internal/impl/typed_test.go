@@ -0,0 +1,172 @@
+package impl
+
+import (
+	"bytes"
+	"errors"
+	"math"
+	"reflect"
+	"strconv"
+	"testing"
+)
+
+func TestTypedArray(t *testing.T) {
+	bools := make([]bool, 13)
+	for i := range bools {
+		bools[i] = i%3 == 0
+	}
+	tests := []struct {
+		value any
+		want  []any
+		elem  typ
+	}{
+		{[]any{int64(1), int64(-300), int64(math.MinInt64)}, []any{int64(1), int64(-300), int64(math.MinInt64)}, typeInt},
+		{[]int{0, 1, 2}, []any{int64(0), int64(1), int64(2)}, typeInt},
+		{[]any{uint64(math.MaxUint64), uint8(3)}, []any{uint64(math.MaxUint64), uint64(3)}, typeUint},
+		{[]float64{0.5, -1, math.Inf(1)}, []any{0.5, -1.0, math.Inf(1)}, typeFloat},
+		{[]any{float32(0.25), 1.5}, []any{0.25, 1.5}, typeFloat},
+		{bools, []any{true, false, false, true, false, false, true, false, false, true, false, false, true}, typeBool},
+		{[]any{"abc", "", "de"}, []any{"abc", "", "de"}, typeString},
+		{[]string{}, []any{}, typeString},
+	}
+	opts := &WriteOptions{Gob: NewGobEncoder(), TypedArrays: true}
+	for _, test := range tests {
+		var buf bytes.Buffer
+		if err := EncodeValue(&buf, test.value, opts); err != nil {
+			t.Fatal(err)
+		}
+		if typ := typeMarker(buf.Bytes()[0]).Type(); typ != typeTypedArray {
+			t.Fatal(test.value, typ)
+		}
+		for _, src := range []*Source{NewBytesSource(buf.Bytes()), NewReaderAtSource(bytes.NewReader(buf.Bytes()), 4)} {
+			array, err := src.Value(0).Array()
+			if err != nil {
+				t.Fatal(err)
+			}
+			if array.elem != test.elem || array.Len() != len(test.want) {
+				t.Fatal(test.value, array.elem, array.Len())
+			}
+			if read, err := array.Value(); err != nil {
+				t.Fatal(err)
+			} else if !reflect.DeepEqual(read, test.want) {
+				t.Fatal(read)
+			}
+			for i, want := range test.want {
+				if v, err := array.Index(i, true); err != nil || v != want {
+					t.Fatal(i, v, err)
+				}
+				elem, err := src.Value(0).Lookup(strconv.Itoa(i))
+				if err != nil {
+					t.Fatal(err)
+				}
+				if v, err := elem.Decode(false); err != nil || v != want {
+					t.Fatal(i, v, err)
+				}
+			}
+			if _, err := array.Index(len(test.want), true); !errors.As(err, new(*BoundsError)) {
+				t.Fatal(err)
+			}
+		}
+	}
+}
+
+func TestTypedArrayElem(t *testing.T) {
+	opts := &WriteOptions{Gob: NewGobEncoder(), TypedArrays: true}
+	var buf bytes.Buffer
+	if err := EncodeValue(&buf, map[string]any{
+		"int":    []int64{-1, 2},
+		"uint":   []uint{1, 2},
+		"float":  []float64{1.5, 2},
+		"bool":   []bool{false, true},
+		"string": []string{"a", "bc"},
+		"mixed":  []any{int64(1), "a"},
+	}, opts); err != nil {
+		t.Fatal(err)
+	}
+	root := NewBytesSource(buf.Bytes()).Value(0)
+	elem := func(key string, i int) Value {
+		array, err := root.Lookup(key)
+		if err != nil {
+			t.Fatal(err)
+		}
+		v, err := array.Lookup(strconv.Itoa(i))
+		if err != nil {
+			t.Fatal(err)
+		}
+		return v
+	}
+	if n, err := elem("int", 0).Int(); err != nil || n != -1 {
+		t.Fatal(n, err)
+	}
+	if n, err := elem("uint", 1).Uint(); err != nil || n != 2 {
+		t.Fatal(n, err)
+	}
+	if f, err := elem("float", 0).Float(); err != nil || f != 1.5 {
+		t.Fatal(f, err)
+	}
+	if b, err := elem("bool", 1).Bool(); err != nil || !b {
+		t.Fatal(b, err)
+	}
+	if s, err := elem("string", 1).Str(); err != nil || s != "bc" {
+		t.Fatal(s, err)
+	}
+	if p, err := elem("string", 0).AppendBytes([]byte("x")); err != nil || string(p) != "xa" {
+		t.Fatal(p, err)
+	}
+	var typeErr *TypeError
+	if _, err := elem("int", 0).Str(); !errors.As(err, &typeErr) {
+		t.Fatal(err)
+	}
+	if _, err := elem("int", 0).Array(); !errors.As(err, &typeErr) {
+		t.Fatal(err)
+	}
+	if _, err := elem("string", 0).Lookup("0"); err != ErrNotFound {
+		t.Fatal(err)
+	}
+
+	for _, key := range []string{"float", "mixed"} {
+		v, err := root.Lookup(key)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if _, err := v.AppendFloats(nil); key == "float" && err != nil {
+			t.Fatal(err)
+		} else if key == "mixed" && !errors.As(err, &typeErr) {
+			t.Fatal(err)
+		}
+	}
+	v, _ := root.Lookup("int")
+	if ints, err := v.AppendInts([]int64{0}); err != nil || !reflect.DeepEqual(ints, []int64{0, -1, 2}) {
+		t.Fatal(ints, err)
+	}
+	if _, err := v.AppendUints(nil); !errors.As(err, &typeErr) {
+		t.Fatal(err)
+	}
+}
+
+func TestTypedArraySize(t *testing.T) {
+	floats := make([]any, 1000)
+	for i := range floats {
+		floats[i] = float64(i) / 3
+	}
+	var untyped, typed bytes.Buffer
+	if err := EncodeValue(&untyped, floats, &WriteOptions{}); err != nil {
+		t.Fatal(err)
+	}
+	if err := EncodeValue(&typed, floats, &WriteOptions{TypedArrays: true}); err != nil {
+		t.Fatal(err)
+	}
+	if typed.Len() != 5+8*len(floats) || typed.Len() >= untyped.Len() {
+		t.Fatal(typed.Len(), untyped.Len())
+	}
+	// The same elements are read from the untyped array.
+	v := NewBytesSource(untyped.Bytes()).Value(0)
+	read, err := v.AppendFloats(nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i, f := range read {
+		if f != floats[i] {
+			t.Fatal(i, f)
+		}
+	}
+}
@@ -0,0 +1,437 @@
+package impl
+
+import (
+	"fmt"
+	"math"
+	"slices"
+	"strconv"
+)
+
+// Value is a value located in a [Source], which is decoded on demand.
+// The zero Value is invalid.
+type Value struct {
+	src *Source
+	pos int64
+	// If index > 0, the Value is the element index-1 of the typed array at pos,
+	// which has no type mark of its own.
+	index int
+}
+
+// Value returns the Value at position pos of src.
+func (src *Source) Value(pos int64) Value {
+	return Value{src: src, pos: pos}
+}
+
+// Decode reads and returns the content of v.
+// See [ReadValue] for the meaning of recursive.
+func (v Value) Decode(recursive bool) (any, error) {
+	if v.index > 0 {
+		return v.decodeElem()
+	}
+	return v.src.ReadValue(v.pos, recursive)
+}
+
+// readElem reads the raw data of v, an element of a typed array, from r.
+// See [Array.readElem].
+func (v Value) readElem(r *reader) (array Array, u uint64, err error) {
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	if t := typeMarker(tb).Type(); t != typeTypedArray {
+		err = fmt.Errorf("invalid typed array type %v", t)
+		return
+	}
+	if err = array.read(r, typeMarker(tb)); err != nil {
+		return
+	}
+	if err = array.checkIndex(v.index - 1); err != nil {
+		return
+	}
+	u, err = array.readElem(r, v.index-1)
+	return
+}
+
+// readElemOf is like [Value.readElem], but returns a [TypeError]
+// if the type of the element is not t.
+func (v Value) readElemOf(r *reader, t typ) (u uint64, err error) {
+	array, u, err := v.readElem(r)
+	if err == nil && array.elem != t {
+		err = &TypeError{array.elem}
+	}
+	return
+}
+
+// decodeElem reads and returns v, an element of a typed array.
+func (v Value) decodeElem() (elem any, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	array, u, err := v.readElem(&r)
+	if err != nil {
+		return
+	}
+	if array.elem != typeString {
+		return rawValue(array.elem, u), nil
+	}
+	p, err := r.next(int(u))
+	if err != nil {
+		return
+	}
+	return string(p), nil
+}
+
+// Lookup returns the value associated with key if v is an object,
+// or the element at index key if v is an array.
+// An array index is parsed with [strconv.ParseUint] in base 0.
+// The returned error is [ErrNotFound] if v is neither an object nor an array,
+// or no value is associated with key.
+func (v Value) Lookup(key string) (elem Value, err error) {
+	if v.index > 0 {
+		err = ErrNotFound
+		return
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	tm := typeMarker(tb)
+	switch tm.Type() {
+	case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
+		var obj Object
+		if err = obj.read(&r, tm); err != nil {
+			return
+		}
+		if err = obj.find(&r, key); err != nil {
+			return
+		}
+	case typeArray, typeTypedArray:
+		var index uint64
+		if index, err = strconv.ParseUint(key, 0, 64); err != nil {
+			return
+		}
+		if index > math.MaxInt {
+			err = fmt.Errorf("invalid index %v", index)
+			return
+		}
+		var array Array
+		if err = array.read(&r, tm); err != nil {
+			return
+		}
+		if err = array.checkIndex(int(index)); err != nil {
+			return
+		}
+		if array.elem != typeNull {
+			return array.typedElemValue(int(index)), nil
+		}
+		if err = array.seekElem(&r, int(index)); err != nil {
+			return
+		}
+	default:
+		err = ErrNotFound
+		return
+	}
+	return Value{src: v.src, pos: r.pos()}, nil
+}
+
+// readType reads a type mark from r.
+// A [TypeError] is returned if the type is not t.
+func readType(r *reader, t typ) (err error) {
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	if rt := typeMarker(tb).Type(); rt != t {
+		err = &TypeError{rt}
+	}
+	return
+}
+
+// Kind is the kind of a value returned by [Value.Scalar].
+type Kind byte
+
+const (
+	KindNull   Kind = iota // null
+	KindInt                // signed integer, whose bits are of the int64
+	KindUint               // unsigned integer
+	KindFloat              // float point number, whose bits are of the float64
+	KindBool               // bool, whose bits are 1 if true, 0 otherwise
+	KindString             // string stored in place, see [Value.Str]
+	KindOther              // any other value, see [Value.Decode]
+)
+
+// Scalar returns the kind of v, and the bits of v if it is an integer,
+// an unsigned integer, a float point number or a bool, with one read of v.
+// Values of the other kinds are not read beyond the type mark.
+func (v Value) Scalar() (kind Kind, bits uint64, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	var t typ
+	if v.index > 0 {
+		var array Array
+		if array, bits, err = v.readElem(&r); err != nil {
+			return
+		}
+		switch t = array.elem; t {
+		case typeInt:
+			bits = uint64(uint2Int(bits))
+		case typeBool:
+			bits = min(bits, 1)
+		case typeString:
+			bits = 0
+		}
+	} else {
+		var tb byte
+		if tb, err = r.ReadByte(); err != nil {
+			return
+		}
+		switch t = typeMarker(tb).Type(); t {
+		case typeInt:
+			var n int64
+			n, err = readIntValue(&r)
+			bits = uint64(n)
+		case typeUint:
+			bits, err = readUintValue(&r)
+		case typeFloat:
+			var f float64
+			f, err = readFloatValue(&r)
+			bits = math.Float64bits(f)
+		case typeBool:
+			var b bool
+			if b, err = readBoolValue(&r); b {
+				bits = 1
+			}
+		}
+	}
+	switch t {
+	case typeNull:
+		kind = KindNull
+	case typeInt:
+		kind = KindInt
+	case typeUint:
+		kind = KindUint
+	case typeFloat:
+		kind = KindFloat
+	case typeBool:
+		kind = KindBool
+	case typeString:
+		kind = KindString
+	default:
+		kind = KindOther
+	}
+	return
+}
+
+// Int returns v as a signed integer.
+func (v Value) Int() (n int64, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeInt); err == nil {
+			n = uint2Int(u)
+		}
+		return
+	}
+	if err = readType(&r, typeInt); err == nil {
+		n, err = readIntValue(&r)
+	}
+	return
+}
+
+// Uint returns v as an unsigned integer.
+func (v Value) Uint() (n uint64, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeUint); err == nil {
+			n = u
+		}
+		return
+	}
+	if err = readType(&r, typeUint); err == nil {
+		n, err = readUintValue(&r)
+	}
+	return
+}
+
+// Float returns v as a float point number.
+func (v Value) Float() (f float64, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeFloat); err == nil {
+			f = math.Float64frombits(u)
+		}
+		return
+	}
+	if err = readType(&r, typeFloat); err == nil {
+		f, err = readFloatValue(&r)
+	}
+	return
+}
+
+// Bool returns v as a bool.
+func (v Value) Bool() (b bool, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeBool); err == nil {
+			b = u != 0
+		}
+		return
+	}
+	if err = readType(&r, typeBool); err == nil {
+		b, err = readBoolValue(&r)
+	}
+	return
+}
+
+// Str returns v as a string.
+func (v Value) Str() (s string, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeString); err != nil {
+			return
+		}
+		var p []byte
+		if p, err = r.next(int(u)); err == nil {
+			s = string(p)
+		}
+		return
+	}
+	if err = readType(&r, typeString); err == nil {
+		s, err = readStringValue(&r)
+	} else if isIndirect(err) {
+		var target Value
+		if target, err = readIndirect(&r); err == nil {
+			s, err = target.Str()
+		}
+	}
+	return
+}
+
+// Gob returns v as a gob encoded value.
+func (v Value) Gob() (gob GobValue, err error) {
+	if v.index > 0 {
+		err = v.elemTypeError()
+		return
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	if err = readType(&r, typeGob); err == nil {
+		gob, err = readGobValue(&r)
+	} else if isIndirect(err) {
+		var target Value
+		if target, err = readIndirect(&r); err == nil {
+			gob, err = target.Gob()
+		}
+	}
+	return
+}
+
+// AppendBytes appends the content of v to dst and returns the extended buffer.
+// The type of v must be string or []byte.
+func (v Value) AppendBytes(dst []byte) (p []byte, err error) {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	var length int
+	if v.index > 0 {
+		var u uint64
+		if u, err = v.readElemOf(&r, typeString); err != nil {
+			return
+		}
+		length = int(u)
+	} else {
+		var tb byte
+		if tb, err = r.ReadByte(); err != nil {
+			return
+		}
+		if t := typeMarker(tb).Type(); t == typeCompressed || t == typeRef {
+			var target Value
+			if target, err = readIndirect(&r); err != nil {
+				return
+			}
+			return target.AppendBytes(dst)
+		} else if t != typeString && t != typeBinary {
+			err = &TypeError{t}
+			return
+		}
+		if length, err = readBinaryLength(&r); err != nil {
+			return
+		}
+	}
+	p = slices.Grow(dst, length)
+	n := len(p)
+	p = p[:n+length]
+	if err = r.read(p[n:]); err != nil {
+		p = dst
+	}
+	return
+}
+
+// Object returns the descriptor of v if v is an object.
+func (v Value) Object() (obj *Object, err error) {
+	if v.index > 0 {
+		err = v.elemTypeError()
+		return
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	tm := typeMarker(tb)
+	switch t := tm.Type(); t {
+	case typeObject, typeFingerprintObject, typeMPHObject, typeSlotObject:
+		obj = &Object{}
+		if err = obj.read(&r, tm); err != nil {
+			obj = nil
+		}
+	default:
+		err = &TypeError{t}
+	}
+	return
+}
+
+// Array returns the descriptor of v if v is an array.
+func (v Value) Array() (array *Array, err error) {
+	if v.index > 0 {
+		err = v.elemTypeError()
+		return
+	}
+	r := v.src.reader(v.pos)
+	defer r.close()
+	tb, err := r.ReadByte()
+	if err != nil {
+		return
+	}
+	tm := typeMarker(tb)
+	if t := tm.Type(); t != typeArray && t != typeTypedArray {
+		err = &TypeError{t}
+		return
+	}
+	array = &Array{}
+	if err = array.read(&r, tm); err != nil {
+		array = nil
+	}
+	return
+}
+
+// elemTypeError returns a [TypeError] of v, an element of a typed array.
+func (v Value) elemTypeError() error {
+	r := v.src.reader(v.pos)
+	defer r.close()
+	array, _, err := v.readElem(&r)
+	if err != nil {
+		return err
+	}
+	return &TypeError{array.elem}
+}
@@ -0,0 +1,413 @@
+package hashive
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+	"slices"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// Layered is a base database overlaid with the delta databases written by [WriteDelta].
+// A query is answered by the newest delta that changes the path or a prefix of it,
+// or by the base database if no delta does.
+// The changes under the path in the newer deltas are merged into the objects
+// returned by [Layered.Query].
+//
+// The paths changed by the deltas are loaded into memory by [NewLayered],
+// so a path not changed is looked up in the base database only.
+// A Layered is safe for concurrent use by multiple goroutines if the databases are.
+type Layered struct {
+	base   *Hashive
+	deltas []*deltaLayer // from the oldest to the newest
+}
+
+// deltaLayer is a delta database of a [Layered].
+type deltaLayer struct {
+	h *Hashive
+	// paths are the encoded paths changed, whose values are true if deleted.
+	paths map[string]bool
+	// prefixes are the encoded proper prefixes of paths.
+	prefixes map[string]struct{}
+	// depths[n] is whether a path of n keys is changed.
+	depths []bool
+	// firsts are the first keys of the paths.
+	firsts map[string]struct{}
+}
+
+// NewLayered returns a Layered of base and deltas, from the oldest to the newest.
+// The values of base and deltas must be gob encoded by the same codec, see [WithCodec].
+func NewLayered(base *Hashive, deltas ...*Hashive) (l *Layered, err error) {
+	l = &Layered{base: base, deltas: make([]*deltaLayer, len(deltas))}
+	for i, h := range deltas {
+		if !sameCodec(h.codec, base.codec) {
+			return nil, fmt.Errorf("delta %v: codec %v differs from the codec %v of the base", i, codecName(h.codec), codecName(base.codec))
+		}
+		if l.deltas[i], err = newDeltaLayer(h); err != nil {
+			return nil, fmt.Errorf("delta %v: %w", i, err)
+		}
+	}
+	return
+}
+
+// sameCodec returns whether the values encoded by a and b, which are nil for gob,
+// are encoded by the same codec with the same schema.
+func sameCodec(a, b impl.Codec) bool {
+	if a == nil || b == nil {
+		return a == nil && b == nil
+	}
+	return a.Name() == b.Name() && bytes.Equal(a.Schema(), b.Schema())
+}
+
+// codecName returns the name of codec c in errors, which is nil for gob.
+func codecName(c impl.Codec) string {
+	if c == nil {
+		return "gob"
+	}
+	return fmt.Sprintf("%q", c.Name())
+}
+
+// newDeltaLayer loads the paths of delta database h.
+func newDeltaLayer(h *Hashive) (d *deltaLayer, err error) {
+	if version, err := h.QueryUint(deltaKeyVersion); err != nil {
+		return nil, errNotDelta
+	} else if version != deltaVersion {
+		return nil, fmt.Errorf("unknown delta version %v", version)
+	}
+	d = &deltaLayer{
+		h:        h,
+		paths:    make(map[string]bool),
+		prefixes: make(map[string]struct{}),
+		firsts:   make(map[string]struct{}),
+	}
+	add := func(key string, deleted bool) (err error) {
+		path, err := decodePath(key)
+		if err != nil {
+			return
+		}
+		d.paths[key] = deleted
+		for len(d.depths) <= len(path) {
+			d.depths = append(d.depths, false)
+		}
+		d.depths[len(path)] = true
+		if len(path) > 0 {
+			d.firsts[path[0]] = struct{}{}
+		}
+		_, ends := encodePath(nil, nil, path)
+		if len(path) > 0 {
+			d.prefixes[""] = struct{}{}
+		}
+		for _, end := range ends[:max(len(ends)-1, 0)] {
+			d.prefixes[key[:end]] = struct{}{}
+		}
+		return
+	}
+	for key, value := range h.Entries(deltaKeySet) {
+		if err = value.Err(); err != nil {
+			return
+		}
+		if err = add(key, false); err != nil {
+			return
+		}
+	}
+	for _, elem := range h.Elements(deltaKeyDel) {
+		var key string
+		if key, err = elem.Str(); err != nil {
+			return
+		}
+		if err = add(key, true); err != nil {
+			return
+		}
+	}
+	return
+}
+
+// match returns the encoded path of the change of d at path or a prefix of it,
+// whose encoding is enc and ends, see [encodePath],
+// and the number of keys of the changed path.
+func (d *deltaLayer) match(enc []byte, ends []int) (key string, depth int, deleted, ok bool) {
+	for depth = min(len(ends), len(d.depths)-1); depth >= 0; depth-- {
+		if !d.depths[depth] {
+			continue
+		}
+		prefix := enc[:0]
+		if depth > 0 {
+			prefix = enc[:ends[depth-1]]
+		}
+		if deleted, ok = d.paths[string(prefix)]; ok {
+			return string(prefix), depth, deleted, true
+		}
+	}
+	return
+}
+
+// layeredPath is a path resolved in the layers of a [Layered].
+type layeredPath struct {
+	path []string
+	enc  []byte // encoded path
+	// top is the index of the newest delta changing the path or a prefix of it,
+	// or -1 if the path is in the base database.
+	top     int
+	key     string // encoded path of the change of top
+	depth   int    // number of keys of the change of top
+	deleted bool   // whether the change of top is a deletion
+	// merge is whether a delta newer than top changes the values under the path.
+	merge bool
+}
+
+// resolve returns the layer of path.
+func (l *Layered) resolve(path []string) (p layeredPath) {
+	p = layeredPath{path: path, top: -1}
+	var ends []int
+	p.enc, ends = encodePath(nil, nil, path)
+	for i := len(l.deltas) - 1; i >= 0; i-- {
+		var ok bool
+		if p.key, p.depth, p.deleted, ok = l.deltas[i].match(p.enc, ends); ok {
+			p.top = i
+			break
+		}
+	}
+	for _, d := range l.deltas[p.top+1:] {
+		if _, ok := d.prefixes[string(p.enc)]; ok {
+			p.merge = true
+			break
+		}
+	}
+	return
+}
+
+// layeredQuery queries the path resolved by p in its layer with query.
+func layeredQuery[T any](l *Layered, p *layeredPath, query func(h *Hashive, path []string) (T, error)) (v T, err error) {
+	if p.top < 0 {
+		return query(l.base, p.path)
+	}
+	if p.deleted {
+		err = ErrNotFound
+		return
+	}
+	return query(l.deltas[p.top].h, append([]string{deltaKeySet, p.key}, p.path[p.depth:]...))
+}
+
+// scalarQuery queries the value at path with query, which is not an object.
+func scalarQuery[T any](l *Layered, path []string, query func(h *Hashive, path []string) (T, error)) (v T, err error) {
+	p := l.resolve(path)
+	if p.merge {
+		// The value is an object with the changes of the newer deltas.
+		err = ErrNotFound
+		return
+	}
+	return layeredQuery(l, &p, query)
+}
+
+// Query queries a value mapped by the path, see [Hashive.Query].
+func (l *Layered) Query(path ...string) (v any, err error) {
+	return l.query(path, nil)
+}
+
+// query queries a value mapped by the path, see [Hashive.Query].
+// The value of the base database is passed through fromBase if it is not nil.
+func (l *Layered) query(path []string, fromBase func(v any) (any, error)) (v any, err error) {
+	p := l.resolve(path)
+	v, err = layeredQuery(l, &p, func(h *Hashive, path []string) (any, error) {
+		return h.Query(path...)
+	})
+	if p.top < 0 && fromBase != nil && err == nil {
+		if v, err = fromBase(v); err != nil {
+			return
+		}
+	}
+	if !p.merge || err != nil && err != ErrNotFound {
+		return
+	}
+	found := err == nil
+	for _, d := range l.deltas[p.top+1:] {
+		if _, ok := d.prefixes[string(p.enc)]; !ok {
+			continue
+		}
+		for key, deleted := range d.paths {
+			if len(key) <= len(p.enc) || key[:len(p.enc)] != string(p.enc) {
+				continue
+			}
+			var rel []string
+			if rel, err = decodePath(key[len(p.enc):]); err != nil {
+				return
+			}
+			if deleted {
+				if found {
+					if err = deleteIn(v, rel); err != nil {
+						return
+					}
+				}
+				continue
+			}
+			var value any
+			if value, err = d.h.Query(deltaKeySet, key); err != nil {
+				return
+			}
+			if v, err = setIn(v, rel, value, true); err != nil {
+				return
+			}
+			found = true
+		}
+	}
+	if !found {
+		return nil, ErrNotFound
+	}
+	return v, nil
+}
+
+// QueryString queries a string mapped by the path, see [Hashive.QueryString].
+func (l *Layered) QueryString(path ...string) (string, error) {
+	return scalarQuery(l, path, func(h *Hashive, path []string) (string, error) {
+		return h.QueryString(path...)
+	})
+}
+
+// QueryInt queries an integer mapped by the path, see [Hashive.QueryInt].
+func (l *Layered) QueryInt(path ...string) (int64, error) {
+	return scalarQuery(l, path, func(h *Hashive, path []string) (int64, error) {
+		return h.QueryInt(path...)
+	})
+}
+
+// QueryUint queries an unsigned integer mapped by the path, see [Hashive.QueryUint].
+func (l *Layered) QueryUint(path ...string) (uint64, error) {
+	return scalarQuery(l, path, func(h *Hashive, path []string) (uint64, error) {
+		return h.QueryUint(path...)
+	})
+}
+
+// QueryFloat queries a float point number mapped by the path, see [Hashive.QueryFloat].
+func (l *Layered) QueryFloat(path ...string) (float64, error) {
+	return scalarQuery(l, path, func(h *Hashive, path []string) (float64, error) {
+		return h.QueryFloat(path...)
+	})
+}
+
+// QueryBool queries a bool mapped by the path, see [Hashive.QueryBool].
+func (l *Layered) QueryBool(path ...string) (bool, error) {
+	return scalarQuery(l, path, func(h *Hashive, path []string) (bool, error) {
+		return h.QueryBool(path...)
+	})
+}
+
+// QueryGob queries a gob encoded value mapped by the path, see [Hashive.QueryGob].
+func (l *Layered) QueryGob(v any, path ...string) (err error) {
+	_, err = scalarQuery(l, path, func(h *Hashive, path []string) (struct{}, error) {
+		return struct{}{}, h.QueryGob(v, path...)
+	})
+	return
+}
+
+// Compact writes the database of l with the deltas applied to w,
+// which can be the base of new deltas.
+// If the root value of the base database is an object, the entries of it
+// are written one by one with a [Builder] in tempDir, and the values not
+// changed by the deltas are decoded one at a time; otherwise the whole value
+// is decoded into memory and written by [Write].
+// The encoding can be configured with opts, see [Write].
+//
+// The gob values are copied without decoding, so they are written with the
+// codec of the base database, which opts must not change, see [WithCodec].
+// The gob values of a base database written by an old version of Hashive
+// are copied with the definitions of their types.
+func Compact(w io.Writer, l *Layered, tempDir string, opts ...WriteOption) (err error) {
+	if c := newWriteOptions(opts).Codec; c == nil && l.base.codec != nil {
+		opts = append(slices.Clip(opts), WithCodec(l.base.codec))
+	} else if !sameCodec(c, l.base.codec) {
+		return fmt.Errorf("codec %v differs from the codec %v of the base", codecName(c), codecName(l.base.codec))
+	}
+	fromBase := l.base.portableGobs
+	if l.base.gobTypes == nil {
+		fromBase = nil
+	}
+	changed := make(map[string]struct{}) // first keys of the paths changed
+	root := false                        // whether the root is changed
+	for _, d := range l.deltas {
+		for key := range d.firsts {
+			changed[key] = struct{}{}
+		}
+		_, ok := d.paths[""]
+		root = root || ok
+	}
+	if _, err = l.base.root.Object(); root || err != nil {
+		var v any
+		if v, err = l.query(nil, fromBase); err != nil {
+			return
+		}
+		return Write(w, v, opts...)
+	}
+
+	b, err := NewBuilder(w, tempDir, opts...)
+	if err != nil {
+		return
+	}
+	defer b.Close()
+	for key, value := range l.base.Entries() {
+		if err = value.Err(); err != nil {
+			return
+		}
+		var v any
+		if _, ok := changed[key]; ok {
+			delete(changed, key)
+			if v, err = l.query([]string{key}, fromBase); err == ErrNotFound {
+				continue
+			}
+		} else if v, err = value.v.Decode(true); err == nil && fromBase != nil {
+			v, err = fromBase(v)
+		}
+		if err != nil {
+			return
+		}
+		if err = b.Add(key, v); err != nil {
+			return
+		}
+	}
+	// The keys added by the deltas.
+	added := make([]string, 0, len(changed))
+	for key := range changed {
+		added = append(added, key)
+	}
+	slices.Sort(added)
+	for _, key := range added {
+		var v any
+		if v, err = l.Query(key); err == ErrNotFound {
+			continue
+		} else if err != nil {
+			return
+		}
+		if err = b.Add(key, v); err != nil {
+			return
+		}
+	}
+	return b.Finish()
+}
+
+// portableGobs replaces the gob values in v decoded from h, which is signed
+// "hashive\x00", with gob values led by the definitions of their types,
+// so they can be written to another database, see [impl.LegacyGobValue].
+// The maps and slices of v are modified in place.
+func (h *Hashive) portableGobs(v any) (_ any, err error) {
+	switch v := v.(type) {
+	case impl.GobValue:
+		var types []byte
+		if types, err = h.gobTypes(); err != nil {
+			return
+		}
+		return impl.LegacyGobValue(types, v)
+	case map[string]any:
+		for key, elem := range v {
+			if v[key], err = h.portableGobs(elem); err != nil {
+				return
+			}
+		}
+	case []any:
+		for i, elem := range v {
+			if v[i], err = h.portableGobs(elem); err != nil {
+				return
+			}
+		}
+	}
+	return v, nil
+}
@@ -0,0 +1,98 @@
+package hashive
+
+import (
+	"hash/maphash"
+	"slices"
+	"sync"
+	"sync/atomic"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// CacheStats is the statistics of a cache of [Hashive].
+type CacheStats struct {
+	Hits    uint64 // number of lookups found in the cache
+	Misses  uint64 // number of lookups not found in the cache
+	Entries int    // number of entries in the cache
+}
+
+// HitRate returns the ratio of hits to lookups, or 0 if there is no lookup.
+func (s CacheStats) HitRate() float64 {
+	if total := s.Hits + s.Misses; total > 0 {
+		return float64(s.Hits) / float64(total)
+	}
+	return 0
+}
+
+// pathCache caches the values of path prefixes, so that the common levels of
+// query paths are not resolved again.
+// Entries are evicted at random when the cache is full.
+type pathCache struct {
+	size         int
+	seed         maphash.Seed
+	mu           sync.RWMutex
+	entries      map[uint64]pathCacheEntry
+	hits, misses atomic.Uint64
+}
+
+type pathCacheEntry struct {
+	path  []string
+	value impl.Value
+}
+
+func newPathCache(size int) *pathCache {
+	return &pathCache{
+		size:    size,
+		seed:    maphash.MakeSeed(),
+		entries: make(map[uint64]pathCacheEntry, size),
+	}
+}
+
+// hashPath returns the hash of path.
+func hashPath(seed maphash.Seed, path []string) uint64 {
+	var h maphash.Hash
+	h.SetSeed(seed)
+	for _, key := range path {
+		h.WriteString(key)
+		h.WriteByte(0)
+	}
+	return h.Sum64()
+}
+
+// get returns the cached value of path.
+// The returned hash is the argument of [pathCache.put] if path is not found.
+func (c *pathCache) get(path []string) (v impl.Value, hash uint64, ok bool) {
+	hash = hashPath(c.seed, path)
+	c.mu.RLock()
+	entry, ok := c.entries[hash]
+	c.mu.RUnlock()
+	// Different paths can have the same hash.
+	if ok = ok && slices.Equal(entry.path, path); ok {
+		c.hits.Add(1)
+		return entry.value, hash, true
+	}
+	c.misses.Add(1)
+	return
+}
+
+// put caches v as the value of path whose hash is hash.
+func (c *pathCache) put(path []string, hash uint64, v impl.Value) {
+	entry := pathCacheEntry{path: slices.Clone(path), value: v}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if _, ok := c.entries[hash]; !ok && len(c.entries) >= c.size {
+		for k := range c.entries {
+			// The iteration order of maps is random.
+			delete(c.entries, k)
+			break
+		}
+	}
+	c.entries[hash] = entry
+}
+
+func (c *pathCache) stats() CacheStats {
+	c.mu.RLock()
+	entries := len(c.entries)
+	c.mu.RUnlock()
+	return CacheStats{Hits: c.hits.Load(), Misses: c.misses.Load(), Entries: entries}
+}
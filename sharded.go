@@ -0,0 +1,304 @@
+package hashive
+
+import (
+	"errors"
+	"fmt"
+	"math/bits"
+	"path/filepath"
+	"runtime"
+	"sync"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// A sharded database is a manifest file and the shard files it lists.
+// The manifest is a database whose root object is:
+//
+//	{"sharded": 1, "seed": seed, "shards": [file, ...]}
+//
+// where "sharded" is the version of the format, and the shard files are
+// relative to the directory of the manifest. Every shard is an ordinary database
+// whose root object holds the top-level keys routed to it by [ShardManifest.Shard].
+
+// shardedVersion is the version of the sharded format.
+const shardedVersion = 1
+
+// Keys of the root object of a manifest.
+const (
+	manifestKeyVersion = "sharded"
+	manifestKeySeed    = "seed"
+	manifestKeyShards  = "shards"
+)
+
+// ShardManifest is the manifest of a sharded database.
+// Shards can be built independently, on separate machines for example,
+// by routing every top-level key with [ShardManifest.Shard] and writing
+// the keys of every shard to its file as an object, with [Write] or [Builder].
+type ShardManifest struct {
+	Seed uint64 // seed of the hash routing keys
+	// Shards are the files of the shards.
+	// Relative files are relative to the directory of the manifest.
+	Shards []string
+}
+
+// NewShardManifest returns a ShardManifest of n shards with seed,
+// whose shard files are name.0, name.1, and so on.
+func NewShardManifest(name string, n int, seed uint64) *ShardManifest {
+	m := &ShardManifest{Seed: seed, Shards: make([]string, n)}
+	for i := range m.Shards {
+		m.Shards[i] = fmt.Sprintf("%v.%v", name, i)
+	}
+	return m
+}
+
+// Shard returns the index of the shard of top-level key.
+func (m *ShardManifest) Shard(key string) int {
+	// The high bits of the product are uniform in [0, len(m.Shards)) without division.
+	shard, _ := bits.Mul64(impl.ShardHash(key, m.Seed), uint64(len(m.Shards)))
+	return int(shard)
+}
+
+// WriteShardManifest writes m to file filename.
+func WriteShardManifest(filename string, m *ShardManifest) error {
+	shards := make([]any, len(m.Shards))
+	for i, shard := range m.Shards {
+		shards[i] = shard
+	}
+	return WriteFile(filename, map[string]any{
+		manifestKeyVersion: uint64(shardedVersion),
+		manifestKeySeed:    m.Seed,
+		manifestKeyShards:  shards,
+	})
+}
+
+// ReadShardManifest reads the manifest of file filename.
+func ReadShardManifest(filename string) (m *ShardManifest, err error) {
+	h, closeFile, err := Open(filename, -1)
+	if err != nil {
+		return
+	}
+	defer closeFile()
+	if version, err := h.QueryUint(manifestKeyVersion); err != nil {
+		return nil, errors.New("not a shard manifest")
+	} else if version != shardedVersion {
+		return nil, fmt.Errorf("unknown shard manifest version %v", version)
+	}
+	m = &ShardManifest{}
+	if m.Seed, err = h.QueryUint(manifestKeySeed); err != nil {
+		return
+	}
+	for _, v := range h.Elements(manifestKeyShards) {
+		var shard string
+		if shard, err = v.Str(); err != nil {
+			return
+		}
+		m.Shards = append(m.Shards, shard)
+	}
+	if len(m.Shards) == 0 {
+		return nil, errors.New("no shard in manifest")
+	}
+	return
+}
+
+// WriteSharded writes value to a sharded database of n shards, whose manifest is
+// file filename, and the shards are files filename.0, filename.1, and so on.
+// Keys are routed to the shards with the hash of seed.
+// The shards are written in parallel, and the manifest is written last.
+// The encoding of the shards can be configured with opts, see [Write].
+func WriteSharded(filename string, value map[string]any, n int, seed uint64, opts ...WriteOption) (err error) {
+	if n <= 0 {
+		return fmt.Errorf("invalid shard count %v", n)
+	}
+	m := NewShardManifest(filepath.Base(filename), n, seed)
+	shards := make([]map[string]any, n)
+	for i := range shards {
+		shards[i] = make(map[string]any)
+	}
+	for key, v := range value {
+		shards[m.Shard(key)][key] = v
+	}
+	dir := filepath.Dir(filename)
+	errs := make([]error, n)
+	var wg sync.WaitGroup
+	sem := make(chan struct{}, runtime.GOMAXPROCS(0))
+	for i := range shards {
+		wg.Add(1)
+		sem <- struct{}{}
+		go func(i int) {
+			defer wg.Done()
+			errs[i] = WriteFile(filepath.Join(dir, m.Shards[i]), shards[i], opts...)
+			<-sem
+		}(i)
+	}
+	wg.Wait()
+	if err = errors.Join(errs...); err != nil {
+		return
+	}
+	return WriteShardManifest(filename, m)
+}
+
+// ShardedHashive is a sharded database, see [WriteSharded].
+// A query is routed to the shard of the first key of its path.
+// The shards are opened with [OpenMmap] on the first query routed to them,
+// so a query reads the mapped file of one shard only.
+// A ShardedHashive is safe for concurrent use by multiple goroutines.
+type ShardedHashive struct {
+	manifest *ShardManifest
+	dir      string
+	opts     []Option
+	shards   []shard
+}
+
+// shard is a lazily opened shard of a [ShardedHashive].
+type shard struct {
+	once  sync.Once
+	h     *Hashive
+	close func() error
+	err   error
+}
+
+// OpenSharded opens the sharded database of manifest file filename.
+// The shards are configured with opts.
+// The returned ShardedHashive must be closed by [ShardedHashive.Close] after use.
+func OpenSharded(filename string, opts ...Option) (s *ShardedHashive, err error) {
+	m, err := ReadShardManifest(filename)
+	if err != nil {
+		return
+	}
+	return &ShardedHashive{
+		manifest: m,
+		dir:      filepath.Dir(filename),
+		opts:     opts,
+		shards:   make([]shard, len(m.Shards)),
+	}, nil
+}
+
+// Shards returns the number of shards of s.
+func (s *ShardedHashive) Shards() int {
+	return len(s.shards)
+}
+
+// Shard returns the shard i of s, which is opened if not yet.
+func (s *ShardedHashive) Shard(i int) (*Hashive, error) {
+	if i < 0 || i >= len(s.shards) {
+		return nil, fmt.Errorf("invalid shard %v of %v", i, len(s.shards))
+	}
+	shard := &s.shards[i]
+	shard.once.Do(func() {
+		file := s.manifest.Shards[i]
+		if !filepath.IsAbs(file) {
+			file = filepath.Join(s.dir, file)
+		}
+		shard.h, shard.close, shard.err = OpenMmap(file, s.opts...)
+	})
+	return shard.h, shard.err
+}
+
+// Close closes the shards opened.
+// The shards must not be used after that.
+func (s *ShardedHashive) Close() error {
+	var errs []error
+	for i := range s.shards {
+		shard := &s.shards[i]
+		// Shards not opened are not opened any more.
+		shard.once.Do(func() { shard.err = errors.New("sharded database is closed") })
+		if shard.close != nil {
+			errs = append(errs, shard.close())
+			shard.close = nil
+		}
+	}
+	return errors.Join(errs...)
+}
+
+// route returns the shard of path, which is not empty.
+func (s *ShardedHashive) route(path []string) (*Hashive, error) {
+	return s.Shard(s.manifest.Shard(path[0]))
+}
+
+// shardedQuery queries path in the shard of it with query.
+func shardedQuery[T any](s *ShardedHashive, path []string, query func(h *Hashive, path []string) (T, error)) (v T, err error) {
+	if len(path) == 0 {
+		// The root is an object.
+		err = ErrNotFound
+		return
+	}
+	h, err := s.route(path)
+	if err != nil {
+		return
+	}
+	return query(h, path)
+}
+
+// Query queries a value mapped by the path, see [Hashive.Query].
+// The empty path maps to the object of the top-level keys of all the shards.
+func (s *ShardedHashive) Query(path ...string) (v any, err error) {
+	if len(path) > 0 {
+		h, err := s.route(path)
+		if err != nil {
+			return nil, err
+		}
+		return h.Query(path...)
+	}
+	root := make(map[string]any)
+	for i := range s.shards {
+		var h *Hashive
+		if h, err = s.Shard(i); err != nil {
+			return
+		}
+		var shardRoot any
+		if shardRoot, err = h.Query(); err != nil {
+			return
+		}
+		obj, ok := shardRoot.(map[string]any)
+		if !ok {
+			return nil, fmt.Errorf("root of shard %v is not an object", i)
+		}
+		for key, value := range obj {
+			root[key] = value
+		}
+	}
+	return root, nil
+}
+
+// QueryString queries a string mapped by the path, see [Hashive.QueryString].
+func (s *ShardedHashive) QueryString(path ...string) (string, error) {
+	return shardedQuery(s, path, func(h *Hashive, path []string) (string, error) {
+		return h.QueryString(path...)
+	})
+}
+
+// QueryInt queries an integer mapped by the path, see [Hashive.QueryInt].
+func (s *ShardedHashive) QueryInt(path ...string) (int64, error) {
+	return shardedQuery(s, path, func(h *Hashive, path []string) (int64, error) {
+		return h.QueryInt(path...)
+	})
+}
+
+// QueryUint queries an unsigned integer mapped by the path, see [Hashive.QueryUint].
+func (s *ShardedHashive) QueryUint(path ...string) (uint64, error) {
+	return shardedQuery(s, path, func(h *Hashive, path []string) (uint64, error) {
+		return h.QueryUint(path...)
+	})
+}
+
+// QueryFloat queries a float point number mapped by the path, see [Hashive.QueryFloat].
+func (s *ShardedHashive) QueryFloat(path ...string) (float64, error) {
+	return shardedQuery(s, path, func(h *Hashive, path []string) (float64, error) {
+		return h.QueryFloat(path...)
+	})
+}
+
+// QueryBool queries a bool mapped by the path, see [Hashive.QueryBool].
+func (s *ShardedHashive) QueryBool(path ...string) (bool, error) {
+	return shardedQuery(s, path, func(h *Hashive, path []string) (bool, error) {
+		return h.QueryBool(path...)
+	})
+}
+
+// QueryGob queries a gob encoded value mapped by the path, see [Hashive.QueryGob].
+func (s *ShardedHashive) QueryGob(v any, path ...string) (err error) {
+	_, err = shardedQuery(s, path, func(h *Hashive, path []string) (struct{}, error) {
+		return struct{}{}, h.QueryGob(v, path...)
+	})
+	return
+}
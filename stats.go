@@ -0,0 +1,172 @@
+package hashive
+
+import (
+	"context"
+	"expvar"
+	"math/bits"
+	"runtime/trace"
+	"sync/atomic"
+	"time"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// QueryStats is the statistics of the lookups of a [Hashive], see [WithStats].
+// Queries answered by the value cache of [WithValueCache] are not looked up.
+type QueryStats struct {
+	Lookups  uint64 // number of paths looked up
+	NotFound uint64 // number of paths not found
+	// Probes is the number of entries examined by the lookups in objects,
+	// by key fingerprint or by key.
+	Probes uint64
+	// Reads is the number of reads of the storage, which refill the read buffers.
+	// A read of [Open], [New] or [NewReaderAt] is a system call for files.
+	// The memory of [OpenMmap] and [NewFromBytes] is not counted.
+	Reads     uint64
+	BytesRead uint64 // bytes of Reads
+	// Filtered is the number of keys rejected by the filters of objects without reading them,
+	// see [WithFilter].
+	Filtered uint64
+
+	GobDecodes    uint64        // number of gob values decoded by [Hashive.QueryGob]
+	GobDecodeTime time.Duration // total time of GobDecodes
+
+	Latency LatencyHistogram // latency of the lookups
+}
+
+// latencyBuckets is the number of buckets of a [LatencyHistogram].
+const latencyBuckets = 20
+
+// latencyBase is the upper bound of the first bucket of a [LatencyHistogram].
+const latencyBase = 128 * time.Nanosecond
+
+// LatencyHistogram counts lookups by latency in buckets of powers of 2:
+// bucket 0 counts the lookups faster than 128ns, bucket i counts the lookups
+// of [128ns<<(i-1), 128ns<<i), and the last bucket counts all the slower ones.
+type LatencyHistogram [latencyBuckets]uint64
+
+// latencyBucket returns the bucket of latency d.
+func latencyBucket(d time.Duration) int {
+	if d < latencyBase {
+		return 0
+	}
+	return min(bits.Len64(uint64(d/latencyBase)), latencyBuckets-1)
+}
+
+// Bound returns the upper bound of bucket i,
+// which is the max Duration for the last bucket.
+func (h *LatencyHistogram) Bound(i int) time.Duration {
+	if i >= latencyBuckets-1 {
+		return 1<<63 - 1
+	}
+	return latencyBase << i
+}
+
+// Quantile returns the upper bound of the bucket of quantile q, such as 0.99,
+// or 0 if no lookup is counted.
+func (h *LatencyHistogram) Quantile(q float64) time.Duration {
+	var total uint64
+	for _, n := range h {
+		total += n
+	}
+	if total == 0 {
+		return 0
+	}
+	rank := uint64(q * float64(total))
+	var n uint64
+	for i := range h {
+		if n += h[i]; n > rank {
+			return h.Bound(i)
+		}
+	}
+	return h.Bound(latencyBuckets - 1)
+}
+
+// queryStats is the counters of [QueryStats].
+type queryStats struct {
+	src                     impl.Stats
+	lookups, notFound       atomic.Uint64
+	gobDecodes, gobDecodeNs atomic.Uint64
+	latency                 [latencyBuckets]atomic.Uint64
+}
+
+// WithStats returns an [Option] that counts the work of the lookups,
+// which is returned by [Hashive.Stats].
+// The lookups are also traced as regions of [runtime/trace] while tracing.
+func WithStats() Option {
+	return func(opts *options) {
+		opts.stats = true
+	}
+}
+
+// countStats counts the stats of h.
+func (h *Hashive) countStats() {
+	h.stats = &queryStats{}
+	h.src.CountStats(&h.stats.src)
+	decode := h.gobDecoder
+	h.gobDecoder = func(gob impl.GobValue, v any) error {
+		start := time.Now()
+		err := decode(gob, v)
+		h.stats.gobDecodes.Add(1)
+		h.stats.gobDecodeNs.Add(uint64(time.Since(start)))
+		return err
+	}
+}
+
+// countLookup is [Hashive.lookup] with the stats counted.
+func (h *Hashive) countLookup(path []string) (v impl.Value, err error) {
+	if trace.IsEnabled() {
+		defer trace.StartRegion(context.Background(), "hashive.lookup").End()
+	}
+	start := time.Now()
+	v, err = h.resolve(path)
+	h.stats.latency[latencyBucket(time.Since(start))].Add(1)
+	h.stats.lookups.Add(1)
+	if err == ErrNotFound {
+		h.stats.notFound.Add(1)
+	}
+	return
+}
+
+// Stats returns the statistics of the lookups.
+// The zero QueryStats is returned if the stats are not counted by [WithStats].
+func (h *Hashive) Stats() (stats QueryStats) {
+	s := h.stats
+	if s == nil {
+		return
+	}
+	stats = QueryStats{
+		Lookups:       s.lookups.Load(),
+		NotFound:      s.notFound.Load(),
+		Probes:        s.src.Probes.Load(),
+		Reads:         s.src.Reads.Load(),
+		BytesRead:     s.src.BytesRead.Load(),
+		Filtered:      s.src.Filtered.Load(),
+		GobDecodes:    s.gobDecodes.Load(),
+		GobDecodeTime: time.Duration(s.gobDecodeNs.Load()),
+	}
+	for i := range s.latency {
+		stats.Latency[i] = s.latency[i].Load()
+	}
+	return
+}
+
+// Expvar returns an [expvar.Var] of [Hashive.Stats], which can be published
+// with [expvar.Publish] to export the stats as JSON.
+func (h *Hashive) Expvar() expvar.Var {
+	return expvar.Func(func() any { return h.Stats() })
+}
+
+// WriteReport is the report of the layouts of the objects and arrays written,
+// see [WithWriteReport].
+type WriteReport = impl.WriteReport
+
+// WithWriteReport returns a [WriteOption] that reports the layouts of
+// the objects and arrays written to report: the numbers of keys and buckets,
+// the lengths of bucket lists and the sizes of offsets.
+// A badly distributed object shows as a long MaxChain or a high AvgChain.
+func WithWriteReport(report *WriteReport) WriteOption {
+	return func(opts *impl.WriteOptions) {
+		opts.Report = report
+	}
+}
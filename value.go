@@ -0,0 +1,216 @@
+package hashive
+
+import (
+	"iter"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// Value is a value of a database yielded by the iterators of [Hashive].
+// A Value is only a position in the database, and is decoded on demand.
+//
+// An iterator stops at the first error, which is yielded as a Value
+// whose Err method returns the error.
+type Value struct {
+	h   *Hashive
+	v   impl.Value
+	err error
+}
+
+// Err returns the error of v, or nil if v is a valid value.
+func (v Value) Err() error {
+	return v.err
+}
+
+// Decode decodes v recursively, see [Hashive.Query].
+func (v Value) Decode() (any, error) {
+	if v.err != nil {
+		return nil, v.err
+	}
+	return v.v.Decode(true)
+}
+
+// Str returns v as a string.
+// [ErrNotFound] is returned if the type of v is not string.
+func (v Value) Str() (s string, err error) {
+	if v.err != nil {
+		return "", v.err
+	}
+	s, err = v.v.Str()
+	return s, notFound(err)
+}
+
+// AppendBytes appends the content of v to dst and returns the extended buffer.
+// [ErrNotFound] is returned if the type of v is neither string nor []byte.
+func (v Value) AppendBytes(dst []byte) (p []byte, err error) {
+	if v.err != nil {
+		return dst, v.err
+	}
+	p, err = v.v.AppendBytes(dst)
+	return p, notFound(err)
+}
+
+// Int returns v as a signed integer.
+// [ErrNotFound] is returned if the type of v is not signed integer.
+func (v Value) Int() (n int64, err error) {
+	if v.err != nil {
+		return 0, v.err
+	}
+	n, err = v.v.Int()
+	return n, notFound(err)
+}
+
+// Uint returns v as an unsigned integer.
+// [ErrNotFound] is returned if the type of v is not unsigned integer.
+func (v Value) Uint() (n uint64, err error) {
+	if v.err != nil {
+		return 0, v.err
+	}
+	n, err = v.v.Uint()
+	return n, notFound(err)
+}
+
+// Float returns v as a float point number.
+// [ErrNotFound] is returned if the type of v is not float point number.
+func (v Value) Float() (f float64, err error) {
+	if v.err != nil {
+		return 0, v.err
+	}
+	f, err = v.v.Float()
+	return f, notFound(err)
+}
+
+// Bool returns v as a bool.
+// [ErrNotFound] is returned if the type of v is not bool.
+func (v Value) Bool() (b bool, err error) {
+	if v.err != nil {
+		return false, v.err
+	}
+	b, err = v.v.Bool()
+	return b, notFound(err)
+}
+
+// Gob decodes v into p if v is a gob encoded value.
+// [ErrNotFound] is returned if the type of v is not a gob encoded value.
+func (v Value) Gob(p any) (err error) {
+	if v.err != nil {
+		return v.err
+	}
+	gob, err := v.v.Gob()
+	if err != nil {
+		return notFound(err)
+	}
+	return v.h.gobDecoder(gob, p)
+}
+
+// Entries returns an iterator over the key-value pairs of v in the order of the database.
+// The entries are read sequentially and their values are not decoded,
+// so an object of any size can be scanned in constant memory.
+// If v is not an object, [ErrNotFound] is yielded, see [Value].
+func (v Value) Entries() iter.Seq2[string, Value] {
+	return func(yield func(string, Value) bool) {
+		if v.err != nil {
+			yield("", v)
+			return
+		}
+		obj, err := v.v.Object()
+		if err == nil {
+			err = obj.Range(func(key string, value impl.Value) bool {
+				return yield(key, Value{h: v.h, v: value})
+			})
+		}
+		if err != nil {
+			yield("", Value{h: v.h, err: notFound(err)})
+		}
+	}
+}
+
+// Elements returns an iterator over the indexes and elements of v.
+// The elements are not decoded.
+// If v is not an array, [ErrNotFound] is yielded, see [Value].
+func (v Value) Elements() iter.Seq2[int, Value] {
+	return func(yield func(int, Value) bool) {
+		if v.err != nil {
+			yield(0, v)
+			return
+		}
+		array, err := v.v.Array()
+		if err == nil {
+			err = array.Range(func(i int, elem impl.Value) bool {
+				return yield(i, Value{h: v.h, v: elem})
+			})
+		}
+		if err != nil {
+			yield(0, Value{h: v.h, err: notFound(err)})
+		}
+	}
+}
+
+// Range returns an iterator over the key-value pairs of v whose keys are in [lo, hi),
+// in the order of keys. If hi is empty, the keys are not bounded above.
+// The values are not decoded.
+// If v is not an object, [ErrNotFound] is yielded, see [Value].
+//
+// The keys of an object written with [WithSortedKeys] are found by a binary search
+// of its sorted index, so a range of k keys takes O(log n + k) reads.
+// The keys in the range of other objects are collected by reading all the entries,
+// and sorted in memory.
+func (v Value) Range(lo, hi string) iter.Seq2[string, Value] {
+	return func(yield func(string, Value) bool) {
+		if v.err != nil {
+			yield("", v)
+			return
+		}
+		obj, err := v.v.Object()
+		if err == nil {
+			err = obj.RangeKeys(lo, hi, func(key string, value impl.Value) bool {
+				return yield(key, Value{h: v.h, v: value})
+			})
+		}
+		if err != nil {
+			yield("", Value{h: v.h, err: notFound(err)})
+		}
+	}
+}
+
+// Prefix returns an iterator over the key-value pairs of v whose keys start with prefix,
+// in the order of keys, see [Value.Range].
+func (v Value) Prefix(prefix string) iter.Seq2[string, Value] {
+	return v.Range(prefix, impl.PrefixEnd(prefix))
+}
+
+// Value returns the value mapped by path without decoding it.
+// If the path does not map to any value, the Err method of the returned Value
+// returns [ErrNotFound].
+//
+// For the meaning of argument path, see [Hashive.Query].
+func (h *Hashive) Value(path ...string) Value {
+	v, err := h.lookup(path)
+	return Value{h: h, v: v, err: err}
+}
+
+// Entries returns an iterator over the key-value pairs of the object mapped by path.
+// It is the same as h.Value(path...).Entries(), see [Value.Entries].
+func (h *Hashive) Entries(path ...string) iter.Seq2[string, Value] {
+	return h.Value(path...).Entries()
+}
+
+// Range returns an iterator over the key-value pairs of the object mapped by path
+// whose keys are in [lo, hi).
+// It is the same as h.Value(path...).Range(lo, hi), see [Value.Range].
+func (h *Hashive) Range(lo, hi string, path ...string) iter.Seq2[string, Value] {
+	return h.Value(path...).Range(lo, hi)
+}
+
+// Prefix returns an iterator over the key-value pairs of the object mapped by path
+// whose keys start with prefix.
+// It is the same as h.Value(path...).Prefix(prefix), see [Value.Prefix].
+func (h *Hashive) Prefix(prefix string, path ...string) iter.Seq2[string, Value] {
+	return h.Value(path...).Prefix(prefix)
+}
+
+// Elements returns an iterator over the elements of the array mapped by path.
+// It is the same as h.Value(path...).Elements(), see [Value.Elements].
+func (h *Hashive) Elements(path ...string) iter.Seq2[int, Value] {
+	return h.Value(path...).Elements()
+}
@@ -0,0 +1,171 @@
+package hashive
+
+import (
+	"hash/maphash"
+	"slices"
+	"sync"
+	"sync/atomic"
+
+	"github.com/mkch/hashive/internal/impl"
+)
+
+// valueCacheShards is the number of shards of a valueCache.
+// It must be a power of 2.
+const valueCacheShards = 16
+
+// valueCacheEntryOverhead is the estimated memory of an entry besides its path and value.
+const valueCacheEntryOverhead = 96
+
+// valueCache caches the decoded values of query paths.
+// The cache is split into shards by the hash of paths to reduce lock contention,
+// and entries of each shard are evicted with the CLOCK algorithm:
+// a hit only sets the referenced bit of an entry under a read lock,
+// and eviction skips and clears the referenced entries once.
+type valueCache struct {
+	seed         maphash.Seed
+	shards       [valueCacheShards]valueCacheShard
+	hits, misses atomic.Uint64
+}
+
+type valueCacheShard struct {
+	mu       sync.RWMutex
+	index    map[uint64]int // hash of path to the index in entries
+	entries  []*valueCacheEntry
+	free     []int // indexes of nil entries
+	hand     int   // the CLOCK hand
+	bytes    int
+	maxBytes int
+}
+
+type valueCacheEntry struct {
+	hash       uint64
+	path       []string
+	value      any
+	size       int
+	referenced atomic.Bool
+}
+
+func newValueCache(maxBytes int) *valueCache {
+	c := &valueCache{seed: maphash.MakeSeed()}
+	for i := range c.shards {
+		c.shards[i].index = make(map[uint64]int)
+		c.shards[i].maxBytes = maxBytes / valueCacheShards
+	}
+	return c
+}
+
+func (c *valueCache) shard(hash uint64) *valueCacheShard {
+	return &c.shards[hash&(valueCacheShards-1)]
+}
+
+// get returns the cached value of path.
+// The returned hash is the argument of [valueCache.put] if path is not found.
+func (c *valueCache) get(path []string) (v any, hash uint64, ok bool) {
+	hash = hashPath(c.seed, path)
+	shard := c.shard(hash)
+	var entry *valueCacheEntry
+	shard.mu.RLock()
+	if i, found := shard.index[hash]; found {
+		entry = shard.entries[i]
+	}
+	shard.mu.RUnlock()
+	// Different paths can have the same hash.
+	if entry == nil || !slices.Equal(entry.path, path) {
+		c.misses.Add(1)
+		return
+	}
+	if !entry.referenced.Load() {
+		entry.referenced.Store(true)
+	}
+	c.hits.Add(1)
+	return entry.value, hash, true
+}
+
+// valueSize returns the estimated memory of a decoded value.
+func valueSize(v any) int {
+	switch v := v.(type) {
+	case string:
+		return len(v)
+	case []byte:
+		return len(v)
+	case impl.GobValue:
+		return len(v)
+	default:
+		return 8
+	}
+}
+
+// put caches v as the value of path whose hash is hash.
+// Values larger than a shard are not cached.
+func (c *valueCache) put(path []string, hash uint64, v any) {
+	size := valueCacheEntryOverhead + valueSize(v) + len(path)*16
+	for _, key := range path {
+		size += len(key)
+	}
+	shard := c.shard(hash)
+	if size > shard.maxBytes {
+		return
+	}
+	entry := &valueCacheEntry{hash: hash, path: slices.Clone(path), value: v, size: size}
+
+	shard.mu.Lock()
+	defer shard.mu.Unlock()
+	if i, ok := shard.index[hash]; ok {
+		shard.remove(i)
+	}
+	for shard.bytes+size > shard.maxBytes {
+		shard.evict()
+	}
+	var i int
+	if n := len(shard.free); n > 0 {
+		i, shard.free = shard.free[n-1], shard.free[:n-1]
+		shard.entries[i] = entry
+	} else {
+		i = len(shard.entries)
+		shard.entries = append(shard.entries, entry)
+	}
+	shard.index[hash] = i
+	shard.bytes += size
+}
+
+// remove removes the ith entry.
+func (shard *valueCacheShard) remove(i int) {
+	entry := shard.entries[i]
+	delete(shard.index, entry.hash)
+	shard.entries[i] = nil
+	shard.free = append(shard.free, i)
+	shard.bytes -= entry.size
+}
+
+// evict removes the first unreferenced entry from the hand,
+// and clears the referenced bits of the entries on the way.
+func (shard *valueCacheShard) evict() {
+	for {
+		if shard.hand >= len(shard.entries) {
+			shard.hand = 0
+		}
+		i := shard.hand
+		shard.hand++
+		entry := shard.entries[i]
+		if entry == nil {
+			continue
+		}
+		if entry.referenced.Load() {
+			entry.referenced.Store(false)
+			continue
+		}
+		shard.remove(i)
+		return
+	}
+}
+
+func (c *valueCache) stats() CacheStats {
+	stats := CacheStats{Hits: c.hits.Load(), Misses: c.misses.Load()}
+	for i := range c.shards {
+		shard := &c.shards[i]
+		shard.mu.RLock()
+		stats.Entries += len(shard.index)
+		shard.mu.RUnlock()
+	}
+	return stats
+}